@@ -41,6 +41,20 @@ typedef struct {
 // --+ library +----------------------------------------------------------------
 /** Data tree name used by various programs. */
 #define RGE_TREENAMEDATA "data"
+/** Tree name of the pi0 candidates written by make_ntuples. */
+#define RGE_TREENAMEPI0  "pi0"
+/**
+ * Friend tree of the data tree with the derived kinematics written by
+ *     make_ntuples, one entry per data entry. Readers attach it with
+ *     rge_attach_kinematics().
+ */
+#define RGE_TREENAMEKIN  "kinematics"
+/**
+ * Branch with the exact event number, stored next to the Float_t N_{event}
+ *     variable in the data and pi0 trees. Float_t only holds integers exactly
+ *     up to 2^24, so readers should prefer this branch when a file has it.
+ */
+#define RGE_EVENTNO64    "evn64"
 
 /** Detector constants. */
 #define RGE_NSECTORS     6 /** # of CLAS12 sectors. */
@@ -111,4 +125,52 @@ const RGE_VAR RGE_PL2     = {.addr = 33, .name = "p_{L}^{2} (GeV^{2})"};
 const RGE_VAR RGE_PHIPQ   = {.addr = 34, .name = "#phi_{PQ} (rad)"};
 const RGE_VAR RGE_THETAPQ = {.addr = 35, .name = "#theta_{PQ} (rad)"};
 
+/**
+ * Addresses in RGE_VARS of the variables stored in the data tree (primary) and
+ *     in the kinematics friend tree (derived). Derived variables only depend
+ *     on the primary ones and the beam energy, so `make_ntuples -R` can
+ *     recompute them without going back to the banks.
+ */
+#define RGE_PRIMVARS_SIZE 25
+extern const int RGE_PRIMVARS[RGE_PRIMVARS_SIZE];
+#define RGE_KINVARS_SIZE  11
+extern const int RGE_KINVARS[RGE_KINVARS_SIZE];
+
+/** pi0 variable array data. */
+#define RGE_PI0VARS_SIZE 23
+extern const char *RGE_PI0VARS[RGE_PI0VARS_SIZE];
+
+/** pi0 metadata variables. */
+const RGE_VAR RGE_PI0_RUNNO   = {.addr = 0, .name = "N_{run}"};
+const RGE_VAR RGE_PI0_EVENTNO = {.addr = 1, .name = "N_{event}"};
+const RGE_VAR RGE_PI0_BEAME   = {.addr = 2, .name = "E_{beam}"};
+
+/** pi0 diphoton variables. */
+const RGE_VAR RGE_PI0_E1    = {.addr =  3, .name = "E_{#gamma1} (GeV)"};
+const RGE_VAR RGE_PI0_E2    = {.addr =  4, .name = "E_{#gamma2} (GeV)"};
+const RGE_VAR RGE_PI0_OPENA = {
+        .addr = 5, .name = "#theta_{#gamma#gamma} (rad)"
+};
+const RGE_VAR RGE_PI0_MGG   = {.addr =  6, .name = "M_{#gamma#gamma} (GeV)"};
+const RGE_VAR RGE_PI0_PX    = {.addr =  7, .name = "p_{x} (GeV)"};
+const RGE_VAR RGE_PI0_PY    = {.addr =  8, .name = "p_{y} (GeV)"};
+const RGE_VAR RGE_PI0_PZ    = {.addr =  9, .name = "p_{z} (GeV)"};
+const RGE_VAR RGE_PI0_P     = {.addr = 10, .name = "p (GeV)"};
+const RGE_VAR RGE_PI0_THETA = {.addr = 11, .name = "#theta (rad)"};
+const RGE_VAR RGE_PI0_PHI   = {.addr = 12, .name = "#phi (rad)"};
+
+/** pi0 DIS variables, from the trigger electron. */
+const RGE_VAR RGE_PI0_Q2 = {.addr = 13, .name = "Q^{2} (GeV^{2})"};
+const RGE_VAR RGE_PI0_NU = {.addr = 14, .name = "#nu (GeV)"};
+const RGE_VAR RGE_PI0_XB = {.addr = 15, .name = "x_{bjorken}"};
+const RGE_VAR RGE_PI0_YB = {.addr = 16, .name = "y_{bjorken}"};
+const RGE_VAR RGE_PI0_W2 = {.addr = 17, .name = "W^{2} (GeV^{2})"};
+
+/** pi0 SIDIS variables, treating the photon pair as a single hadron. */
+const RGE_VAR RGE_PI0_ZH      = {.addr = 18, .name = "z_{h}"};
+const RGE_VAR RGE_PI0_PT2     = {.addr = 19, .name = "p_{T}^{2} (GeV^{2})"};
+const RGE_VAR RGE_PI0_PL2     = {.addr = 20, .name = "p_{L}^{2} (GeV^{2})"};
+const RGE_VAR RGE_PI0_PHIPQ   = {.addr = 21, .name = "#phi_{PQ} (rad)"};
+const RGE_VAR RGE_PI0_THETAPQ = {.addr = 22, .name = "#theta_{PQ} (rad)"};
+
 #endif
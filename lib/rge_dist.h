@@ -0,0 +1,145 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#ifndef RGE_DIST
+#define RGE_DIST
+
+// --+ preamble +---------------------------------------------------------------
+// C.
+#include <limits.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// C++.
+#include <vector>
+
+// ROOT.
+#include <TH1.h>
+
+// MPI.
+#ifdef RGE_MPI
+#include <mpi.h>
+#endif
+
+// rge-analysis.
+#include "rge_err_handler.h"
+#include "rge_metadata.h"
+
+// typedefs.
+typedef unsigned int uint;
+typedef long unsigned int luint;
+typedef long int lint;
+
+/**
+ * Distribution of work across processes. When compiled with RGE_MPI (make
+ *     MPI=1), programs started with `mpirun -np N` split their input into N
+ *     contiguous shards, one per rank, and reduce their partial outputs at rank
+ *     0. Without RGE_MPI, every function in this module behaves as if there was
+ *     a single process of rank 0, so programs run exactly as before.
+ */
+
+// --+ internal +---------------------------------------------------------------
+/**
+ * Maximum number of elements sent in one MPI call, since MPI counts are ints.
+ *     Larger arrays are sent in chunks.
+ */
+static const luint DIST_CHUNK = INT_MAX / 2;
+
+#ifdef RGE_MPI
+/**
+ * Sum arr element-wise across ranks at rank 0, in chunks of DIST_CHUNK
+ *     elements. type is the MPI datatype of arr, and width its size in bytes.
+ */
+static int reduce_sum(void *arr, luint size, MPI_Datatype type, luint width);
+#endif
+
+// --+ library +----------------------------------------------------------------
+/**
+ * Initialize the distribution backend. Should be called at the start of main.
+ *     stdout is silenced in all ranks but rank 0, so that messages and the
+ *     progress bar are only printed once.
+ */
+int rge_dist_init(int *argc, char ***argv);
+
+/**
+ * Finalize the distribution backend. Should be called at the end of main. If
+ *     err is not 0 and there is more than one process, all processes are
+ *     aborted, since some of them might be waiting on a collective call.
+ *
+ * @param err : error code returned by the program.
+ * @return    : err.
+ */
+int rge_dist_finalize(int err);
+
+/** Return rank of this process. */
+int rge_dist_rank();
+
+/** Return number of processes. */
+int rge_dist_size();
+
+/**
+ * Get the shard of entries [first, last) processed by this rank when splitting
+ *     nentries in contiguous shards of approximately equal size.
+ */
+int rge_dist_shard(lint nentries, lint *first, lint *last);
+
+/** Block until all ranks reach this call. */
+int rge_dist_barrier();
+
+/** Broadcast x from rank 0 to all ranks. */
+int rge_dist_bcast(long *x);
+int rge_dist_bcast(double *x);
+
+/** Sum arr element-wise across ranks. Only rank 0 receives the result. */
+int rge_dist_reduce_sum(int *arr, luint size);
+int rge_dist_reduce_sum(lint *arr, luint size);
+int rge_dist_reduce_sum(double *arr, luint size);
+
+/** Get the maximum of x across ranks. All ranks receive the result. */
+int rge_dist_allreduce_max(luint *x);
+
+/** Apply a logical or to arr element-wise across ranks, in all ranks. */
+int rge_dist_allreduce_lor(bool *arr, luint size);
+
+/**
+ * Gather arrays of the same size from all ranks, ordered by rank.
+ *
+ * @param send : array of size size to be sent.
+ * @param size : number of elements sent by each rank.
+ * @param recv : array of size size*rge_dist_size() where data is received.
+ * @return     : success code (0).
+ */
+int rge_dist_allgather(double *send, luint size, double *recv);
+
+/**
+ * Add histogram h across ranks, including its errors and statistics. Only rank
+ *     0 receives the result.
+ */
+int rge_dist_reduce_hist(TH1 *h);
+
+/**
+ * Write the name of the partial file written by this rank to part_filename.
+ *     If there is a single process, filename itself is used.
+ */
+int rge_dist_part_filename(const char *filename, char *part_filename);
+
+/**
+ * Merge the partial files written by every rank into filename at rank 0,
+ *     following the rank order, and remove them. Metadata is merged with
+ *     rge_merge_metadata(). Does nothing if there is a single process.
+ */
+int rge_dist_gather_files(const char *filename);
+
+#endif
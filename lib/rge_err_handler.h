@@ -73,6 +73,15 @@ int rge_print_usage(const char *msg);
 #define RGEERR_INVALIDPID               18
 #define RGEERR_TOOMANYNUMBERS           19
 #define RGEERR_BADBINNING               20
+#define RGEERR_INVALIDNTHREADS          21
+#define RGEERR_INVALIDNREPS             22
+#define RGEERR_NOCOMMAND                23
+#define RGEERR_INVALIDNSLOW             24
+#define RGEERR_NOTRACING                25
+#define RGEERR_INVALIDTRACEOPT          26
+#define RGEERR_BADTARGETRANGE           27
+#define RGEERR_BADSELECTIONS            28
+#define RGEERR_INVALIDPERIOD            29
 // --+  50 -  99 file errors +--------------------------------------------------
 #define RGEERR_NOINPUTFILE              50
 #define RGEERR_NOSAMPFRACFILE           51
@@ -92,11 +101,23 @@ int rge_print_usage(const char *msg);
 #define RGEERR_OUTFILEEXISTS            65
 #define RGEERR_OUTPUTROOTFAILED         66
 #define RGEERR_OUTPUTTEXTFAILED         67
+#define RGEERR_NOOUTPUTFILE             68
+#define RGEERR_MERGEFAILED              69
+#define RGEERR_RUNMISMATCH              70
+#define RGEERR_OUTPUTTRACEFAILED        71
+#define RGEERR_BADTRACEFILE             72
+#define RGEERR_NOPHIPQGRID              73
+#define RGEERR_STAGINGFAILED            74
+#define RGEERR_NOWATCHDIR               75
+#define RGEERR_BADKINTREE               76
+#define RGEERR_UNSPLITNTUPLES           77
+#define RGEERR_NOPCALCOORDS             78
 // --+ 100 - 149 detector errors +----------------------------------------------
 #define RGEERR_INVALIDCALLAYER         100
 #define RGEERR_INVALIDCALSECTOR        101
 #define RGEERR_INVALIDCHERENKOVID      102
 #define RGEERR_NOFMTBANK               103
+#define RGEERR_INVALIDTRKSECTOR        104
 // --+ 150 - 199 program errors +-----------------------------------------------
 #define RGEERR_UNIMPLEMENTEDBEAMENERGY 150
 #define RGEERR_2DACCEPTANCEPLOT        151
@@ -105,6 +126,10 @@ int rge_print_usage(const char *msg);
 #define RGEERR_UNSUPPORTEDTYPE         154
 #define RGEERR_INVALIDENTRY            155
 #define RGEERR_WRONGENTRYTYPE          156
+#define RGEERR_BADGRIDDIMS             157
+#define RGEERR_COMMANDFAILED           158
+#define RGEERR_EVENTNOTINBATCH         159
+#define RGEERR_BADROUNDTRIP            160
 // --+ 200 - 249 particle errors +----------------------------------------------
 #define RGEERR_PIDNOTFOUND             201
 #define RGEERR_UNSUPPORTEDPID          202
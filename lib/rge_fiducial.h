@@ -0,0 +1,129 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#ifndef RGE_FIDUCIAL
+#define RGE_FIDUCIAL
+
+// --+ preamble +---------------------------------------------------------------
+// C.
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// rge-analysis.
+#include "rge_constants.h"
+#include "rge_err_handler.h"
+
+// typedefs.
+typedef unsigned int uint;
+typedef long unsigned int luint;
+typedef long int lint;
+
+/**
+ * Fiducial cuts for CLAS12's forward detector. DC cuts are defined as a polygon
+ *     in each sector's local (theta, phi) plane, and PCAL cuts as the minimum
+ *     distance to the edges of the lv and lw views. rge_fiducial_init()
+ *     rasterizes each sector's polygon into a bitmap, so applying the cut to a
+ *     particle costs a single table lookup instead of a point-in-polygon test.
+ */
+
+// --+ structs +----------------------------------------------------------------
+/** Number of raster cells in theta and in sector-local phi. */
+#define RGE_FIDNTHETA 256
+#define RGE_FIDNPHI   256
+
+/**
+ * Precomputed fiducial cut maps.
+ *
+ * @param dc_map      : per-sector rasterized DC fiducial region. Bit j of
+ *                      dc_map[s][i][j/64] is set if cell (theta_i, phi_j) of
+ *                      sector s+1 is inside the region.
+ * @param pcal_lv_min : per-sector minimum lv (cm) allowed in PCAL.
+ * @param pcal_lw_min : per-sector minimum lw (cm) allowed in PCAL.
+ */
+typedef struct {
+    uint64_t dc_map[RGE_NSECTORS][RGE_FIDNTHETA][RGE_FIDNPHI/64];
+    double pcal_lv_min[RGE_NSECTORS];
+    double pcal_lw_min[RGE_NSECTORS];
+} rge_fiducial;
+
+// --+ internal +---------------------------------------------------------------
+/** Raster limits (degrees). Particles outside of them fail the DC cut. */
+static const double FID_THETAMIN =   0.;
+static const double FID_THETAMAX =  45.;
+static const double FID_PHIMIN   = -30.;
+static const double FID_PHIMAX   =  30.;
+
+/**
+ * Loose DC fiducial polygon, given as (theta, phi) vertices in degrees in the
+ *     sector's local frame. The allowed phi range narrows at low theta, where
+ *     the torus coils shadow the edges of each sector. Used for all sectors.
+ */
+static const luint  FID_DCNVERTICES = 8;
+static const double FID_DCPOLYGON[FID_DCNVERTICES][2] = {
+        { 5., -8.}, { 8., -18.}, {15., -24.}, {40., -27.},
+        {40., 27.}, {15.,  24.}, { 8.,  18.}, { 5.,   8.}
+};
+
+/** Loose PCAL cut. Minimum lv and lw (cm) allowed, used for all sectors. */
+static const double FID_PCALLVMIN = 9.;
+static const double FID_PCALLWMIN = 9.;
+
+/**
+ * Check if point (x, y) is inside polygon poly of nvertices vertices, using
+ *     the even-odd rule.
+ */
+static bool point_in_polygon(
+        double x, double y, const double poly[][2], luint nvertices
+);
+
+// --+ library +----------------------------------------------------------------
+/**
+ * Build the fiducial cut maps. This is the only costly step, and should be
+ *     done once before looping through events.
+ *
+ * @param fid : pointer to the rge_fiducial struct to be filled.
+ * @return    : error code, always 0.
+ */
+int rge_fiducial_init(rge_fiducial *fid);
+
+/**
+ * Apply DC fiducial cut on a particle.
+ *
+ * @param fid        : pointer to an initialized rge_fiducial struct.
+ * @param sector     : CLAS12 sector where the particle was tracked.
+ * @param px, py, pz : momentum of the particle.
+ * @return           : 0 if particle passes the cut, 1 otherwise, 2 if sector
+ *                     is invalid.
+ */
+int rge_apply_dc_fiducial_cut(
+        rge_fiducial *fid, int sector, double px, double py, double pz
+);
+
+/**
+ * Apply PCAL fiducial cut on a particle.
+ *
+ * @param fid    : pointer to an initialized rge_fiducial struct.
+ * @param sector : CLAS12 sector of the PCAL hit.
+ * @param lv, lw : distance (cm) of the PCAL hit to the edges of the v and w
+ *                 views.
+ * @return       : 0 if particle passes the cut, 1 otherwise, 2 if sector is
+ *                 invalid.
+ */
+int rge_apply_pcal_fiducial_cut(
+        rge_fiducial *fid, int sector, double lv, double lw
+);
+
+#endif
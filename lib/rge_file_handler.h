@@ -19,11 +19,16 @@
 // --+ preamble +---------------------------------------------------------------
 // C.
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+// C++.
+#include <vector>
+
 // rge-analysis.
 #include "rge_constants.h"
 #include "rge_err_handler.h"
+#include "rge_shm_cache.h"
 
 // typedefs.
 typedef unsigned int uint;
@@ -63,8 +68,35 @@ static int get_bin_edges(
  * @return          : success code (0).
  */
 static int get_acc_corr(
-        FILE *file_in, luint pids_size, luint nbins, lint *pids, int **n_thrown,
-        int **n_simul
+        FILE *file_in, luint pids_size, luint nbins, lint *pids,
+        lint **n_thrown, lint **n_simul
+);
+
+/**
+ * Point the acceptance correction arrays to a payload cached in shared memory
+ *     by acc_corr_to_shm(). Only the outermost arrays are allocated, the rest
+ *     is read-only and shared with other processes.
+ *
+ * @param payload : payload returned by rge_shm_attach().
+ * @return        : success code (0).
+ */
+static int acc_corr_from_shm(
+        const void *payload, luint *bin_nedges, double ***bin_edges,
+        luint *pids_size, luint *nbins, lint **pids, lint ***n_thrown,
+        lint ***n_simul
+);
+
+/**
+ * Serialize acceptance correction data and publish it in shared memory. The
+ *     payload layout is: bin_nedges[5], pids_size, nbins, all bin edges, pids,
+ *     and then n_thrown and n_simul for each PID.
+ *
+ * @return : success code of rge_shm_publish().
+ */
+static int acc_corr_to_shm(
+        char *acc_filename, luint *bin_nedges, double **bin_edges,
+        luint pids_size, luint nbins, lint *pids, lint **n_thrown,
+        lint **n_simul
 );
 
 // --+ library +----------------------------------------------------------------
@@ -78,6 +110,8 @@ static int get_acc_corr(
  * @return         : error code:
  *                     * 0: everything went fine.
  *                     * 1: no file with filename was found.
+ *
+ * If the shared-memory cache is enabled, parameters are read from it instead.
  */
 int rge_get_sf_params(
         char *filename, double sf[RGE_NSECTORS][RGE_NSFPARAMS][2]
@@ -108,11 +142,21 @@ int rge_get_sf_params(
  * @return             : error code:
  *                         * 0: Function performed correctly.
  *                         * 1: Failed to access acceptance correction file.
+ *
+ * If the shared-memory cache is enabled, the arrays point to a read-only
+ *     segment shared with other processes. They should be freed with
+ *     rge_free_acc_corr() in either case.
  */
 int rge_read_acc_corr_file(
         char *acc_filename, luint bin_nedges[5], double ***bin_edges,
-        luint *pids_size, luint *nbins, lint **pids, int ***n_thrown,
-        int ***n_simul
+        luint *pids_size, luint *nbins, lint **pids, lint ***n_thrown,
+        lint ***n_simul
+);
+
+/** Free the arrays filled by rge_read_acc_corr_file(). */
+int rge_free_acc_corr(
+        double **bin_edges, luint pids_size, lint *pids, lint **n_thrown,
+        lint **n_simul
 );
 
 #endif
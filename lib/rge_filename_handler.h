@@ -98,6 +98,12 @@ int rge_handle_root_filename(char *filename, int *run_no, double *beam_energy);
  */
 int rge_handle_root_filename(char *filename, int *run_no);
 
+/**
+ * Get the beam energy of run run_no, as defined in the constants. Used to
+ *     recompute kinematics from the run number stored in ntuples files.
+ */
+int rge_get_beam_energy(int run_no, double *beam_energy);
+
 /**
  * Handle a hipo filename, checking its validity, file existence, and grabbing
  *     the run number from it.
@@ -0,0 +1,77 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#ifndef RGE_GRIDUTILS
+#define RGE_GRIDUTILS
+
+// --+ preamble +---------------------------------------------------------------
+// ROOT.
+#include <TH1.h>
+#include <THnSparse.h>
+
+// rge-analysis.
+#include "rge_constants.h"
+#include "rge_err_handler.h"
+
+// typedefs.
+typedef unsigned int uint;
+typedef long unsigned int luint;
+typedef long int lint;
+
+// --+ internal +---------------------------------------------------------------
+/**
+ * Copy the bin edges of axis ax into edges. Array edges must be of size
+ *     ax->GetNbins() + 1.
+ */
+static int get_axis_edges(TAxis *ax, double *edges);
+
+// --+ library +----------------------------------------------------------------
+/**
+ * Pack an array of equally-binned histograms, one per cell of a binning grid,
+ *     into a single THnSparse. The first dim_bins axes of the output are the
+ *     binning variables and the last one or two are the axes of the plots. The
+ *     array is expected to follow the order given by rge_find_idx(),
+ *     where the last binning variable runs fastest.
+ *
+ * @param name      : name of the output THnSparse.
+ * @param title     : title of the output THnSparse.
+ * @param plot_arr  : array of histograms to pack.
+ * @param dim_bins  : number of binning variables.
+ * @param bin_vars  : array with the RGE_VARS index of each binning variable.
+ * @param bin_nbins : array with number of bins for each binning variable.
+ * @param bin_range : 2-dimensional array with lower and upper limits for each
+ *                    binning variable.
+ * @return          : pointer to the new THnSparse. The caller owns it.
+ */
+THnSparse *rge_grid_pack(
+        const char *name, const char *title, TH1 *plot_arr[], luint dim_bins,
+        int bin_vars[], luint bin_nbins[], double bin_range[][2]
+);
+
+/**
+ * Get the plot associated to one cell of a binning grid generated by
+ *     rge_grid_pack().
+ *
+ * @param grid     : THnSparse generated by rge_grid_pack().
+ * @param dim_bins : number of binning variables in grid.
+ * @param bin_idx  : array of size dim_bins with the index of the bin for each
+ *                   binning variable, starting from 0.
+ * @return         : a TH1D or a TH2D, depending on the dimension of the packed
+ *                   plots. The caller owns it. Returns NULL and sets rge_errno
+ *                   if dim_bins or bin_idx don't match the grid.
+ */
+TH1 *rge_grid_project(THnSparse *grid, luint dim_bins, luint bin_idx[]);
+
+#endif
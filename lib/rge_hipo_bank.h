@@ -22,6 +22,7 @@
 
 // C++.
 #include <map>
+#include <stdexcept>
 #include <vector>
 
 // ROOT.
@@ -46,6 +47,9 @@ typedef long int lint;
 #define RGE_RECSCINTILLATOR "REC::Scintillator"
 #define RGE_FMTTRACKS       "FMT::Tracks"
 
+/** Number of events read per batch by programs using rge_get_batch(). */
+#define RGE_BATCHNEVENTS 1024
+
 /** ECAL layer IDs in CLAS12 banks. */
 #define PCAL_LYR 1
 #define ECIN_LYR 4
@@ -75,10 +79,37 @@ typedef struct {
     uint type;
 } rge_hipoentry;
 
-/** Struct containing a map of all entries associated to a hipo bank. */
+/**
+ * Contiguous range of events of one hipo bank, stored as flat columns. Rows of
+ *     the i-th event of the batch are rows offsets[i] to offsets[i+1] (not
+ *     included) of every column.
+ *
+ * @param first   : first entry of the batch.
+ * @param nevents : number of events in the batch.
+ * @param offsets : first row of each event, of size nevents+1.
+ * @param columns : data of each entry of the bank, with the same keys.
+ */
+typedef struct {
+    lint first, nevents;
+    std::vector<luint> offsets;
+    std::map<const char *, std::vector<double>, cmp_str> columns;
+} rge_hipobatch;
+
+/**
+ * Struct containing a map of all entries associated to a hipo bank.
+ *
+ * @param nrows   : number of rows of the current event.
+ * @param entries : entries of the bank.
+ * @param batch   : batch holding the current event, set by
+ *                  rge_select_event(). NULL if the current event is in the
+ *                  data vectors of entries.
+ * @param offset  : first row of the current event in the columns of batch.
+ */
 typedef struct {
     luint nrows;
     std::map<const char *, rge_hipoentry, cmp_str> entries;
+    const rge_hipobatch *batch;
+    luint offset;
 } rge_hipobank;
 
 // --+ internal +---------------------------------------------------------------
@@ -88,8 +119,12 @@ static const uint SHORT = 1;
 static const uint INT   = 2;
 static const uint FLOAT = 3;
 
-/** Internal iterator used to loop through entries. */
-static std::map<const char *, rge_hipoentry, cmp_str>::const_iterator it;
+/**
+ * Iterator type used to loop through entries. Iterators are declared locally
+ *     in each loop so that different threads can use different banks.
+ */
+typedef std::map<const char *, rge_hipoentry, cmp_str>::const_iterator
+        entry_iterator;
 
 /**
  * Initialize and return one rge_hipoentry. Parameters addr and type are
@@ -98,7 +133,7 @@ static std::map<const char *, rge_hipoentry, cmp_str>::const_iterator it;
  */
 static rge_hipoentry entry_init(const char *in_addr, uint in_type);
 
-/** Set b.nrows to in_rows. */
+/** Set b.nrows to in_rows, and detach b from any batch. */
 static int set_nrows(rge_hipobank *b, luint in_nrows);
 
 /** Get entry number idx with name var from bank b. */
@@ -108,7 +143,12 @@ static double get_entry(rge_hipobank *b, const char *var, luint idx);
 /** Initialize rge_hipobank based on static map related to bank_version. */
 rge_hipobank rge_hipobank_init(const char *bank_version);
 
-/** Initialize rge_hipobank and set branch addresses to t's branches. */
+/**
+ * Initialize rge_hipobank and set branch addresses to t's branches. Entries
+ *     without a branch in t are removed from the bank, so that files written
+ *     before an entry was added can still be read. Accessing them sets
+ *     RGEERR_INVALIDENTRY.
+ */
 rge_hipobank rge_hipobank_init(const char *bank_version, TTree *t);
 
 /** Link branches of t to entries of b. */
@@ -118,7 +158,36 @@ int rge_link_branches(rge_hipobank *b, TTree *t);
 int rge_fill(rge_hipobank *rb, hipo::bank hb);
 
 /** Read entries from t into b. */
-int rge_get_entries(rge_hipobank *b, TTree *t, int idx);
+int rge_get_entries(rge_hipobank *b, TTree *t, lint idx);
+
+/** Initialize an empty rge_hipobatch. */
+rge_hipobatch rge_hipobatch_init();
+
+/**
+ * Read nevents entries of b from t, starting at first, into batch. Each branch
+ *     is read through the whole range before moving to the next one, so that
+ *     it stays on the same baskets. Memory held by batch is reused. Entries
+ *     are still read one by one, since ROOT has no bulk reads of vector
+ *     branches. Run `make bench` to compare against rge_get_entries().
+ */
+int rge_get_batch(
+        rge_hipobank *b, TTree *t, lint first, lint nevents,
+        rge_hipobatch *batch
+);
+
+/**
+ * Point b to the rows of entry idx in batch, so that the rge_get_* functions
+ *     read them from its columns as if read by rge_get_entries(). Nothing is
+ *     copied, so batch must outlive the use of b, until the next call to
+ *     rge_get_entries() or rge_fill().
+ */
+int rge_select_event(rge_hipobank *b, rge_hipobatch *batch, lint idx);
+
+/**
+ * Return the compressed size in bytes of the branches linked to b, summed over
+ *     all their entries. Entries without a branch are ignored.
+ */
+lint rge_get_zipbytes(rge_hipobank *b);
 
 /** Get entry number idx with name var from bank b as a double. */
 double rge_get_double(rge_hipobank *b, const char *var, luint idx);
@@ -23,6 +23,7 @@
 #include <string.h>
 
 // rge-analysis.
+#include "rge_dist.h"
 #include "rge_err_handler.h"
 #include "rge_file_handler.h"
 
@@ -86,13 +87,32 @@ int rge_grab_multiarg(
 /** Run strtol on arg to get number of entries. */
 int rge_process_nentries(lint *nentries, char *arg);
 
+/** Run strtol on arg to get number of threads. */
+int rge_process_nthreads(lint *nthreads, char *arg);
+
+/** Run strtol on arg to get number of repetitions. */
+int rge_process_nreps(lint *nreps, char *arg);
+
+/** Run strtol on arg to get a positive period in seconds. */
+int rge_process_period(lint *period, char *arg);
+
+/** Run strtol on arg to get number of slowest events to log. */
+int rge_process_nslow(lint *nslow, char *arg);
+
+/** Run strtol on arg to get a non-negative event number for tracing. */
+int rge_process_evn(lint *evn, char *arg);
+
 /** Run strtol on arg to get PID. */
 int rge_process_pid(lint *pid, char *arg);
 
 /** Run strtol on arg to get number of FMT layers required. */
 int rge_process_fmtnlayers(lint *nlayers, char *arg);
 
-/** Catch a y (yes) or a n (no) from stdin. */
+/**
+ * Catch a y (yes) or a n (no) from stdin. Like all rge_catch_*() functions,
+ *     stdin is only read by rank 0, which broadcasts the answer to every other
+ *     rank.
+ */
 bool rge_catch_yn();
 
 /** Catch a long value from stdin. */
@@ -0,0 +1,99 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#ifndef RGE_KERNELS
+#define RGE_KERNELS
+
+// --+ preamble +---------------------------------------------------------------
+// rge-analysis.
+#include "rge_constants.h"
+
+// typedefs.
+typedef unsigned int uint;
+typedef long unsigned int luint;
+typedef long int lint;
+
+/**
+ * Kernels for ROOT macros and RDataFrame. These wrap the PID, DIS, and SIDIS
+ *     computations of rge_particle and the cuts of draw_plots in functions of
+ *     plain numbers, so that they can be passed directly to Define() and
+ *     Filter(). The DIS and SIDIS kernels only read constant tables and
+ *     their arguments, so they can be called concurrently with ROOT's
+ *     implicit multi-threading. rge_kernel_pid() sets rge_errno if
+ *     rge_set_pid() fails, in which case it returns 0 and rge_errno shouldn't
+ *     be relied upon when running multi-threaded. This header only depends on
+ *     rge_constants.h, so it can be included from the interpreter after
+ *     loading bin/librge.so (built by `make`). See macros/rdf_plots.C.
+ */
+
+// --+ structs +----------------------------------------------------------------
+/** DIS variables of a trigger electron, as stored in the ntuples. */
+typedef struct {
+    double Q2, nu, Xb, Yb, W2;
+} rge_dis;
+
+/** SIDIS variables of a hadron wrt the virtual photon, as in the ntuples. */
+typedef struct {
+    double zh, Pt2, Pl2, phiPQ, thetaPQ;
+} rge_sidis;
+
+// --+ library +----------------------------------------------------------------
+/**
+ * Assign PID to a particle, as done by make_ntuples.
+ *
+ * @param charge       : charge of the particle.
+ * @param recon_pid    : PID defined by the EB engine.
+ * @param status       : status variable from REC::Particle.
+ * @param beta         : beta of the particle.
+ * @param px           : x momentum of the particle.
+ * @param py           : y momentum of the particle.
+ * @param pz           : z momentum of the particle.
+ * @param total_energy : Total deposited energy in ECIN, ECOU, and PCAL.
+ * @param pcal_energy  : Deposited energy in PCAL.
+ * @param htcc_nphe    : Number of photoelectrons generated in HTCC.
+ * @param ltcc_nphe    : Number of photoelectrons generated in LTCC.
+ * @param sf_params    : sampling fraction parameters of the particle's sector.
+ * @return             : assigned PID, or 0 if none matched.
+ */
+int rge_kernel_pid(
+        int charge, int recon_pid, int status, double beta, double px,
+        double py, double pz, double total_energy, double pcal_energy,
+        int htcc_nphe, int ltcc_nphe,
+        const double sf_params[RGE_NSFPARAMS][2]
+);
+
+/** Compute the DIS variables of a trigger electron of momentum (px,py,pz). */
+rge_dis rge_kernel_dis(double beam_E, double px, double py, double pz);
+
+/**
+ * Compute the SIDIS variables of a hadron of mass mass and momentum
+ *     (px, py, pz), wrt the virtual photon of a trigger electron of momentum
+ *     (e_px, e_py, e_pz).
+ */
+rge_sidis rge_kernel_sidis(
+        double beam_E, double e_px, double e_py, double e_pz, double mass,
+        double px, double py, double pz
+);
+
+/** Return true if a trigger electron passes draw_plots' DIS cuts. */
+bool rge_kernel_dis_cut(double Q2, double W2, double Yb);
+
+/** Return true if a particle's vertex passes draw_plots' geometry cuts. */
+bool rge_kernel_geometry_cut(double vx, double vy, double vz);
+
+/** Return true if a particle passes draw_plots' general cuts. */
+bool rge_kernel_general_cut(double pid, double chi2, double ndf);
+
+#endif
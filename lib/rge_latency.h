@@ -0,0 +1,142 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#ifndef RGE_LATENCY
+#define RGE_LATENCY
+
+// --+ preamble +---------------------------------------------------------------
+// C.
+#include <math.h>
+#include <stdio.h>
+
+// C++.
+#include <algorithm>
+#include <vector>
+
+// rge-analysis.
+#include "rge_dist.h"
+
+// typedefs.
+typedef unsigned int uint;
+typedef long unsigned int luint;
+typedef long int lint;
+
+/**
+ * Per-event latency instrumentation. Processing times are counted in a
+ *     histogram with logarithmic bins, and the K slowest events are kept in a
+ *     min-heap together with the number of rows in the banks they read, so that
+ *     pathological inputs can be found after a run. Each thread keeps its own
+ *     rge_latency, and they are combined at the end with rge_latency_merge().
+ */
+
+// --+ structs +----------------------------------------------------------------
+/** Number of banks whose sizes are logged for each slow event. */
+#define RGE_LATENCYNBANKS 5
+
+/** Number of histogram bins per decade, and number of decades from 1 us. */
+#define RGE_LATENCYBINSPERDECADE 4
+#define RGE_LATENCYNDECADES      7
+#define RGE_LATENCYNBINS (RGE_LATENCYBINSPERDECADE * RGE_LATENCYNDECADES + 2)
+
+/**
+ * An event logged as one of the slowest.
+ *
+ * @param time  : processing time (s).
+ * @param evn   : event number.
+ * @param nrows : number of rows in each of the banks read by the event.
+ */
+typedef struct {
+    double time;
+    lint evn;
+    luint nrows[RGE_LATENCYNBANKS];
+} rge_slowevent;
+
+/**
+ * Latency distribution of a set of events.
+ *
+ * @param k          : number of slowest events kept. 0 disables the log.
+ * @param nevents    : number of events recorded.
+ * @param total_time : sum of the processing times of all events (s).
+ * @param counts     : histogram of processing times. Bin 0 is the underflow
+ *                     (below 1 us), and the last bin is the overflow.
+ * @param slowest    : min-heap with the k slowest events.
+ */
+typedef struct {
+    luint k;
+    lint nevents;
+    double total_time;
+    lint counts[RGE_LATENCYNBINS];
+    std::vector<rge_slowevent> slowest;
+} rge_latency;
+
+// --+ internal +---------------------------------------------------------------
+/** Lower edge of the histogram (s). */
+static const double LATENCY_MINTIME = 1e-6;
+
+/** Number of doubles used to send one rge_slowevent across ranks. */
+static const luint LATENCY_PACKSIZE = 2 + RGE_LATENCYNBANKS;
+
+/** Order slow events so that the fastest is at the top of the heap. */
+static bool slower(const rge_slowevent &a, const rge_slowevent &b);
+
+/** Find the histogram bin of a processing time t (s). */
+static uint find_bin(double t);
+
+/** Get the lower edge of histogram bin b (s). */
+static double bin_low_edge(uint b);
+
+/** Push an event into the heap of lat, keeping only the k slowest. */
+static int push_event(rge_latency *lat, rge_slowevent ev);
+
+// --+ library +----------------------------------------------------------------
+/** Initialize an empty rge_latency, keeping the k slowest events. */
+rge_latency rge_latency_init(luint k);
+
+/**
+ * Record the processing time of one event.
+ *
+ * @param lat   : rge_latency where the event is recorded.
+ * @param time  : processing time of the event (s).
+ * @param evn   : event number.
+ * @param nrows : number of rows in each of the banks read by the event.
+ * @return      : error code, which is always 0 (no error).
+ */
+int rge_latency_record(
+        rge_latency *lat, double time, lint evn,
+        luint nrows[RGE_LATENCYNBANKS]
+);
+
+/** Add the events recorded in src to dst. */
+int rge_latency_merge(rge_latency *dst, rge_latency *src);
+
+/**
+ * Combine lat across ranks. Only rank 0 receives the histogram, while all ranks
+ *     receive the slowest events. Does nothing if there is a single process.
+ */
+int rge_latency_reduce(rge_latency *lat);
+
+/**
+ * Print the latency distribution and the slowest events, from slowest to
+ *     fastest.
+ *
+ * @param lat        : rge_latency to print.
+ * @param bank_names : names of the banks whose sizes were recorded.
+ * @return           : error code, which is always 0 (no error).
+ */
+int rge_latency_print(
+        rge_latency *lat, const char *bank_names[RGE_LATENCYNBANKS]
+);
+
+#endif
@@ -61,4 +61,62 @@ void rge_rotate_y(double *x, double *z, double th);
  */
 void rge_rotate_z(double *x, double *y, double th);
 
+/**
+ * Return position of value v inside an array of bin edges b with size+1
+ *     elements. If v is not inside b, return -1.
+ */
+int rge_find_pos(double v, double *b, int size);
+
+/**
+ * Find index of a point in a flattened array of equally-sized bins, recursively
+ *     going through binnings. The last binning runs fastest.
+ *
+ *     INTERNAL PARAMETERS.
+ * @param dim_bins: Binning dimension. Needed to compute how deep the recursion
+ *                  should go before stopping.
+ * @param depth:    How deep along the number of bins we are. When calling the
+ *                  function, this should always be 0.
+ *
+ *     BINNINGS PAREMETERS.
+ * @param var:      Binning variables.
+ * @param nbins:    Array with number of dimensions for binning for each
+ *                  binning.
+ * @param range:    2-dimensional array with lower and upper limits for each
+ *                  binning variable.
+ * @param binsize:  Array with size of each bin for each binning.
+ *
+ * @return:         Index of the bin we're looking for. Returns -1 if variable
+ *                  is not within binning range.
+ */
+lint rge_find_idx(
+        luint dim_bins, luint depth, float var[], luint nbins[],
+        double range[][2], double binsize[]
+);
+
+/**
+ * Fit the azimuthal modulation A + B cos(phi) + C cos(2 phi) to a histogram by
+ *     weighted linear least squares. Since the model is linear in A, B, and C,
+ *     the fit is solved in closed form from its 3x3 normal equations, with no
+ *     iterations. Each term is averaged over the width of its bin, so that
+ *     wide or variable-width bins don't bias the coefficients. Bins with an
+ *     error of 0 are skipped.
+ *
+ * @param nbins : number of bins.
+ * @param edges : array of size nbins+1 with the bin edges, in radians.
+ * @param y     : array of size nbins with the bin contents.
+ * @param err   : array of size nbins with the bin errors.
+ * @param par   : array of size 3 where A, B, and C are written.
+ * @param cov   : 3x3 covariance matrix of par.
+ * @param chi2  : chi2 of the fit.
+ * @param ndf   : number of degrees of freedom of the fit.
+ * @return      : 0 if successful, 1 if fewer than 3 bins have a non-zero error
+ *                or the normal equations are singular. Doesn't set rge_errno,
+ *                since an empty bin shouldn't stop a program.
+ */
+int rge_fit_cos_modulation(
+        luint nbins, const double edges[], const double y[],
+        const double err[], double par[3], double cov[3][3], double *chi2,
+        luint *ndf
+);
+
 #endif
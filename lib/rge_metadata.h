@@ -0,0 +1,155 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#ifndef RGE_METADATA
+#define RGE_METADATA
+
+// --+ preamble +---------------------------------------------------------------
+// C.
+#include <string.h>
+
+// C++.
+#include <map>
+#include <set>
+#include <string>
+
+// ROOT.
+#include <TFile.h>
+#include <TFileMerger.h>
+#include <TH1.h>
+#include <TKey.h>
+#include <TTree.h>
+#include <TVectorD.h>
+
+// rge-analysis.
+#include "rge_constants.h"
+#include "rge_err_handler.h"
+
+// typedefs.
+typedef unsigned int uint;
+typedef long unsigned int luint;
+typedef long int lint;
+
+/**
+ * Names of the metadata objects stored in output root files. All metadata is
+ *     stored inside the RGE_METADIR directory:
+ *   * RGE_METARUNS    : TVectorD with the list of runs in the file.
+ *   * RGE_METASF      : TVectorD with the sampling fraction parameters used for
+ *                       a run, named RGE_METASF_<run_no>.
+ *   * RGE_METACUTFLOW : TH1D with one labelled bin per counter.
+ *   * RGE_METADIS     : TVectorD with the Q2, W2, and Yb cuts applied when
+ *                       writing the file. Only present in DIS-skimmed files.
+ */
+#define RGE_METADIR     "metadata"
+#define RGE_METARUNS    "runs"
+#define RGE_METASF      "sf_params"
+#define RGE_METACUTFLOW "cutflow"
+#define RGE_METADIS     "dis_skim"
+
+// --+ internal +---------------------------------------------------------------
+/**
+ * Get the metadata directory from file f. If create is true and the directory
+ *     doesn't exist, create it. Returns NULL if the directory is not found.
+ */
+static TDirectory *get_metadir(TFile *f, bool create);
+
+// --+ library +----------------------------------------------------------------
+/** Write the list of runs to file f, replacing any previous run list. */
+int rge_write_runlist(TFile *f, std::set<int> *runs);
+
+/** Add the runs in the run list of file f to runs. */
+int rge_read_runlist(TFile *f, std::set<int> *runs);
+
+/** Write the sampling fraction parameters used for run run_no to file f. */
+int rge_write_sf_params(
+        TFile *f, int run_no, double sf[RGE_NSECTORS][RGE_NSFPARAMS][2]
+);
+
+/**
+ * Write a cutflow histogram to file f, with one bin for each counter.
+ *
+ * @param f      : file where the cutflow is written.
+ * @param size   : number of counters.
+ * @param labels : array of size size with the label of each counter.
+ * @param counts : array of size size with the value of each counter.
+ * @return       : success code (0).
+ */
+int rge_write_cutflow(
+        TFile *f, uint size, const char *labels[], luint counts[]
+);
+
+/**
+ * Record in file f that only events passing the DIS selection (RGE_Q2CUT,
+ *     RGE_W2CUT, and RGE_YBCUT on the trigger electron) were written to it.
+ */
+int rge_write_dis_skim(TFile *f);
+
+/**
+ * Check if file f was DIS-skimmed using the same cuts currently defined in
+ *     rge_constants.h. Files skimmed with other cuts are treated as unskimmed.
+ */
+bool rge_read_dis_skim(TFile *f);
+
+/**
+ * Remove the DIS skim record from file f, e.g. when its kinematics are
+ *     recomputed and some trigger electrons no longer pass the DIS cuts. Does
+ *     nothing if f has no record.
+ */
+int rge_remove_dis_skim(TFile *f);
+
+/**
+ * Attach the kinematics friend tree of file f to its data tree t, so that the
+ *     derived kinematics are read by name along with the entries of t. Files
+ *     written before the kinematics were split from the data tree have no
+ *     friend tree, and t is left as it is.
+ *
+ * @param f : file containing t.
+ * @param t : data tree of f.
+ * @return  : error code. 1 if the friend tree doesn't match t, or if there
+ *            is neither a friend tree nor kinematics in t.
+ */
+int rge_attach_kinematics(TFile *f, TTree *t);
+
+/**
+ * Merge the metadata of a list of files and write it to f_out. Run lists are
+ *     joined, histograms (such as the cutflow) are added, and for any other
+ *     object the first instance found is kept. The DIS skim record is only kept
+ *     if all files were skimmed with the current cuts, as rge_read_dis_skim()
+ *     checks.
+ *
+ * @param f_out     : file where the merged metadata is to be written.
+ * @param nfiles    : number of input files.
+ * @param filenames : array of size nfiles with the input filenames.
+ * @return          : error code. 1 if an input file couldn't be opened.
+ */
+int rge_merge_metadata(TFile *f_out, int nfiles, char **filenames);
+
+/**
+ * Merge a list of files into out_filename using TFileMerger. Trees are
+ *     fast-cloned, keeping the compression of the input files, and histograms
+ *     are added. The metadata directory is skipped, and merged with
+ *     rge_merge_metadata() afterwards if merge_meta is true.
+ *
+ * @param filenames    : array of input filenames.
+ * @param nfiles       : size of filenames.
+ * @param out_filename : name of the output file.
+ * @param merge_meta   : set to true to also merge the metadata.
+ * @return             : error code. 0 if successful, 1 otherwise.
+ */
+int rge_merge_files(
+        char **filenames, int nfiles, const char *out_filename, bool merge_meta
+);
+
+#endif
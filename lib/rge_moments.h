@@ -0,0 +1,67 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#ifndef RGE_MOMENTS
+#define RGE_MOMENTS
+
+// --+ preamble +---------------------------------------------------------------
+// C.
+#include <math.h>
+
+// typedefs.
+typedef unsigned int uint;
+typedef long unsigned int luint;
+typedef long int lint;
+
+/**
+ * Streaming accumulators for the mean and variance of a variable. Values are
+ *     added one at a time with Welford's update, which stays accurate when the
+ *     variance is small compared to the squared mean, unlike summing x and x^2.
+ *     Accumulators filled separately are combined with Chan et al.'s parallel
+ *     update. Merging a fixed list of accumulators in a fixed order always
+ *     gives the same bits, no matter which thread filled each of them.
+ */
+
+// --+ structs +----------------------------------------------------------------
+/**
+ * Moments of a set of values.
+ *
+ * @param n    : number of values added.
+ * @param mean : mean of the values.
+ * @param m2   : sum of squared differences from the mean.
+ */
+typedef struct {
+    lint n;
+    double mean;
+    double m2;
+} rge_moments;
+
+// --+ library +----------------------------------------------------------------
+/** Initialize an empty rge_moments. */
+rge_moments rge_moments_init();
+
+/** Add value x to m. */
+int rge_moments_add(rge_moments *m, double x);
+
+/** Add the values accumulated in src to dst. */
+int rge_moments_merge(rge_moments *dst, const rge_moments *src);
+
+/** Get the unbiased variance of the values in m. 0 if m has under 2 values. */
+double rge_moments_variance(const rge_moments *m);
+
+/** Get the statistical error of the mean of m. 0 if m has under 2 values. */
+double rge_moments_mean_err(const rge_moments *m);
+
+#endif
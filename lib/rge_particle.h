@@ -144,6 +144,13 @@ static int match_pid(
         bool htcc_signal_check, bool htcc_pion_threshold
 );
 
+/**
+ * Initialize a pi0 candidate from a pair of photons. The pair is treated as a
+ *     single hadron of PID 111, with the sum of the photons' momenta and mass
+ *     equal to their invariant mass. The vertex is taken from g1.
+ */
+static rge_particle pair_init(rge_particle g1, rge_particle g2);
+
 /** Compute theta angle in lab frame from the vertex momentum of a particle. */
 static double theta_lab(rge_particle particle);
 
@@ -211,6 +218,20 @@ rge_particle rge_particle_init(
         uint pos, lint fmt_nlayers
 );
 
+/**
+ * Initialize a photon from the REC::Particle bank. Neutrals have no track, so
+ *     the particle is taken directly from row pindex of the bank. If it is not
+ *     neutral or it isn't identified as a photon by assign_neutral_pid(), the
+ *     particle is returned as invalid.
+ *
+ * @param particle     : pointer to the particle rge_hipobank.
+ * @param pindex       : row of the particle in the particle bank.
+ * @param total_energy : Total deposited energy in ECIN, ECOU, and PCAL.
+ */
+rge_particle rge_photon_init(
+        rge_hipobank *particle, uint pindex, double total_energy
+);
+
 /**
  * Set PID from all available information. This functions mimics PIDMatch from
  *     the EB (Event Builder) CLAS12 reconstruction engine.
@@ -237,10 +258,51 @@ int rge_set_pid(
  *     RGE_VARS_SIZE, and the order of variables can be seen in constants.h.
  */
 int rge_fill_ntuples_arr(
-        Float_t *arr, rge_particle p, rge_particle e, int run_no, int evn,
+        Float_t *arr, rge_particle p, rge_particle e, int run_no, lint evn,
         int status, double beam_E, float chi2, float ndf, double pcal_energy,
         double ecin_E, double ecou_E, double tof, double tre_tof, int nphe_ltcc,
         int nphe_htcc
 );
 
+/**
+ * Fill the derived kinematics of array arr, i.e. the beam energy and the
+ *     variables in RGE_KINVARS, from particle p and the trigger electron e.
+ *     Called by rge_fill_ntuples_arr(), and by make_ntuples -R to recompute
+ *     the kinematics friend tree of an existing file.
+ */
+int rge_fill_kinematics_arr(
+        Float_t *arr, rge_particle p, rge_particle e, double beam_E
+);
+
+/**
+ * Same as rge_fill_kinematics_arr(), but without checking rge_errno, so that
+ *     the result doesn't depend on errors left by earlier calls or by other
+ *     threads. Used by the kernels of rge_kernels.
+ */
+int rge_calc_kinematics_arr(
+        Float_t *arr, rge_particle p, rge_particle e, double beam_E
+);
+
+/**
+ * Rebuild a particle from the primary variables of an ntuples entry, stored in
+ *     arr following the order of RGE_VARS. Sector is not stored, so it is set
+ *     to 0.
+ *
+ * @param arr        : array with the primary variables of the entry.
+ * @param is_trigger : true if the entry is the trigger electron of its event.
+ * @return           : the rebuilt particle.
+ */
+rge_particle rge_ntuples_particle_init(Float_t *arr, bool is_trigger);
+
+/**
+ * Fill array to be stored in the pi0 tree from a pair of photons, g1 and g2,
+ *     and the trigger electron e. SIDIS variables are computed treating the
+ *     pair as a single hadron. Array is of constant size RGE_PI0VARS_SIZE, and
+ *     the order of variables can be seen in constants.h.
+ */
+int rge_fill_pi0_arr(
+        Float_t *arr, rge_particle g1, rge_particle g2, rge_particle e,
+        int run_no, lint evn, double beam_E
+);
+
 #endif
@@ -57,8 +57,8 @@ typedef struct {
  */
 static rge_pidconstants pid_constants_init(int q, double m, const char *n);
 
-/** PID_MAP global iterator. */
-static std::map<int, rge_pidconstants>::const_iterator pid_it;
+/** PID_MAP iterator type. */
+typedef std::map<int, rge_pidconstants>::const_iterator pid_iterator;
 
 /** Counters for negative, neutral, and positive PIDs in list. */
 static uint negative_size = 0;
@@ -0,0 +1,143 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#ifndef RGE_READAHEAD
+#define RGE_READAHEAD
+
+// --+ preamble +---------------------------------------------------------------
+// C.
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// C++.
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// io_uring.
+#ifdef RGE_URING
+#include <liburing.h>
+#endif
+
+// typedefs.
+typedef unsigned int uint;
+typedef long unsigned int luint;
+typedef long int lint;
+
+/**
+ * Asynchronous readahead of input files. hipo::reader reads one record at a
+ *     time with blocking reads, which leaves most of the bandwidth of fast
+ *     disks unused. A background thread reads the file ahead of the reader,
+ *     keeping many reads in flight, so that the reader's own reads and
+ *     decompression are served from the page cache. The reader reports its
+ *     position with rge_readahead_update(), and the thread stays at most a
+ *     window of bytes ahead of it.
+ *
+ * When compiled with RGE_URING (make URING=1), reads are issued through
+ *     io_uring, with up to RGE_READAHEADDEPTH of them in flight. Without it, or
+ *     if the kernel refuses to set up an io_uring, the thread falls back to
+ *     plain blocking reads.
+ */
+
+// --+ structs +----------------------------------------------------------------
+/** Maximum number of reads in flight. */
+#define RGE_READAHEADDEPTH 16
+
+/** Size of each read (bytes). */
+#define RGE_READAHEADCHUNK (1 << 19)
+
+/**
+ * Readahead state of one input file.
+ *
+ * @param fd     : file descriptor of the input file. -1 if it couldn't be
+ *                 opened, in which case the readahead does nothing.
+ * @param size   : size of the input file (bytes).
+ * @param window : maximum distance between the reader and the readahead.
+ * @param pos    : last position reported by the reader (bytes).
+ * @param nbytes : number of bytes read ahead so far.
+ * @param uring  : true if reads are issued through io_uring.
+ * @param stop   : set to stop the readahead thread.
+ * @param lock   : lock used to wait on cv.
+ * @param cv     : signals that stop was set.
+ * @param buf    : buffers where reads are written. Their contents are
+ *                 discarded, since reads are only done to fill the cache.
+ * @param worker : readahead thread.
+ */
+typedef struct {
+    int fd;
+    lint size;
+    lint window;
+    std::atomic<lint> pos;
+    std::atomic<lint> nbytes;
+    bool uring;
+    std::atomic<bool> stop;
+    std::mutex lock;
+    std::condition_variable cv;
+    std::vector<char> buf;
+    std::thread worker;
+} rge_readahead;
+
+// --+ internal +---------------------------------------------------------------
+/** Time the readahead thread waits for the reader to advance. */
+static const std::chrono::milliseconds READAHEAD_WAIT(2);
+
+/**
+ * Wait until the reader is less than a window behind offset next, or stop is
+ *     set. Return the offset up to which reads can be issued.
+ */
+static lint wait_limit(rge_readahead *ra, lint next);
+
+/** Read ahead with blocking reads, one at a time. */
+static int run_pread(rge_readahead *ra);
+
+#ifdef RGE_URING
+/**
+ * Read ahead through io_uring, keeping up to RGE_READAHEADDEPTH reads in
+ *     flight. Return 1 without reading if the io_uring can't be set up.
+ */
+static int run_uring(rge_readahead *ra);
+#endif
+
+/** Body of the readahead thread. */
+static int run_readahead(rge_readahead *ra);
+
+// --+ library +----------------------------------------------------------------
+/**
+ * Open filename and start reading it ahead in the background.
+ *
+ * @param ra       : rge_readahead to initialize.
+ * @param filename : input file.
+ * @param window   : maximum number of bytes read ahead of the reader.
+ * @return         : error code, which is always 0 (no error). If the file
+ *                   can't be opened, the readahead does nothing, and the error
+ *                   is left to the reader.
+ */
+int rge_readahead_open(rge_readahead *ra, const char *filename, lint window);
+
+/**
+ * Report the position of the reader, as the fraction of the file read so far.
+ *     Cheap enough to be called once per event.
+ */
+int rge_readahead_update(rge_readahead *ra, double fraction);
+
+/** Stop the readahead thread and close the file. */
+int rge_readahead_close(rge_readahead *ra);
+
+#endif
@@ -0,0 +1,136 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#ifndef RGE_SHMCACHE
+#define RGE_SHMCACHE
+
+// --+ preamble +---------------------------------------------------------------
+// C.
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// C++.
+#include <utility>
+#include <vector>
+
+// typedefs.
+typedef unsigned int uint;
+typedef long unsigned int luint;
+typedef long int lint;
+
+/**
+ * Node-local cache of calibration files in POSIX shared memory. The first
+ *     process to read a file publishes its parsed contents in a read-only
+ *     segment under /dev/shm, and later processes attach to it instead of
+ *     parsing the file again and keeping a private copy. Segment names are
+ *     derived from the file's path, size, and modification time, and from
+ *     SHM_VERSION, so editing a file or changing the layout of cached data
+ *     never serves stale contents.
+ *
+ * The cache is opt-in, and only used if the RGE_SHMCACHE environment variable
+ *     is set. Segments outlive the processes that create them, and can be
+ *     removed with `rm /dev/shm/rge_*`. Segments of earlier versions of an
+ *     edited file are never attached again, but they aren't removed either,
+ *     and keep using memory until removed by hand or until reboot.
+ */
+
+// --+ internal +---------------------------------------------------------------
+/** Magic number and version of the segment layout. */
+static const uint64_t SHM_MAGIC   = 0x52474553484d4300; // "RGESHMC".
+static const uint32_t SHM_VERSION = 2;
+
+/** Seconds to wait for a segment being written by another process. */
+static const double SHM_TIMEOUT = 10.;
+
+/**
+ * Header at the start of each segment. Payload starts at the next multiple of
+ *     64 bytes.
+ *
+ * @param magic      : SHM_MAGIC.
+ * @param version    : SHM_VERSION.
+ * @param ready      : set to 1 by the creator once the payload is written.
+ * @param src_size   : size of the source file.
+ * @param src_mtime  : modification time of the source file (ns).
+ * @param size       : size of the payload.
+ */
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t ready;
+    uint64_t src_size;
+    int64_t  src_mtime;
+    uint64_t size;
+} shm_header;
+static const luint SHM_HEADERSIZE = 64;
+
+/**
+ * Write the segment name for filename cached under kind into name, and the
+ *     file's size and modification time into src_size and src_mtime.
+ *
+ * @return : 0 if successful, 1 if the file couldn't be accessed.
+ */
+static int get_segment_name(
+        const char *kind, const char *filename, char *name,
+        uint64_t *src_size, int64_t *src_mtime
+);
+
+// --+ library +----------------------------------------------------------------
+/** Check if the shared-memory cache is enabled. */
+bool rge_shm_enabled();
+
+/**
+ * Attach to the segment caching filename under kind.
+ *
+ * @param kind     : short name of the type of cached data (e.g. "sf").
+ * @param filename : file whose parsed contents are cached.
+ * @param size     : pointer to luint where the payload size will be written.
+ * @return         : pointer to the read-only payload, or NULL if the cache is
+ *                   disabled, or there is no valid segment for filename.
+ */
+const void *rge_shm_attach(const char *kind, const char *filename, luint *size);
+
+/**
+ * Publish the parsed contents of filename under kind. Does nothing if the cache
+ *     is disabled or another process already published it.
+ *
+ * @param kind     : short name of the type of cached data.
+ * @param filename : file whose parsed contents are cached.
+ * @param data     : payload to be copied into the segment.
+ * @param size     : size of data in bytes.
+ * @return         : 0 if successful or there was nothing to do, 1 if the
+ *                   segment couldn't be created.
+ */
+int rge_shm_publish(
+        const char *kind, const char *filename, const void *data, luint size
+);
+
+/** Check if ptr points into a segment attached by this process. */
+bool rge_shm_owns(const void *ptr);
+
+/**
+ * Remove the segment caching filename under kind, if any. Processes attached
+ *     to it keep their mapping.
+ */
+int rge_shm_remove(const char *kind, const char *filename);
+
+#endif
@@ -0,0 +1,191 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#ifndef RGE_STAGING
+#define RGE_STAGING
+
+// --+ preamble +---------------------------------------------------------------
+// C.
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// C++.
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// rge-analysis.
+#include "rge_err_handler.h"
+
+// typedefs.
+typedef unsigned int uint;
+typedef long unsigned int luint;
+typedef long int lint;
+
+/**
+ * Staging of input and output files through local scratch, for inputs living
+ *     on slow shared filesystems. While a program processes one input file, a
+ *     background thread copies the next ones to scratch, so that the program
+ *     reads from local disk. Outputs are written to scratch too, and a second
+ *     thread moves them to their final location while the program continues.
+ *
+ * Staging is opt-in, and only used if the RGE_SCRATCH environment variable is
+ *     set to a local directory. Otherwise, every function behaves as if files
+ *     were staged in place, so programs run exactly as before. Any directory
+ *     can stand in for the shared filesystem, which makes staging easy to try
+ *     on a single machine.
+ */
+
+// --+ structs +----------------------------------------------------------------
+/** States of a staged input. */
+#define RGE_STAGEPENDING  0 /** Not copied yet. */
+#define RGE_STAGEREADY    1 /** Copied to scratch. */
+#define RGE_STAGEFAILED   2 /** Copy failed. Read from the original file. */
+#define RGE_STAGERELEASED 3 /** Processed and removed from scratch. */
+
+/**
+ * Staging state of a list of input files and of the outputs being moved.
+ *
+ * @param enabled     : true if RGE_SCRATCH is set.
+ * @param scratch_dir : local directory where files are staged.
+ * @param src         : original path of each input.
+ * @param local       : path of each input in scratch.
+ * @param state       : state of each input.
+ * @param nuses       : number of times each input is released before it is
+ *                      removed from scratch.
+ * @param depth       : maximum number of inputs in scratch at once.
+ * @param nlive       : number of inputs currently in scratch.
+ * @param noutputs    : number of outputs staged, used to name them uniquely.
+ * @param moves       : queue of outputs to move, as (local, final) paths.
+ * @param stop        : true once rge_stager_close() is called.
+ * @param move_failed : true if any output couldn't be moved.
+ * @param lock        : lock protecting all of the above.
+ * @param cv          : signals changes of state, nlive, moves, or stop.
+ * @param copier      : thread staging inputs, in order.
+ * @param mover       : thread moving outputs, in order.
+ */
+typedef struct {
+    bool enabled;
+    char scratch_dir[PATH_MAX];
+    std::vector<std::string> src;
+    std::vector<std::string> local;
+    std::vector<int> state;
+    std::vector<lint> nuses;
+    luint depth;
+    luint nlive;
+    luint noutputs;
+    std::deque<std::pair<std::string, std::string>> moves;
+    bool stop;
+    bool move_failed;
+    std::mutex lock;
+    std::condition_variable cv;
+    std::thread copier;
+    std::thread mover;
+} rge_stager;
+
+// --+ internal +---------------------------------------------------------------
+/** Size of the buffer used to copy files (bytes). */
+static const luint STAGE_BUFSIZE = 1 << 22;
+
+/**
+ * Copy file src to dst, through a temporary file renamed at the end, so that
+ *     dst never exists partially written. Return 0 if successful, 1 otherwise.
+ */
+static int copy_file(const char *src, const char *dst);
+
+/**
+ * Move file src to dst, renaming it if both are in the same filesystem, and
+ *     copying and removing it otherwise. Return 0 if successful, 1 otherwise.
+ */
+static int move_file(const char *src, const char *dst);
+
+/** Body of the copier thread. Stage inputs in order, up to depth at once. */
+static int run_copier(rge_stager *st);
+
+/** Body of the mover thread. Move outputs in order until stop is set. */
+static int run_mover(rge_stager *st);
+
+// --+ library +----------------------------------------------------------------
+/**
+ * Initialize st and start staging the first inputs in the background, if the
+ *     RGE_SCRATCH environment variable is set.
+ *
+ * @param st        : rge_stager to initialize.
+ * @param filenames : list of input files, in the order they will be used.
+ * @param nfiles    : number of input files.
+ * @param nuses     : array of size nfiles with the number of times each file
+ *                    will be acquired and released. NULL if each is used once.
+ * @param depth     : maximum number of inputs in scratch at once. Should be at
+ *                    least the number of inputs the program uses at once.
+ * @return          : error code, which is always 0 (no error).
+ */
+int rge_stager_init(
+        rge_stager *st, char **filenames, int nfiles, const lint *nuses,
+        luint depth
+);
+
+/**
+ * Wait until input file_i is staged, and get the path from which it should be
+ *     read. If staging is disabled or the copy failed, that is the original
+ *     path.
+ */
+const char *rge_stager_acquire(rge_stager *st, int file_i);
+
+/**
+ * Release one use of input file_i. After its last use, it is removed from
+ *     scratch, making room for the next input.
+ */
+int rge_stager_release(rge_stager *st, int file_i);
+
+/**
+ * Get the path in scratch where an output whose final path is final_path
+ *     should be written. If staging is disabled, that is final_path itself.
+ *
+ * @param st         : rge_stager.
+ * @param final_path : final path of the output.
+ * @param local_path : array of size PATH_MAX where the path is written.
+ * @return           : error code, which is always 0 (no error).
+ */
+int rge_stager_output(rge_stager *st, const char *final_path, char *local_path);
+
+/**
+ * Queue an output written to local_path to be moved to final_path in the
+ *     background. Does nothing if staging is disabled.
+ */
+int rge_stager_commit(
+        rge_stager *st, const char *local_path, const char *final_path
+);
+
+/**
+ * Wait for all queued outputs to be moved, stop the staging threads, and
+ *     remove any inputs left in scratch.
+ *
+ * @return : 0 if successful. If an output couldn't be moved, set rge_errno to
+ *           RGEERR_STAGINGFAILED and return 1. The output is then left in
+ *           scratch.
+ */
+int rge_stager_close(rge_stager *st);
+
+#endif
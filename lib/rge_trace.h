@@ -0,0 +1,229 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#ifndef RGE_TRACE
+#define RGE_TRACE
+
+// --+ preamble +---------------------------------------------------------------
+// C.
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// C++.
+#include <mutex>
+#include <set>
+#include <vector>
+
+// rge-analysis.
+#include "rge_err_handler.h"
+
+// typedefs.
+typedef unsigned int uint;
+typedef long unsigned int luint;
+typedef long int lint;
+
+/**
+ * Sampled debug tracing. When compiled with RGE_TRACING (make TRACE=1),
+ *     make_ntuples can log the PID decision, detector sums, and cut outcomes of
+ *     each track in a sample of events to a compact binary file, which is read
+ *     back by decode_trace. Without RGE_TRACING, the RGE_TRACE*() macros expand
+ *     to nothing and their arguments are never evaluated, so trace points cost
+ *     nothing in production builds.
+ */
+
+// --+ structs +----------------------------------------------------------------
+/** Kinds of trace records, i.e. the outcome logged for a track. */
+#define RGE_TRACEINVALID  0 /** Invalid particle, e.g. no FMT track. */
+#define RGE_TRACEFMTCUT   1 /** Failed the FMT geometry cut. */
+#define RGE_TRACEDCCUT    2 /** Failed the DC fiducial cut. */
+#define RGE_TRACEPCALCUT  3 /** Failed the PCAL fiducial cut. */
+#define RGE_TRACEMATCH    4 /** PID assigned by rge_set_pid(). */
+#define RGE_TRACETRIGGER  5 /** Accepted as the trigger electron. */
+#define RGE_TRACEDISSKIM  6 /** Trigger failed the DIS selection. */
+#define RGE_TRACENKINDS   7
+
+/** Stages of make_ntuples where a record can be written. */
+#define RGE_TRACESEARCH    0 /** Search for the trigger electron. */
+#define RGE_TRACEPARTICLES 1 /** Processing of all other particles. */
+
+/**
+ * Header at the start of a trace file.
+ *
+ * @param magic       : TRACE_MAGIC, not null-terminated.
+ * @param version     : TRACE_VERSION of the program that wrote the file.
+ * @param record_size : size of each rge_tracerecord in the file (bytes).
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+} rge_traceheader;
+
+/**
+ * One trace record. Fields that are not known at the trace point are -1.
+ *
+ * @param evn         : event number.
+ * @param kind        : kind of record, one of the RGE_TRACE* kinds.
+ * @param stage       : stage of the program, RGE_TRACESEARCH or
+ *                      RGE_TRACEPARTICLES.
+ * @param pindex      : row of the particle in REC::Particle.
+ * @param sector      : sector of the particle's track.
+ * @param recon_pid   : PID defined by the EB engine.
+ * @param pid         : PID assigned by rge_set_pid().
+ * @param status      : status variable from REC::Particle.
+ * @param nphe_htcc   : number of photoelectrons in HTCC.
+ * @param nphe_ltcc   : number of photoelectrons in LTCC.
+ * @param p           : momentum magnitude (GeV).
+ * @param energy_pcal : energy deposited in PCAL (GeV).
+ * @param energy_ecin : energy deposited in ECIN (GeV).
+ * @param energy_ecou : energy deposited in ECOU (GeV).
+ */
+typedef struct {
+    int64_t evn;
+    int32_t kind, stage, pindex, sector;
+    int32_t recon_pid, pid, status, nphe_htcc, nphe_ltcc;
+    float p, energy_pcal, energy_ecin, energy_ecou;
+} rge_tracerecord;
+
+/**
+ * Trace file shared by all threads.
+ *
+ * @param file   : output file.
+ * @param lock   : mutex serializing writes to file.
+ * @param every  : trace every event whose number is a multiple of every. 0
+ *                 disables sampling.
+ * @param events : event numbers traced regardless of every.
+ * @param failed : true if any write to file failed.
+ */
+typedef struct {
+    FILE *file;
+    std::mutex *lock;
+    lint every;
+    std::set<lint> events;
+    bool failed;
+} rge_tracelog;
+
+/**
+ * Per-thread tracer. Records are buffered and written to the log in blocks,
+ *     so threads rarely contend for its lock.
+ *
+ * @param log    : log where records are written. NULL disables tracing.
+ * @param active : true if the current event is traced.
+ * @param evn    : number of the current event.
+ * @param buffer : records not yet written to the log.
+ */
+typedef struct {
+    rge_tracelog *log;
+    bool active;
+    lint evn;
+    std::vector<rge_tracerecord> buffer;
+} rge_tracer;
+
+/**
+ * Trace points, compiled out unless RGE_TRACING is defined. RGE_TRACEFLUSH()
+ *     returns an error code, which is always 0 when compiled out.
+ */
+#ifdef RGE_TRACING
+#define RGE_TRACEEVENT(...) rge_trace_event(__VA_ARGS__)
+#define RGE_TRACECUT(...)   rge_trace_cut(__VA_ARGS__)
+#define RGE_TRACEPID(...)   rge_trace_pid(__VA_ARGS__)
+#define RGE_TRACEFLUSH(...) rge_trace_flush(__VA_ARGS__)
+#else
+#define RGE_TRACEEVENT(...) ((void) 0)
+#define RGE_TRACECUT(...)   ((void) 0)
+#define RGE_TRACEPID(...)   ((void) 0)
+#define RGE_TRACEFLUSH(...) 0
+#endif
+
+// --+ internal +---------------------------------------------------------------
+/** Magic string and version identifying trace files. */
+static const char     TRACE_MAGIC[8] = {'R', 'G', 'E', 'T', 'R', 'A', 'C', 'E'};
+static const uint32_t TRACE_VERSION  = 1;
+
+/** Number of records buffered by each tracer before writing them. */
+static const luint TRACE_BUFSIZE = 4096;
+
+/** Names of each kind of record, used by rge_trace_kind_name(). */
+static const char *TRACE_KINDNAMES[RGE_TRACENKINDS] = {
+        "invalid", "fmt cut", "dc cut", "pcal cut", "pid", "trigger",
+        "dis skim"
+};
+
+/**
+ * Write the buffer of t to its log and clear it. Failures are stored in the log
+ *     and reported by rge_trace_flush(), so that trace points never interrupt
+ *     the program.
+ */
+static int write_buffer(rge_tracer *t);
+
+/** Append a record to t's buffer, writing the buffer if full. */
+static int push_record(rge_tracer *t, rge_tracerecord r);
+
+// --+ library +----------------------------------------------------------------
+/**
+ * Open a trace file and write its header.
+ *
+ * @param log      : rge_tracelog to initialize.
+ * @param filename : output file.
+ * @param every    : sampling period. 0 disables sampling.
+ * @param events   : event numbers to trace regardless of every.
+ * @return         : error code. 0 if successful, 1 otherwise.
+ */
+int rge_tracelog_open(
+        rge_tracelog *log, const char *filename, lint every,
+        std::set<lint> *events
+);
+
+/** Close a trace file opened with rge_tracelog_open(). */
+int rge_tracelog_close(rge_tracelog *log);
+
+/** Initialize a tracer writing to log. If log is NULL, nothing is traced. */
+rge_tracer rge_tracer_init(rge_tracelog *log);
+
+/** Start event evn, deciding if it is traced. */
+int rge_trace_event(rge_tracer *t, lint evn);
+
+/** Log a cut outcome for the particle in row pindex of REC::Particle. */
+int rge_trace_cut(
+        rge_tracer *t, int kind, int stage, int pindex, int sector, double p
+);
+
+/** Log a PID decision and the detector data used to make it. */
+int rge_trace_pid(
+        rge_tracer *t, int stage, int pindex, int sector, double p,
+        int recon_pid, int pid, int status, double energy_pcal,
+        double energy_ecin, double energy_ecou, int nphe_htcc, int nphe_ltcc
+);
+
+/**
+ * Write all buffered records of t to its log. Returns 1 if this or any previous
+ *     write to the log failed, and 0 otherwise.
+ */
+int rge_trace_flush(rge_tracer *t);
+
+/**
+ * Read and check the header of a trace file, leaving f at its first record.
+ *
+ * @param f : trace file, open for reading.
+ * @return  : error code. 0 if successful, 1 if the file is not a trace file
+ *            written by this version.
+ */
+int rge_trace_read_header(FILE *f);
+
+/** Return the name of a kind of record. */
+const char *rge_trace_kind_name(int kind);
+
+#endif
@@ -23,10 +23,12 @@
 
 // rge-analysis.
 #include "../lib/rge_constants.h"
+#include "../lib/rge_dist.h"
 #include "../lib/rge_err_handler.h"
 #include "../lib/rge_io_handler.h"
 #include "../lib/rge_filename_handler.h"
 #include "../lib/rge_math_utils.h"
+#include "../lib/rge_metadata.h"
 
 static const char *USAGE_MESSAGE =
 "Usage: acc_corr [-hq:n:z:p:f:g:s:d:FD]\n"
@@ -79,18 +81,11 @@ static int BADPIDS[BADPIDS_SIZE] = {
 #define SIMUL_HADRON     1
 #define SIMUL_ELECTRON   2
 
-/**
-* Return position of value v inside a doubles array b of size s. If v is not
-*     inside b, return -1.
-*/
-static int find_pos(double v, double *b, int size) {
-    for (int i = 0; i < size; ++i) if (b[i] < v && v < b[i+1]) return i;
-    return -1;
-}
-
 /**
  * Count number of events in a tree for each bin, for a given pid. The number of
- *     bins is equal to the multiplication of the size-1 of each binning.
+ *     bins is equal to the multiplication of the size-1 of each binning. Each
+ *     rank counts its shard of the tree, and counts are added and written by
+ *     rank 0.
  *
  * @param file:   file where we'll write the output data.
  * @param tree:   TTree containing the data we're to process.
@@ -104,11 +99,13 @@ static int find_pos(double v, double *b, int size) {
  *                  * -1: thrown hadron.
  *                  *  1: simulated hadron.
  *                  *  2: simulated electron.
+ * @param skimmed: boolean telling us if tree only has events passing the DIS
+ *                cuts, so that they don't need to be applied again.
  * @return:       success code (0).
  */
 static int count_entries(
         FILE *file, TTree *tree, int pid, luint *nbins, double **edges,
-        bool in_deg, int type
+        bool in_deg, int type, bool skimmed
 ) {
     if (
             type != THROWN_ELECTRON && type != SIMUL_ELECTRON &&
@@ -129,8 +126,8 @@ static int count_entries(
     //       keeping a 5D array of non-contiguous pointers or -- even worse --
     //       C++ vectors.
     //          -Bruno
-    int evn_cnt[nbins[0]][nbins[1]][nbins[2]][nbins[3]][nbins[4]];
-    int *iterator = &evn_cnt[0][0][0][0][0]; // Auxiliary iterator for evn_cnt.
+    lint evn_cnt[nbins[0]][nbins[1]][nbins[2]][nbins[3]][nbins[4]];
+    lint *iterator = &evn_cnt[0][0][0][0][0]; // Auxiliary iterator for evn_cnt.
 
     // Set everything in evn_cnt to 0.
     for (luint bin_i = 0; bin_i < total_nbins; ++bin_i) {
@@ -186,23 +183,28 @@ static int count_entries(
         tree->SetBranchAddress(RGE_PHIPQ.name, &(s_bin[4]));
     }
 
-    for (int evn = 0; evn < tree->GetEntries(); ++evn) {
+    lint first_evn, last_evn;
+    rge_dist_shard(tree->GetEntries(), &first_evn, &last_evn);
+    for (lint evn = first_evn; evn < last_evn; ++evn) {
         tree->GetEntry(evn);
 
         // Only count the selected PID.
         if (pid - 0.5 >= s_pid || s_pid > pid + 0.5) continue;
 
-        // Apply Q2 cut.
-        if (s_bin[0] < RGE_Q2CUT) continue; // Q2 > 1.
+        // Apply DIS cuts, unless the tree was already skimmed.
+        if (!skimmed) {
+            // Apply Q2 cut.
+            if (s_bin[0] < RGE_Q2CUT) continue; // Q2 > 1.
 
-        // Apply W2 cut.
-        if (type == THROWN_ELECTRON || type == THROWN_HADRON) {
-            s_W2 = s_W * s_W;
-        }
-        if (s_W2 < RGE_W2CUT) continue; // W2 > 4.
+            // Apply W2 cut.
+            if (type == THROWN_ELECTRON || type == THROWN_HADRON) {
+                s_W2 = s_W * s_W;
+            }
+            if (s_W2 < RGE_W2CUT) continue; // W2 > 4.
 
-        // Apply Yb cut.
-        if (s_Yb > RGE_YBCUT) continue; // Yb < 0.85.
+            // Apply Yb cut.
+            if (s_Yb > RGE_YBCUT) continue; // Yb < 0.85.
+        }
 
         // Remove kinematic variables == 0.
         if (s_bin[1] == 0) continue;
@@ -226,7 +228,7 @@ static int count_entries(
         // Hadrons use 5 kinematic variables, electrons can only use 2.
         int nvars = (type == THROWN_HADRON || type == SIMUL_HADRON) ? 5 : 2;
         for (int bi = 0; bi < nvars && !kill; ++bi) {
-            idx[bi] = find_pos(s_bin[bi], edges[bi], nbins[bi]);
+            idx[bi] = rge_find_pos(s_bin[bi], edges[bi], nbins[bi]);
             if (idx[bi] < 0) kill = true;
         }
         if (kill) continue;
@@ -235,10 +237,14 @@ static int count_entries(
         ++evn_cnt[idx[0]][idx[1]][idx[2]][idx[3]][idx[4]];
     }
 
+    // Add up counts from all ranks.
+    rge_dist_reduce_sum(&evn_cnt[0][0][0][0][0], total_nbins);
+    if (rge_dist_rank() != 0) return 0;
+
     // Write evn_cnt to file.
     iterator = &evn_cnt[0][0][0][0][0];
     for (luint bin_i = 0; bin_i < total_nbins; ++bin_i) {
-        fprintf(file, "%d ", *iterator);
+        fprintf(file, "%ld ", *iterator);
         ++iterator;
     }
     fprintf(file, "\n");
@@ -246,6 +252,53 @@ static int count_entries(
     return 0;
 }
 
+/**
+ * Join the lists of PIDs found by each rank in rank order, so that PIDs keep
+ *     the order in which they first appear in the thrown tree. Every rank
+ *     receives the joined list. Does nothing if there is a single process.
+ *
+ * @param pidlist      : array of size 256 with the PIDs found by this rank.
+ *                       The joined list is written here.
+ * @param pidlist_size : size of the list in pidlist.
+ * @return             : success code (0).
+ */
+static int join_pidlists(double *pidlist, int *pidlist_size) {
+    int nranks = rge_dist_size();
+    if (nranks == 1) return 0;
+
+    // The first element of each list sent is its size.
+    double send[257];
+    luint recv_size = 257 * static_cast<luint>(nranks);
+    double *recv = static_cast<double *>(malloc(recv_size * sizeof(double)));
+    send[0] = *pidlist_size;
+    for (int pid_i = 0; pid_i < *pidlist_size; ++pid_i) {
+        send[pid_i + 1] = pidlist[pid_i];
+    }
+    rge_dist_allgather(send, 257, recv);
+
+    *pidlist_size = 0;
+    for (int rank = 0; rank < nranks; ++rank) {
+        double *rank_list = &(recv[257 * rank]);
+        int rank_size     = static_cast<int>(rank_list[0]);
+        for (int pid_i = 1; pid_i <= rank_size; ++pid_i) {
+            double pid = rank_list[pid_i];
+
+            // Check if we have already found this PID.
+            bool skip = false;
+            for (int pid_j = 0; pid_j < *pidlist_size; ++pid_j) {
+                if (pidlist[pid_j] - .5 <= pid && pid <= pidlist[pid_j] + .5) {
+                    skip = true;
+                    break;
+                }
+            }
+            if (!skip) pidlist[(*pidlist_size)++] = pid;
+        }
+    }
+    free(recv);
+
+    return 0;
+}
+
 /** run() function of the program. Check USAGE_MESSAGE for details. */
 static int run(
         char *thrown_filename, char *simul_filename, char *data_dir,
@@ -276,26 +329,34 @@ static int run(
         rge_errno = RGEERR_BADSIMFILE;
         return 1;
     }
+    if (rge_attach_kinematics(simul_file, simul)) return 1;
+    bool simul_skimmed = rge_read_dis_skim(simul_file);
+    if (simul_skimmed) {
+        printf("Simulated events file is DIS-skimmed, skipping DIS cuts.\n");
+    }
 
-    // Create output file.
+    // Create output file. Only rank 0 writes to it.
     char out_filename[PATH_MAX];
     sprintf(out_filename, "%s/acc_corr.txt", data_dir);
-    if (!access(out_filename, F_OK)) {
-        rge_errno = RGEERR_OUTFILEEXISTS;
-        return 1;
-    }
-    FILE *out_file = fopen(out_filename, "w");
+    FILE *out_file = NULL;
+    if (rge_dist_rank() == 0) {
+        if (!access(out_filename, F_OK)) {
+            rge_errno = RGEERR_OUTFILEEXISTS;
+            return 1;
+        }
+        out_file = fopen(out_filename, "w");
 
-    // Write binning nedges to output file.
-    for (int bi = 0; bi < 5; ++bi) fprintf(out_file, "%lu ", nedges[bi]);
-    fprintf(out_file, "\n");
+        // Write binning nedges to output file.
+        for (int bi = 0; bi < 5; ++bi) fprintf(out_file, "%lu ", nedges[bi]);
+        fprintf(out_file, "\n");
 
-    // Write edges to output file.
-    for (int bi = 0; bi < 5; ++bi) {
-        for (luint bii = 0; bii < nedges[bi]; ++bii) {
-            fprintf(out_file, "%12.9f ", edges[bi][bii]);
+        // Write edges to output file.
+        for (int bi = 0; bi < 5; ++bi) {
+            for (luint bii = 0; bii < nedges[bi]; ++bii) {
+                fprintf(out_file, "%12.9f ", edges[bi][bii]);
+            }
+            fprintf(out_file, "\n");
         }
-        fprintf(out_file, "\n");
     }
 
     // Get list of PIDs.
@@ -310,7 +371,10 @@ static int run(
     // Add electron to PID list.
     pidlist[pidlist_size++] = 11;
 
-    for (int evn = 0; evn < thrown->GetEntries(); ++evn) {
+    // Each rank looks for PIDs in its shard of the thrown tree.
+    lint first_evn, last_evn;
+    rge_dist_shard(thrown->GetEntries(), &first_evn, &last_evn);
+    for (lint evn = first_evn; evn < last_evn; ++evn) {
         thrown->GetEntry(evn);
         bool skip = false;
 
@@ -336,12 +400,17 @@ static int run(
         pidlist[pidlist_size++] = s_pid;
     }
 
+    // Join the lists of PIDs found by all ranks.
+    join_pidlists(pidlist, &pidlist_size);
+
     // Write list of PIDs to output file.
-    fprintf(out_file, "%d\n", pidlist_size);
-    for (int pid_i = 0; pid_i < pidlist_size; ++pid_i) {
-        fprintf(out_file, "%d ", static_cast<int>(pidlist[pid_i]));
+    if (rge_dist_rank() == 0) {
+        fprintf(out_file, "%d\n", pidlist_size);
+        for (int pid_i = 0; pid_i < pidlist_size; ++pid_i) {
+            fprintf(out_file, "%d ", static_cast<int>(pidlist[pid_i]));
+        }
+        fprintf(out_file, "\n");
     }
-    fprintf(out_file, "\n");
 
     // Get number of bins.
     luint nbins[5];
@@ -359,12 +428,13 @@ static int run(
         if (pid_i == 0) { // electron.
             err = count_entries(
                     out_file, thrown_el, pid, nbins, edges, in_deg,
-                    THROWN_ELECTRON
+                    THROWN_ELECTRON, false
             );
         }
         else {
             err = count_entries(
-                    out_file, thrown, pid, nbins, edges, in_deg, THROWN_HADRON
+                    out_file, thrown, pid, nbins, edges, in_deg, THROWN_HADRON,
+                    false
             );
         }
         if (err != 0) return 1;
@@ -372,12 +442,14 @@ static int run(
         printf("  Counting simulated events...\n");
         if (pid_i == 0) {
             err = count_entries(
-                    out_file, simul, pid, nbins, edges, false, SIMUL_ELECTRON
+                    out_file, simul, pid, nbins, edges, false, SIMUL_ELECTRON,
+                    simul_skimmed
             );
         }
         else {
             err = count_entries(
-                    out_file, simul, pid, nbins, edges, false, SIMUL_HADRON
+                    out_file, simul, pid, nbins, edges, false, SIMUL_HADRON,
+                    simul_skimmed
             );
         }
         if (err != 0) return 1;
@@ -388,7 +460,7 @@ static int run(
     // Clean up after ourselves.
     thrown_file->Close();
     simul_file->Close();
-    fclose(out_file);
+    if (out_file != NULL) fclose(out_file);
     for (int bi = 0; bi < 5; ++bi) free(edges[bi]);
     free(edges);
 
@@ -489,6 +561,8 @@ static int handle_args(
 
 /** Entry point of the program. */
 int main(int argc, char **argv) {
+    rge_dist_init(&argc, &argv);
+
     // Handle arguments.
     char *thrown_filename = NULL;
     char *simul_filename  = NULL;
@@ -514,5 +588,5 @@ int main(int argc, char **argv) {
     if (data_dir        != NULL) free(data_dir);
 
     // Return errcode.
-    return rge_print_usage(USAGE_MESSAGE);
+    return rge_dist_finalize(rge_print_usage(USAGE_MESSAGE));
 }
@@ -0,0 +1,631 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+// C.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// C++.
+#include <chrono>
+#include <random>
+#include <vector>
+
+// ROOT.
+#include <TMemFile.h>
+#include <TNtuple.h>
+#include <TTree.h>
+
+// HIPO.
+#include "bank.h"
+
+// rge-analysis.
+#include "../lib/rge_constants.h"
+#include "../lib/rge_err_handler.h"
+#include "../lib/rge_file_handler.h"
+#include "../lib/rge_hipo_bank.h"
+#include "../lib/rge_io_handler.h"
+#include "../lib/rge_math_utils.h"
+#include "../lib/rge_particle.h"
+#include "../lib/rge_shm_cache.h"
+
+static const char *USAGE_MESSAGE =
+"Usage: benchmark [-hn:r:]\n"
+" * -h       : show this message and exit.\n"
+" * -n nops  : number of calls per repetition. Default is 1000000. Bank\n"
+"              reads are capped to one pass over the synthetic tree.\n"
+" * -r nreps : number of timed repetitions. Default is 10.\n\n"
+"    Run micro-benchmarks of the library kernels called in the per-event\n"
+"    loops of the analysis programs. Inputs are synthetic and generated with\n"
+"    a fixed seed, so results are reproducible in a given machine. For each\n"
+"    kernel, the mean, standard deviation, and minimum time per call across\n"
+"    repetitions are reported in ns/op. Bank reads are timed per event, both\n"
+"    one event at a time and in batches, from a tree in a memory file.\n\n"
+"    Before timing, 64-bit counts and event numbers are checked to survive\n"
+"    a round trip through the formats that store them: acceptance correction\n"
+"    counts above 2^31 through the acc_corr file and the shared-memory cache,\n"
+"    and event numbers above 2^24 through the evn64 ntuples branch.\n";
+
+/** Number of synthetic inputs generated per kernel. Must be a power of 2. */
+#define NINPUTS 4096
+/** Number of rows in each synthetic hipo bank. */
+#define NROWS   12
+/** Number of bins for each binning variable used by the binning kernels. */
+#define NBINS   10
+/** Number of binning variables used by rge_find_idx(). */
+#define NDIMS   3
+/** Number of events in the synthetic tree read by the bank read kernels. */
+#define NEVENTS (16 * RGE_BATCHNEVENTS)
+
+/** Counts and event numbers used by the round-trip checks. */
+static const lint ROUNDTRIP_COUNTS[] = {
+        (1L << 31) + 1, (1L << 32) + 3, (1L << 40) + 5, 7
+};
+static const lint ROUNDTRIP_EVNS[] = {
+        (1L << 24) + 1, (1L << 31) + 3, (1L << 40) + 5
+};
+
+/** Sink where kernel outputs are written so that calls are not optimized. */
+static volatile double sink;
+
+/**
+ * Time a kernel nreps times, calling it nops times per repetition, and print
+ *     the mean, standard deviation, and minimum time per call. One untimed
+ *     repetition is run first to warm up caches and branch predictors.
+ *
+ * @param name   : name of the kernel, printed in the report.
+ * @param nops   : number of calls per repetition.
+ * @param nreps  : number of timed repetitions.
+ * @param kernel : callable taking the call index and returning a double.
+ * @return       : error code. Always 0.
+ */
+template <typename F>
+static int time_kernel(const char *name, luint nops, luint nreps, F kernel) {
+    double acc = 0;
+    for (luint op = 0; op < nops; ++op) acc += kernel(op);
+
+    std::vector<double> ns_per_op(nreps);
+    for (luint rep = 0; rep < nreps; ++rep) {
+        auto start = std::chrono::steady_clock::now();
+        for (luint op = 0; op < nops; ++op) acc += kernel(op);
+        auto end = std::chrono::steady_clock::now();
+
+        ns_per_op[rep] = static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        end - start
+                ).count()
+        ) / static_cast<double>(nops);
+    }
+    sink = acc;
+
+    // Compute statistics.
+    double mean = 0;
+    double min  = ns_per_op[0];
+    for (luint rep = 0; rep < nreps; ++rep) {
+        mean += ns_per_op[rep];
+        if (ns_per_op[rep] < min) min = ns_per_op[rep];
+    }
+    mean /= static_cast<double>(nreps);
+
+    double var = 0;
+    for (luint rep = 0; rep < nreps; ++rep) {
+        var += (ns_per_op[rep] - mean) * (ns_per_op[rep] - mean);
+    }
+    if (nreps > 1) var /= static_cast<double>(nreps - 1);
+
+    printf("%-32s %12.2f %12.2f %12.2f\n", name, mean, sqrt(var), min);
+
+    return 0;
+}
+
+/**
+ * Fill a hipo bank and its rge_hipobank counterpart with the same synthetic
+ *     data. Bytes are drawn from {-1, 0, 1}, shorts from [0, NROWS) so that
+ *     they can be used as indices, ints from a list of common PIDs, and floats
+ *     uniformly from [0.05, 5).
+ *
+ * @param rb   : rge_hipobank to fill. Its data vectors are allocated here.
+ * @param hb   : hipo bank to fill.
+ * @param name : name of the hipo bank, as defined in rge_hipo_bank.h.
+ * @param rng  : random number generator.
+ * @return     : error code. 0 if successful, 1 otherwise.
+ */
+static int fill_synthetic_bank(
+        rge_hipobank *rb, hipo::bank *hb, const char *name, std::mt19937 *rng
+) {
+    static const int PIDS[] = {11, -211, 211, 2212, 22, 2112, 0};
+    std::uniform_int_distribution<int> byte_dist(-1, 1);
+    std::uniform_int_distribution<int> short_dist(0, NROWS - 1);
+    std::uniform_int_distribution<int> int_dist(0, 6);
+    std::uniform_real_distribution<float> float_dist(.05, 5.);
+
+    *rb = rge_hipobank_init(name);
+    if (rge_errno == RGEERR_INVALIDBANKID) return 1;
+
+    // Build schema from the bank's entries.
+    std::string format;
+    std::map<const char *, rge_hipoentry, cmp_str>::iterator entry_it;
+    for (
+            entry_it = rb->entries.begin(); entry_it != rb->entries.end();
+            ++entry_it
+    ) {
+        if (!format.empty()) format += ",";
+        format += entry_it->first;
+        switch (entry_it->second.type) {
+            case BYTE:  format += "/B"; break;
+            case SHORT: format += "/S"; break;
+            case INT:   format += "/I"; break;
+            case FLOAT: format += "/F"; break;
+            default:
+                rge_errno = RGEERR_UNSUPPORTEDTYPE;
+                return 1;
+        }
+        entry_it->second.data = new std::vector<double>(NROWS);
+    }
+    hipo::schema schema(name, 300, 1);
+    schema.parse(format);
+    *hb = hipo::bank(schema, NROWS);
+    rb->nrows = NROWS;
+
+    // Fill data.
+    for (int row = 0; row < NROWS; ++row) {
+        for (
+                entry_it = rb->entries.begin(); entry_it != rb->entries.end();
+                ++entry_it
+        ) {
+            const char *key = entry_it->first;
+            double val = 0;
+            switch (entry_it->second.type) {
+                case BYTE:
+                    val = byte_dist(*rng);
+                    hb->putByte(key, row, static_cast<int8_t>(val));
+                    break;
+                case SHORT:
+                    val = short_dist(*rng);
+                    hb->putShort(key, row, static_cast<int16_t>(val));
+                    break;
+                case INT:
+                    val = PIDS[int_dist(*rng)];
+                    hb->putInt(key, row, static_cast<int>(val));
+                    break;
+                case FLOAT:
+                    val = float_dist(*rng);
+                    hb->putFloat(key, row, static_cast<float>(val));
+                    break;
+                default:
+                    rge_errno = RGEERR_UNSUPPORTEDTYPE;
+                    return 1;
+            }
+            entry_it->second.data->at(static_cast<luint>(row)) = val;
+        }
+    }
+
+    return 0;
+}
+
+/** Free the data vectors allocated by fill_synthetic_bank(). */
+static int free_synthetic_bank(rge_hipobank *rb) {
+    std::map<const char *, rge_hipoentry, cmp_str>::iterator entry_it;
+    for (
+            entry_it = rb->entries.begin(); entry_it != rb->entries.end();
+            ++entry_it
+    ) {
+        delete entry_it->second.data;
+        entry_it->second.data = nullptr;
+    }
+
+    return 0;
+}
+
+/**
+ * Write NEVENTS events of a synthetic REC::Particle bank to t, in the same
+ *     format produced by hipo2root, with 1 to NROWS rows each.
+ *
+ * @param t   : tree to fill.
+ * @param rng : random number generator.
+ * @return    : error code. Always 0.
+ */
+static int fill_synthetic_tree(TTree *t, std::mt19937 *rng) {
+    std::uniform_int_distribution<luint> nrows_dist(1, NROWS);
+    std::uniform_real_distribution<double> val_dist(.05, 5.);
+
+    rge_hipobank b = rge_hipobank_init(RGE_RECPARTICLE);
+    std::map<const char *, rge_hipoentry, cmp_str>::iterator entry_it;
+    for (
+            entry_it = b.entries.begin(); entry_it != b.entries.end();
+            ++entry_it
+    ) {
+        entry_it->second.data = new std::vector<double>();
+    }
+    rge_link_branches(&b, t);
+
+    for (luint evn = 0; evn < NEVENTS; ++evn) {
+        luint nrows = nrows_dist(*rng);
+        for (
+                entry_it = b.entries.begin(); entry_it != b.entries.end();
+                ++entry_it
+        ) {
+            entry_it->second.data->resize(nrows);
+            for (luint row = 0; row < nrows; ++row) {
+                entry_it->second.data->at(row) = val_dist(*rng);
+            }
+        }
+        t->Fill();
+    }
+    t->Write();
+    t->ResetBranchAddresses();
+    free_synthetic_bank(&b);
+
+    return 0;
+}
+
+/**
+ * Check that acceptance correction counts above 2^31 are read back exactly
+ *     by rge_read_acc_corr_file(), both from the file, written as acc_corr
+ *     does, and from the shared-memory cache filled by that first read. The
+ *     file and the cache segment are removed afterwards.
+ *
+ * @return : error code. 0 if successful, 1 otherwise.
+ */
+static int check_acc_corr_roundtrip() {
+    // Write file with 2 bins and 1 PID, in the format written by acc_corr.
+    char filename[] = "/tmp/rge_benchmark_acc_corr_XXXXXX";
+    int fd = mkstemp(filename);
+    if (fd < 0) {
+        rge_errno = RGEERR_BADINPUTFILE;
+        return 1;
+    }
+    FILE *file = fdopen(fd, "w");
+    luint nedges[5] = {2, 2, 2, 2, 3};
+    for (int bi = 0; bi < 5; ++bi) fprintf(file, "%lu ", nedges[bi]);
+    fprintf(file, "\n");
+    for (int bi = 0; bi < 5; ++bi) {
+        for (luint bii = 0; bii < nedges[bi]; ++bii) {
+            fprintf(file, "%12.9f ", static_cast<double>(bii));
+        }
+        fprintf(file, "\n");
+    }
+    fprintf(file, "%d\n%d \n", 1, 211);
+    for (int line_i = 0; line_i < 2; ++line_i) {
+        for (int bin_i = 0; bin_i < 2; ++bin_i) {
+            fprintf(file, "%ld ", ROUNDTRIP_COUNTS[2*line_i + bin_i]);
+        }
+        fprintf(file, "\n");
+    }
+    fclose(file);
+
+    // The first read parses the file and publishes it, and the second one
+    //     attaches to the published segment.
+    setenv("RGE_SHMCACHE", "1", 0);
+    bool ok = true;
+    for (int read_i = 0; read_i < 2 && ok; ++read_i) {
+        luint bin_nedges[5];
+        double **bin_edges;
+        luint pids_size, nbins;
+        lint *pids;
+        lint **n_thrown, **n_simul;
+        if (rge_read_acc_corr_file(
+                filename, bin_nedges, &bin_edges, &pids_size, &nbins, &pids,
+                &n_thrown, &n_simul
+        )) {
+            ok = false;
+            break;
+        }
+
+        ok = pids_size == 1 && nbins == 2 && pids[0] == 211 &&
+                rge_shm_owns(bin_edges[0]) == (read_i == 1);
+        for (luint bin_i = 0; bin_i < nbins && ok; ++bin_i) {
+            ok = n_thrown[0][bin_i] == ROUNDTRIP_COUNTS[bin_i] &&
+                    n_simul[0][bin_i] == ROUNDTRIP_COUNTS[2 + bin_i];
+        }
+        printf(
+                "acc_corr counts from %-14s %s\n",
+                read_i == 0 ? "file:" : "shared memory:", ok ? "ok" : "FAILED"
+        );
+        rge_free_acc_corr(bin_edges, pids_size, pids, n_thrown, n_simul);
+    }
+
+    rge_shm_remove("acc", filename);
+    unlink(filename);
+    if (!ok) {
+        if (rge_errno == RGEERR_UNDEFINED) rge_errno = RGEERR_BADROUNDTRIP;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Check that event numbers above 2^24 are read back exactly from the evn64
+ *     branch of an ntuple, written as make_ntuples does and read as
+ *     draw_plots and pt_broadening do.
+ *
+ * @return : error code. 0 if successful, 1 otherwise.
+ */
+static int check_evn64_roundtrip() {
+    TMemFile f("rge_benchmark_evn64.root", "RECREATE");
+    TNtuple *t = new TNtuple(
+            RGE_TREENAMEDATA, RGE_TREENAMEDATA, RGE_VARS[RGE_EVENTNO.addr]
+    );
+    Long64_t evn64_out = 0;
+    t->Branch(RGE_EVENTNO64, &evn64_out, RGE_EVENTNO64 "/L");
+    for (lint evn : ROUNDTRIP_EVNS) {
+        Float_t evn_f = static_cast<Float_t>(evn);
+        evn64_out = evn;
+        t->Fill(&evn_f);
+    }
+    t->Write();
+    t->ResetBranchAddresses();
+
+    Long64_t evn64 = 0;
+    bool ok = t->GetBranch(RGE_EVENTNO64) != NULL;
+    if (ok) t->SetBranchAddress(RGE_EVENTNO64, &evn64);
+    for (lint entry = 0; entry < t->GetEntries() && ok; ++entry) {
+        t->GetEntry(entry);
+        ok = static_cast<lint>(evn64) == ROUNDTRIP_EVNS[entry];
+    }
+    printf("%-35s %s\n", "evn64 event numbers:", ok ? "ok" : "FAILED");
+    f.Close();
+
+    if (!ok) {
+        rge_errno = RGEERR_BADROUNDTRIP;
+        return 1;
+    }
+    return 0;
+}
+
+/** run() function of the program. Check USAGE_MESSAGE for details. */
+static int run(luint nops, luint nreps) {
+    std::mt19937 rng(20230101);
+    std::uniform_real_distribution<double> unit_dist(0., 1.);
+    std::uniform_int_distribution<uint> row_dist(0, NROWS - 1);
+    const luint MASK = NINPUTS - 1;
+
+    // Round-trip checks.
+    if (check_acc_corr_roundtrip()) return 1;
+    if (check_evn64_roundtrip())    return 1;
+    printf("\n");
+
+    // Synthetic banks.
+    rge_hipobank bpart, btrk, bfmt;
+    hipo::bank hpart, htrk, hfmt;
+    if (fill_synthetic_bank(&bpart, &hpart, RGE_RECPARTICLE, &rng)) return 1;
+    if (fill_synthetic_bank(&btrk,  &htrk,  RGE_RECTRACK,    &rng)) return 1;
+    if (fill_synthetic_bank(&bfmt,  &hfmt,  RGE_FMTTRACKS,   &rng)) return 1;
+
+    // Synthetic inputs.
+    static const char *GETVARS[] = {"px", "py", "pz", "vz", "beta"};
+    std::vector<const char *> vars(NINPUTS);
+    std::vector<uint> rows(NINPUTS);
+    std::vector<double> vecs(6 * NINPUTS);
+    std::vector<double> energies(3 * NINPUTS);
+    std::vector<int> nphes(NINPUTS);
+    std::vector<rge_particle> parts(NINPUTS);
+    for (luint i = 0; i < NINPUTS; ++i) {
+        vars[i]  = GETVARS[i % 5];
+        rows[i]  = row_dist(rng);
+        nphes[i] = static_cast<int>(10 * unit_dist(rng));
+        for (luint j = 0; j < 6; ++j) vecs[6*i + j] = 2*unit_dist(rng) - 1;
+        for (luint j = 0; j < 3; ++j) energies[3*i + j] = .5*unit_dist(rng);
+
+        parts[i] = rge_particle_init(&bpart, &btrk, &bfmt, rows[i], 0);
+        parts[i].charge = static_cast<int>(3*unit_dist(rng)) - 1;
+        parts[i].pz     = 1 + 8*unit_dist(rng);
+    }
+
+    // Electron and hadrons with PID already set, to fill ntuples.
+    rge_particle electron = parts[0];
+    electron.pid = 11;
+    electron.charge = -1;
+    electron.is_trigger = true;
+    if (rge_get_mass(electron.pid, &(electron.mass))) return 1;
+
+    std::vector<rge_particle> hadrons(NINPUTS);
+    for (luint i = 0; i < NINPUTS; ++i) {
+        hadrons[i] = parts[i];
+        hadrons[i].pid = 211;
+        hadrons[i].charge = 1;
+        hadrons[i].is_hadron = true;
+        if (rge_get_mass(hadrons[i].pid, &(hadrons[i].mass))) return 1;
+    }
+
+    // Sampling fraction parameters, roughly the ones found in RG-E data.
+    double sf_params[RGE_NSFPARAMS][2] = {
+            {.25, .01}, {1.0, 1.0}, {-.005, .01}, {.0001, .001}
+    };
+
+    // Binning inputs.
+    double edges[NBINS + 1];
+    for (luint i = 0; i <= NBINS; ++i) edges[i] = static_cast<double>(i)/NBINS;
+    luint nbins[NDIMS];
+    double range[NDIMS][2];
+    double binsize[NDIMS];
+    for (luint di = 0; di < NDIMS; ++di) {
+        nbins[di]    = NBINS;
+        range[di][0] = 0.;
+        range[di][1] = 1.;
+        binsize[di]  = (range[di][1] - range[di][0]) / NBINS;
+    }
+    std::vector<float> points(NDIMS * NINPUTS);
+    for (luint i = 0; i < NDIMS * NINPUTS; ++i) {
+        points[i] = static_cast<float>(1.1*unit_dist(rng) - .05);
+    }
+
+    // Run benchmarks.
+    printf("%lu repetitions of %lu calls each, ns/op.\n", nreps, nops);
+    printf("%-32s %12s %12s %12s\n", "kernel", "mean", "stddev", "min");
+
+    time_kernel("rge_get_double", nops, nreps, [&](luint op) {
+        luint i = op & MASK;
+        return rge_get_double(&bpart, vars[i], rows[i]);
+    });
+
+    time_kernel("rge_fill (REC::Particle)", nops, nreps, [&](luint) {
+        rge_fill(&bpart, hpart);
+        return static_cast<double>(bpart.nrows);
+    });
+
+    // Bank reads, compared on the same events. Batches start at multiples of
+    //     RGE_BATCHNEVENTS, as in the programs using them.
+    TMemFile f_bench("rge_benchmark.root", "RECREATE");
+    TTree *t_bench = new TTree("Tree", "Tree");
+    fill_synthetic_tree(t_bench, &rng);
+    rge_hipobank bread = rge_hipobank_init(RGE_RECPARTICLE, t_bench);
+    rge_hipobatch batch = rge_hipobatch_init();
+    luint nreads = nops < NEVENTS ? nops : NEVENTS;
+
+    time_kernel("rge_get_entries", nreads, nreps, [&](luint op) {
+        rge_get_entries(&bread, t_bench, static_cast<lint>(op));
+        double px = 0;
+        for (luint row = 0; row < bread.nrows; ++row) {
+            px += rge_get_double(&bread, "px", row);
+        }
+        return px;
+    });
+
+    time_kernel("rge_get_batch", nreads, nreps, [&](luint op) {
+        lint evn = static_cast<lint>(op);
+        if (evn % RGE_BATCHNEVENTS == 0) {
+            lint size = static_cast<lint>(nreads) - evn;
+            if (size > RGE_BATCHNEVENTS) size = RGE_BATCHNEVENTS;
+            rge_get_batch(&bread, t_bench, evn, size, &batch);
+        }
+        rge_select_event(&bread, &batch, evn);
+        double px = 0;
+        for (luint row = 0; row < bread.nrows; ++row) {
+            px += rge_get_double(&bread, "px", row);
+        }
+        return px;
+    });
+    f_bench.Close();
+
+    time_kernel("rge_particle_init (DC)", nops, nreps, [&](luint op) {
+        rge_particle p = rge_particle_init(
+                &bpart, &btrk, &bfmt, rows[op & MASK], 0
+        );
+        return p.pz;
+    });
+
+    time_kernel("rge_particle_init (DC+FMT)", nops, nreps, [&](luint op) {
+        rge_particle p = rge_particle_init(
+                &bpart, &btrk, &bfmt, rows[op & MASK], 2
+        );
+        return p.is_valid ? p.pz : 0.;
+    });
+
+    time_kernel("rge_set_pid", nops, nreps, [&](luint op) {
+        luint i = op & MASK;
+        rge_particle p = parts[i];
+        rge_set_pid(
+                &p, 0, -1, energies[3*i] + energies[3*i+1] + energies[3*i+2],
+                energies[3*i], nphes[i], nphes[i], sf_params
+        );
+        return static_cast<double>(p.pid);
+    });
+
+    // Kernels above might leave rge_errno set, which rge_fill_ntuples_arr()
+    //     checks.
+    rge_errno = RGEERR_UNDEFINED;
+    Float_t arr[RGE_VARS_SIZE];
+    time_kernel("rge_fill_ntuples_arr", nops, nreps, [&](luint op) {
+        luint i = op & MASK;
+        rge_fill_ntuples_arr(
+                arr, hadrons[i], electron, 12933, static_cast<int>(op), 1,
+                10.6, 1.5, 12, energies[3*i], energies[3*i+1],
+                energies[3*i+2], 20., 19., nphes[i], nphes[i]
+        );
+        return static_cast<double>(arr[RGE_PT2.addr]);
+    });
+
+    time_kernel("rge_calc_angle", nops, nreps, [&](luint op) {
+        double *v = &(vecs[6 * (op & MASK)]);
+        return rge_calc_angle(v[0], v[1], v[2], v[3], v[4], v[5]);
+    });
+
+    time_kernel("rge_rotate_y", nops, nreps, [&](luint op) {
+        double *v = &(vecs[6 * (op & MASK)]);
+        double x = v[0], z = v[2];
+        rge_rotate_y(&x, &z, v[3]);
+        return x + z;
+    });
+
+    time_kernel("rge_rotate_z", nops, nreps, [&](luint op) {
+        double *v = &(vecs[6 * (op & MASK)]);
+        double x = v[0], y = v[1];
+        rge_rotate_z(&x, &y, v[3]);
+        return x + y;
+    });
+
+    time_kernel("rge_find_pos", nops, nreps, [&](luint op) {
+        return static_cast<double>(
+                rge_find_pos(points[op & MASK], edges, NBINS)
+        );
+    });
+
+    time_kernel("rge_find_idx", nops, nreps, [&](luint op) {
+        return static_cast<double>(rge_find_idx(
+                NDIMS, 0, &(points[NDIMS * (op & MASK)]), nbins, range, binsize
+        ));
+    });
+
+    // Clean up.
+    free_synthetic_bank(&bpart);
+    free_synthetic_bank(&btrk);
+    free_synthetic_bank(&bfmt);
+
+    rge_errno = RGEERR_NOERR;
+    return 0;
+}
+
+/** Handle arguments for benchmark using optarg. */
+static int handle_args(int argc, char **argv, lint *nops, lint *nreps) {
+    // Handle arguments.
+    int opt;
+    while ((opt = getopt(argc, argv, "-hn:r:")) != -1) {
+        switch (opt) {
+            case 'h':
+                rge_errno = RGEERR_USAGE;
+                return 1;
+            case 'n':
+                if (rge_process_nentries(nops, optarg)) return 1;
+                break;
+            case 'r':
+                if (rge_process_nreps(nreps, optarg)) return 1;
+                break;
+            default:
+                rge_errno = RGEERR_BADOPTARGS;
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+/** Entry point of the program. */
+int main(int argc, char **argv) {
+    // Handle arguments.
+    lint nops  = 1000000;
+    lint nreps = 10;
+
+    int err = handle_args(argc, argv, &nops, &nreps);
+
+    // Run.
+    if (rge_errno == RGEERR_UNDEFINED && err == 0) {
+        run(static_cast<luint>(nops), static_cast<luint>(nreps));
+    }
+
+    // Return errcode.
+    return rge_print_usage(USAGE_MESSAGE);
+}
@@ -0,0 +1,154 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+// C.
+#include <stdio.h>
+#include <unistd.h>
+
+// C++.
+#include <set>
+
+// rge-analysis.
+#include "../lib/rge_err_handler.h"
+#include "../lib/rge_io_handler.h"
+#include "../lib/rge_trace.h"
+
+static const char *USAGE_MESSAGE =
+"Usage: decode_trace [-he:] tracefile\n"
+" * -h        : show this message and exit.\n"
+" * -e evn    : only print records from event number evn. Can be given more\n"
+"               than once.\n"
+" * tracefile : binary trace file written by make_ntuples -t or -e.\n\n"
+"    Print the records of a make_ntuples debug trace, one per line, followed\n"
+"    by the number of records of each kind. Cut records show the particle's\n"
+"    sector and momentum, and PID records also show the PID assigned, the PID\n"
+"    from the Event Builder, the status, the energy deposited in PCAL, ECIN,\n"
+"    and ECOU, and the number of photoelectrons in HTCC and LTCC.\n";
+
+/** Names of the stages where records are written, by stage number. */
+static const char *STAGE_NAMES[2] = {"search", "particles"};
+
+/** Print one trace record. */
+static int print_record(rge_tracerecord *r) {
+    const char *stage = (r->stage == RGE_TRACESEARCH ||
+            r->stage == RGE_TRACEPARTICLES) ? STAGE_NAMES[r->stage] : "unknown";
+
+    printf(
+            "%12ld  %-9s  %-8s  pindex %3d  sector %2d  p %7.3f",
+            static_cast<lint>(r->evn), stage, rge_trace_kind_name(r->kind),
+            r->pindex, r->sector, r->p
+    );
+    if (r->kind == RGE_TRACEMATCH) {
+        printf(
+                "  pid %5d (EB %5d)  status %5d  E %.3f/%.3f/%.3f  "
+                "nphe %d/%d", r->pid, r->recon_pid, r->status, r->energy_pcal,
+                r->energy_ecin, r->energy_ecou, r->nphe_htcc, r->nphe_ltcc
+        );
+    }
+    printf("\n");
+
+    return 0;
+}
+
+/** run() function of the program. Check USAGE_MESSAGE for details. */
+static int run(char *filename, std::set<lint> *events) {
+    FILE *f = fopen(filename, "rb");
+    if (f == NULL) {
+        rge_errno = RGEERR_BADINPUTFILE;
+        return 1;
+    }
+    if (rge_trace_read_header(f)) {
+        fclose(f);
+        return 1;
+    }
+
+    // Print records.
+    luint counts[RGE_TRACENKINDS + 1];
+    for (int kind = 0; kind <= RGE_TRACENKINDS; ++kind) counts[kind] = 0;
+    rge_tracerecord r;
+    while (fread(&r, sizeof(r), 1, f) == 1) {
+        if (events->size() > 0 && events->count(r.evn) == 0) continue;
+        print_record(&r);
+
+        // Unknown kinds are counted in the last slot.
+        if (r.kind >= 0 && r.kind < RGE_TRACENKINDS) ++counts[r.kind];
+        else ++counts[RGE_TRACENKINDS];
+    }
+    fclose(f);
+
+    // Print summary.
+    printf("\nRecords by kind:\n");
+    for (int kind = 0; kind < RGE_TRACENKINDS; ++kind) {
+        printf("    %-8s : %lu\n", rge_trace_kind_name(kind), counts[kind]);
+    }
+    if (counts[RGE_TRACENKINDS] > 0) {
+        printf("    %-8s : %lu\n", "unknown", counts[RGE_TRACENKINDS]);
+    }
+
+    rge_errno = RGEERR_NOERR;
+    return 0;
+}
+
+/** Handle arguments for decode_trace using optarg. */
+static int handle_args(
+        int argc, char **argv, char **filename, std::set<lint> *events
+) {
+    // Handle arguments.
+    int opt;
+    lint evn;
+    while ((opt = getopt(argc, argv, "-he:")) != -1) {
+        switch (opt) {
+            case 'h':
+                rge_errno = RGEERR_USAGE;
+                return 1;
+            case 'e':
+                if (rge_process_evn(&evn, optarg)) return 1;
+                events->insert(evn);
+                break;
+            case 1:
+                rge_grab_string(optarg, filename);
+                break;
+            default:
+                rge_errno = RGEERR_BADOPTARGS;
+                return 1;
+        }
+    }
+
+    // Check positional argument.
+    if (*filename == NULL) {
+        rge_errno = RGEERR_NOINPUTFILE;
+        return 1;
+    }
+
+    return 0;
+}
+
+/** Entry point of the program. */
+int main(int argc, char **argv) {
+    // Handle arguments.
+    char *filename = NULL;
+    std::set<lint> events;
+
+    int err = handle_args(argc, argv, &filename, &events);
+
+    // Run.
+    if (rge_errno == RGEERR_UNDEFINED && err == 0) run(filename, &events);
+
+    // Free up memory.
+    if (filename != NULL) free(filename);
+
+    // Return errcode.
+    return rge_print_usage(USAGE_MESSAGE);
+}
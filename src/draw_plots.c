@@ -17,6 +17,9 @@
 #include <limits.h>
 #include <libgen.h>
 
+// C++.
+#include <vector>
+
 // ROOT.
 #include <TFile.h>
 #include <TH2.h>
@@ -24,17 +27,25 @@
 
 // rge-analysis.
 #include "../lib/rge_constants.h"
+#include "../lib/rge_dist.h"
 #include "../lib/rge_err_handler.h"
 #include "../lib/rge_io_handler.h"
 #include "../lib/rge_progress.h"
 #include "../lib/rge_pid_utils.h"
 #include "../lib/rge_filename_handler.h"
+#include "../lib/rge_grid_utils.h"
 #include "../lib/rge_math_utils.h"
+#include "../lib/rge_metadata.h"
 
 static const char *USAGE_MESSAGE =
-"Usage: draw_plots [-hp:cb:n:o:a:w:] infile\n"
+"Usage: draw_plots [-hp:P:cb:n:o:a:ASw:] infile\n"
 " * -h          : show this message and exit.\n"
 " * -p pid      : skip particle selection and draw plots for pid.\n"
+" * -P sel,...  : draw the same plots for a comma-separated list of particle\n"
+"                 selections, reading the input once. Selections are all,\n"
+"                 +, -, neutral, or a PID, and the plots of each go to\n"
+"                 their own directory: all, positive, negative, neutral,\n"
+"                 or pid_<pid>. Can't be used with -p.\n"
 " * -c          : apply all cuts (general, geometry, and DIS) instead of\n"
 "                 asking which ones to apply while running.\n"
 " * -b # # # #  : apply 1D binning. Four integers are required: index of the\n"
@@ -46,6 +57,10 @@ static const char *USAGE_MESSAGE =
 " * -a accfile  : apply acceptance correction using acc_filename.\n"
 " * -A          : get acceptance correction plots without applying acceptance\n"
 "                 correction. Requires -a to be set.\n"
+" * -S          : store each plot as one THnSparse containing all bins of the\n"
+"                 binning grid, instead of writing one directory per bin.\n"
+"                 Plots for a particular bin can be extracted with\n"
+"                 rge_grid_project() from lib/rge_grid_utils.h.\n"
 " * -w workdir  : location where output root files are to be stored. Default\n"
 "                 is root_io.\n"
 " * infile      : input file produced by make_ntuples.\n\n"
@@ -62,6 +77,28 @@ static const char *PART_LIST[PART_LIST_SIZE] = {
         "all", "+", "-", "neutral", "pid"
 };
 
+/**
+ * Output directories of the selections in PART_LIST, when using -P. A_PPID
+ *     selections use "pid_<pid>" instead.
+ */
+static const char *PART_DIRS[PART_LIST_SIZE] = {
+        "all", "positive", "negative", "neutral", "pid"
+};
+
+/**
+ * Particle selection. Fields set to INT_MAX don't restrict the selection.
+ *
+ * @param charge : charge of the selected particles.
+ * @param pid    : PID of the selected particles.
+ * @param dir    : output directory of the selection's plots. Empty if plots
+ *                 are written at the top of the output file.
+ */
+typedef struct {
+    int charge;
+    int pid;
+    char dir[32];
+} part_sel;
+
 /** Plotting opts arrays. */
 static const char *PLT_LIST[2] = {"1d", "2d"};
 static const char *DIM_LIST[2] = {"x", "y"};
@@ -289,58 +326,52 @@ static int find_bin(
 }
 
 /**
- * Find index of plot in array, recursively going through binnings.
- *
- *     INTERNAL PARAMETERS.
- * @param dim_bins: Binning dimension. Needed to compute how deep the recursion
- *                  should go before stopping.
- * @param depth:    How deep along the number of bins we are. When calling the
- *                  function, this should always be 0.
+ * Parse the comma-separated list of particle selections given to -P.
  *
- *     BINNINGS PAREMETERS.
- * @param var:      Binning variables.
- * @param nbins:    Array with number of dimensions for binning for each
- *                  binning.
- * @param range:    2-dimensional array with lower and upper limits for each
- *                  binning variable.
- * @param binsize:  Array with size of each bin for each binning.
- *
- * @return:         Index of the bin we're looking for. Returns -1 if variable
- *                  is not within binning range.
+ * @param arg  : list of selections.
+ * @param sels : vector where the selections are appended.
+ * @return     : error code. 0 if successful, 1 otherwise.
  */
-static lint find_idx(
-        luint dim_bins, luint depth, Float_t var[], luint nbins[],
-        double range[][2], double binsize[]
-) {
-    if (depth == dim_bins) return 0;
-    for (luint bi = 0; bi < nbins[depth]; ++bi) {
-        // Define bin limits.
-        double low  = range[depth][0] + binsize[depth]* bi;
-        double high = range[depth][0] + binsize[depth]*(bi+1);
-
-        // Find bin for var.
-        if (low < var[depth] && var[depth] < high) {
-            luint dim_factor = 1;
-            for (luint depth_i = depth + 1; depth_i < dim_bins; ++depth_i) {
-                dim_factor *= nbins[depth_i];
+static int parse_selections(char *arg, std::vector<part_sel> *sels) {
+    for (char *tok = strtok(arg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        part_sel sel = {.charge = INT_MAX, .pid = INT_MAX, .dir = ""};
+        int part = A_PPID;
+        for (int part_i = 0; part_i < A_PPID; ++part_i) {
+            if (!strcmp(tok, PART_LIST[part_i])) part = part_i;
+        }
+        if      (part == A_PPOS) sel.charge =  1;
+        else if (part == A_PNEU) sel.charge =  0;
+        else if (part == A_PNEG) sel.charge = -1;
+        else if (part == A_PPID) {
+            lint pid;
+            if (rge_process_pid(&pid, tok) || rge_pid_invalid(pid)) {
+                rge_errno = RGEERR_BADSELECTIONS;
+                return 1;
             }
-            lint idx =
-                    find_idx(dim_bins, depth+1, var, nbins, range, binsize);
-            if (idx < 0) return idx;
-            else return static_cast<lint>(
-                    bi*dim_factor + static_cast<luint>(idx)
-            );
+            sel.pid = static_cast<int>(pid);
+        }
+        if (part == A_PPID) {
+            snprintf(sel.dir, sizeof(sel.dir), "pid_%d", sel.pid);
+        }
+        else {
+            snprintf(sel.dir, sizeof(sel.dir), "%s", PART_DIRS[part]);
         }
+        sels->push_back(sel);
+    }
+    if (sels->size() == 0) {
+        rge_errno = RGEERR_BADSELECTIONS;
+        return 1;
     }
 
-    return -1; // Variable is not within binning range.
+    return 0;
 }
 
 /** run() function of the program. Check USAGE_MESSAGE for details. */
 static int run(
         char *in_filename, char *out_filename, char *acc_filename,
-        char *work_dir, int run_no, lint nentries, lint sel_pid,
-        bool apply_all_cuts, bool apply_acc_corr, lint *binning_setup
+        char *work_dir, int run_no, lint nentries, std::vector<part_sel> *sels,
+        bool apply_all_cuts, bool apply_acc_corr, lint *binning_setup,
+        bool grid_out
 ) {
     // Open input file.
     TFile *f_in  = TFile::Open(in_filename, "READ");
@@ -356,8 +387,8 @@ static int run(
     luint acc_npids;
     double **acc_edges;
     lint *acc_pids;
-    int **acc_n_thrown;
-    int **acc_n_simul;
+    lint **acc_n_thrown;
+    lint **acc_n_simul;
     if (acc_filename != NULL) {
         acc_plot = true;
         if (rge_read_acc_corr_file(
@@ -367,41 +398,45 @@ static int run(
     }
 
     // === PARTICLE SELECTION ==================================================
-    int plot_particle = INT_MAX;
-    int plot_charge   = INT_MAX;
-    int plot_pid      = INT_MAX;
-    if (sel_pid == 0) {
+    // Ask for the particle selection if it wasn't given with -p or -P.
+    if (sels->size() == 0) {
+        part_sel sel = {.charge = INT_MAX, .pid = INT_MAX, .dir = ""};
         printf("\nWhat particle should be plotted? Available cuts:\n[");
         for (int part_i = 0; part_i < PART_LIST_SIZE; ++part_i) {
             printf("%s, ", PART_LIST[part_i]);
         }
         printf("\b\b]\n");
-        plot_particle = rge_catch_string(PART_LIST, PART_LIST_SIZE);
-        if      (plot_particle == A_PPOS) plot_charge =  1;
-        else if (plot_particle == A_PNEU) plot_charge =  0;
-        else if (plot_particle == A_PNEG) plot_charge = -1;
+        int plot_particle = rge_catch_string(PART_LIST, PART_LIST_SIZE);
+        if      (plot_particle == A_PPOS) sel.charge =  1;
+        else if (plot_particle == A_PNEU) sel.charge =  0;
+        else if (plot_particle == A_PNEG) sel.charge = -1;
         else if (plot_particle == A_PPID) {
             printf("\nSelect PID from:\n");
             rge_print_pid_names();
-            plot_pid = rge_catch_long();
+            sel.pid = rge_catch_long();
         }
+        sels->push_back(sel);
     }
-    else {
-        plot_pid = sel_pid;
-    }
+    luint nsels = sels->size();
 
     // If a PID was selected, check that it's valid.
-    if (plot_pid != INT_MAX && rge_pid_invalid(plot_pid)) return 1;
+    for (luint sel_i = 0; sel_i < nsels; ++sel_i) {
+        int plot_pid = sels->at(sel_i).pid;
+        if (plot_pid != INT_MAX && rge_pid_invalid(plot_pid)) return 1;
+    }
 
-    // Find selected particle PID in acceptance correction data. If not found,
-    //     return an error.
-    uint acc_pid_idx = UINT_MAX;
-    if (acc_plot) {
+    // Find each selected particle PID in acceptance correction data. If not
+    //     found, return an error.
+    uint acc_pid_idx[nsels];
+    for (luint sel_i = 0; sel_i < nsels && acc_plot; ++sel_i) {
         // Find index of plot_pid in acc_pids.
+        acc_pid_idx[sel_i] = UINT_MAX;
         for (uint pid_i = 0; pid_i < acc_npids; ++pid_i) {
-            if (acc_pids[pid_i] == plot_pid) acc_pid_idx = pid_i;
+            if (acc_pids[pid_i] == sels->at(sel_i).pid) {
+                acc_pid_idx[sel_i] = pid_i;
+            }
         }
-        if (acc_pid_idx == UINT_MAX) {
+        if (acc_pid_idx[sel_i] == UINT_MAX) {
             rge_errno = RGEERR_NOACCDATA;
             return 1;
         }
@@ -431,6 +466,12 @@ static int run(
         dis_cuts      = true;
     }
 
+    // Files skimmed by make_ntuples only have events passing the DIS cuts.
+    if (dis_cuts && rge_read_dis_skim(f_in)) {
+        printf("\nInput file is DIS-skimmed, skipping DIS cuts.\n");
+        dis_cuts = false;
+    }
+
     // === SETUP BINNING =======================================================
     luint dim_bins;
     if (binning_setup[0] == -1) {
@@ -569,12 +610,22 @@ static int run(
         rge_errno = RGEERR_BADROOTFILE;
         return 1;
     }
+    if (rge_attach_kinematics(f_in, ntuple)) return 1;
 
     Float_t vars[RGE_VARS_SIZE];
     for (int var_i = 0; var_i < RGE_VARS_SIZE; ++var_i) {
         ntuple->SetBranchAddress(RGE_VARS[var_i], &vars[var_i]);
     }
 
+    // Read exact event numbers if available, since N_{event} is a Float_t.
+    Long64_t evn64 = 0;
+    bool has_evn64 = ntuple->GetBranch(RGE_EVENTNO64) != NULL;
+    if (has_evn64) ntuple->SetBranchAddress(RGE_EVENTNO64, &evn64);
+    auto event_no = [&]() -> luint {
+        if (has_evn64) return static_cast<luint>(evn64);
+        return static_cast<luint>(vars[RGE_EVENTNO.addr]+0.5);
+    };
+
     // === APPLY CUTS ==========================================================
     printf("\nOpening file...\n");
 
@@ -583,25 +634,28 @@ static int run(
         nentries = ntuple->GetEntries();
     }
 
+    // Get shard of entries processed by this rank.
+    lint first_entry, last_entry;
+    rge_dist_shard(nentries, &first_entry, &last_entry);
+
     // Apply SIDIS cuts, checking which event numbers should be skipped.
     luint nevents = 0;
 
     // Prepare progress bar.
-    rge_pbar_set_nentries(nentries);
+    rge_pbar_set_nentries(last_entry - first_entry);
 
-    // Count number of events.
-    for (lint entry = 0; entry < nentries; ++entry) {
-        rge_pbar_update(entry);
+    // Count number of events. Only needed for DIS cuts.
+    for (lint entry = first_entry; entry < last_entry && dis_cuts; ++entry) {
+        rge_pbar_update(entry - first_entry);
         ntuple->GetEntry(entry);
-        if (vars[RGE_EVENTNO.addr] > nevents) {
-            nevents = static_cast<luint>(vars[RGE_EVENTNO.addr]+0.5);
-        }
+        if (event_no() + 1 > nevents) nevents = event_no() + 1;
     }
+    rge_dist_allreduce_max(&nevents);
 
     // Apply previously setup cuts.
     if (dis_cuts) printf("Applying cuts...\n");
     bool *valid_event = static_cast<bool *>(malloc(nevents * sizeof(bool)));
-    Float_t current_evn = -1;
+    lint current_evn = -1;
     bool no_tre_pass, Q2_pass, W2_pass, Yb_pass;
 
     // Fill valid_event array with false bools in case the next for loop doesn't
@@ -615,13 +669,13 @@ static int run(
     //     so that we can skip those when plotting. It is only necessary to do
     //     this if we're applying DIS cuts.
     rge_pbar_reset();
-    for (lint entry = 0; entry < nentries && dis_cuts; ++entry) {
-        rge_pbar_update(entry);
+    for (lint entry = first_entry; entry < last_entry && dis_cuts; ++entry) {
+        rge_pbar_update(entry - first_entry);
 
         ntuple->GetEntry(entry);
-        if (vars[RGE_EVENTNO.addr] != current_evn) {
-            current_evn = vars[RGE_EVENTNO.addr];
-            valid_event[static_cast<luint>(vars[RGE_EVENTNO.addr]+0.5)] = false;
+        if (static_cast<lint>(event_no()) != current_evn) {
+            current_evn = static_cast<lint>(event_no());
+            valid_event[event_no()] = false;
             no_tre_pass = false;
             Q2_pass     = true;
             W2_pass     = true;
@@ -639,10 +693,14 @@ static int run(
         W2_pass = vars[RGE_W2.addr] >= RGE_W2CUT;
         Yb_pass = vars[RGE_YB.addr] <= RGE_YBCUT;
 
-        valid_event[static_cast<luint>(vars[RGE_EVENTNO.addr]+0.5)] =
+        valid_event[event_no()] =
                 no_tre_pass && Q2_pass && W2_pass && Yb_pass;
     }
 
+    // An event might be split between two shards, but only the shard with its
+    //     trigger electron can mark it as valid.
+    if (dis_cuts) rge_dist_allreduce_lor(valid_event, nevents);
+
     // === PLOT ================================================================
     // Create plots, separated by n-dimensional binning.
     luint bin_arr_size = 1;
@@ -650,65 +708,58 @@ static int run(
         bin_arr_size *= bin_nbins[bin_dim_i];
     }
 
-    TH1 *plot_arr[plot_arr_size][bin_arr_size];
-    for (luint plot_i = 0; plot_i < plot_arr_size; ++plot_i) {
-        TString plot_title;
-        int idx = 0;
-        if (acc_plot) { // Acceptance corrected plots have variable bin sizes.
-            plot_title = Form("%s", RGE_VARS[plot_vars[plot_i][0]]);
-            create_acc_corr_plots(
-                    plot_arr[plot_i], dim_bins, &idx, 0, &plot_title,
-                    RGE_VARS[plot_vars[plot_i][0]], "",
-                    plot_type[plot_i], acc_nedges[plot_i], acc_edges[plot_i],
-                    bin_vars, bin_nbins, bin_range, bin_binsize
-            );
-            continue;
-        }
-        if (plot_type[plot_i] == 0) { // 1D plot.
-            plot_title = Form("%s", RGE_VARS[plot_vars[plot_i][0]]);
-            create_plots(
-                    plot_arr[plot_i], dim_bins, &idx, 0, &plot_title,
-                    RGE_VARS[plot_vars[plot_i][0]], "",
-                    plot_type[plot_i], plot_nbins[plot_i], plot_range[plot_i],
-                    bin_vars, bin_nbins, bin_range, bin_binsize
-            );
-        }
-        if (plot_type[plot_i] == 1) { // 2D plot.
-            plot_title = Form("%s vs %s", RGE_VARS[plot_vars[plot_i][0]],
-                    RGE_VARS[plot_vars[plot_i][1]]);
-            create_plots(
-                    plot_arr[plot_i], dim_bins, &idx, 0, &plot_title,
-                    RGE_VARS[plot_vars[plot_i][0]],
-                    RGE_VARS[plot_vars[plot_i][1]],
-                    plot_type[plot_i], plot_nbins[plot_i], plot_range[plot_i],
-                    bin_vars, bin_nbins, bin_range, bin_binsize
-            );
+    // Plots of different selections share names, so they're kept out of
+    //     gDirectory to avoid replacing each other.
+    if (nsels > 1) TH1::AddDirectory(false);
+
+    TH1 *plot_arr[nsels][plot_arr_size][bin_arr_size];
+    for (luint sel_i = 0; sel_i < nsels; ++sel_i) {
+        for (luint plot_i = 0; plot_i < plot_arr_size; ++plot_i) {
+            TString plot_title;
+            int idx = 0;
+            if (acc_plot) { // Acceptance corrected plots have variable bins.
+                plot_title = Form("%s", RGE_VARS[plot_vars[plot_i][0]]);
+                create_acc_corr_plots(
+                        plot_arr[sel_i][plot_i], dim_bins, &idx, 0,
+                        &plot_title, RGE_VARS[plot_vars[plot_i][0]], "",
+                        plot_type[plot_i], acc_nedges[plot_i],
+                        acc_edges[plot_i], bin_vars, bin_nbins, bin_range,
+                        bin_binsize
+                );
+                continue;
+            }
+            if (plot_type[plot_i] == 0) { // 1D plot.
+                plot_title = Form("%s", RGE_VARS[plot_vars[plot_i][0]]);
+                create_plots(
+                        plot_arr[sel_i][plot_i], dim_bins, &idx, 0,
+                        &plot_title, RGE_VARS[plot_vars[plot_i][0]], "",
+                        plot_type[plot_i], plot_nbins[plot_i],
+                        plot_range[plot_i], bin_vars, bin_nbins, bin_range,
+                        bin_binsize
+                );
+            }
+            if (plot_type[plot_i] == 1) { // 2D plot.
+                plot_title = Form("%s vs %s", RGE_VARS[plot_vars[plot_i][0]],
+                        RGE_VARS[plot_vars[plot_i][1]]);
+                create_plots(
+                        plot_arr[sel_i][plot_i], dim_bins, &idx, 0,
+                        &plot_title, RGE_VARS[plot_vars[plot_i][0]],
+                        RGE_VARS[plot_vars[plot_i][1]],
+                        plot_type[plot_i], plot_nbins[plot_i],
+                        plot_range[plot_i], bin_vars, bin_nbins, bin_range,
+                        bin_binsize
+                );
+            }
         }
     }
 
     // Run through events.
     printf("Processing plots...\n");
     rge_pbar_reset();
-    for (lint entry = 0; entry < nentries; ++entry) {
-        rge_pbar_update(entry);
+    for (lint entry = first_entry; entry < last_entry; ++entry) {
+        rge_pbar_update(entry - first_entry);
         ntuple->GetEntry(entry);
 
-        // Apply particle cuts.
-        if (plot_charge != INT_MAX) {
-            if (plot_charge ==  1 && !(vars[RGE_CHARGE.addr] >  0)) continue;
-            if (plot_charge ==  0 && !(vars[RGE_CHARGE.addr] == 0)) continue;
-            if (plot_charge == -1 && !(vars[RGE_CHARGE.addr] <  0)) continue;
-        }
-        if (
-                plot_pid != INT_MAX &&
-                (
-                        vars[RGE_PID.addr] - 0.5 >= plot_pid ||
-                        plot_pid > vars[RGE_PID.addr] + 0.5
-                )
-        ) {
-            continue;
-        }
-
         // Apply geometry cuts.
         if (geometry_cuts) {
             if (
@@ -739,12 +790,7 @@ static int run(
         }
 
         // Apply DIS cuts.
-        if (
-                dis_cuts &&
-                !valid_event[static_cast<int>(vars[RGE_EVENTNO.addr]+0.5)]
-        ) {
-            continue;
-        }
+        if (dis_cuts && !valid_event[event_no()]) continue;
 
         // Remove DIS vars = 0.
         if (vars[RGE_Q2.addr] == 0 || vars[RGE_NU.addr] == 0) {
@@ -768,40 +814,73 @@ static int run(
             bin_vars_idx[bin_dim_i] = vars[bin_vars[bin_dim_i]];
         }
 
-        // Fill plots.
-        for (luint plot_i = 0; plot_i < plot_arr_size; ++plot_i) {
-            // SIDIS variables only make sense for some particles.
-            bool sidis_pass = true;
-            for (int dim_i = 0; dim_i < plot_type[plot_i]+1; ++dim_i) {
-                const char **plot_var = &RGE_VARS[plot_vars[plot_i][dim_i]];
-                for (int list_i = 0; list_i < DIS_LIST_SIZE; ++list_i) {
-                    if (
-                            !strcmp(*plot_var, DIS_LIST[list_i]) &&
-                            vars[plot_vars[plot_i][dim_i]] < 1e-9
-                    ) {
-                        sidis_pass = false;
-                    }
-                }
+        // Find corresponding bin.
+        lint idx = rge_find_idx(
+                dim_bins, 0, bin_vars_idx, bin_nbins, bin_range, bin_binsize
+        );
+        if (idx == -1) continue;
+
+        // Fill plots of each selection passing the particle cuts.
+        for (luint sel_i = 0; sel_i < nsels; ++sel_i) {
+            int plot_charge = sels->at(sel_i).charge;
+            int plot_pid    = sels->at(sel_i).pid;
+            Float_t charge  = vars[RGE_CHARGE.addr];
+            if (plot_charge != INT_MAX) {
+                if (plot_charge ==  1 && !(charge >  0)) continue;
+                if (plot_charge ==  0 && !(charge == 0)) continue;
+                if (plot_charge == -1 && !(charge <  0)) continue;
+            }
+            if (
+                    plot_pid != INT_MAX &&
+                    (
+                            vars[RGE_PID.addr] - 0.5 >= plot_pid ||
+                            plot_pid > vars[RGE_PID.addr] + 0.5
+                    )
+            ) {
+                continue;
             }
-            if (!sidis_pass) continue;
 
-            // Find corresponding bin.
-            lint idx = find_idx(
-                    dim_bins, 0, bin_vars_idx, bin_nbins, bin_range, bin_binsize
-            );
-            if (idx == -1) continue;
+            for (luint plot_i = 0; plot_i < plot_arr_size; ++plot_i) {
+                // SIDIS variables only make sense for some particles.
+                bool sidis_pass = true;
+                for (int dim_i = 0; dim_i < plot_type[plot_i]+1; ++dim_i) {
+                    const char **plot_var =
+                            &RGE_VARS[plot_vars[plot_i][dim_i]];
+                    for (int list_i = 0; list_i < DIS_LIST_SIZE; ++list_i) {
+                        if (
+                                !strcmp(*plot_var, DIS_LIST[list_i]) &&
+                                vars[plot_vars[plot_i][dim_i]] < 1e-9
+                        ) {
+                            sidis_pass = false;
+                        }
+                    }
+                }
+                if (!sidis_pass) continue;
 
-            // Fill histogram.
-            if (plot_type[plot_i] == 0) {
-                plot_arr[plot_i][idx]->Fill(vars[plot_vars[plot_i][0]]);
+                // Fill histogram.
+                TH1 *plot = plot_arr[sel_i][plot_i][idx];
+                if (plot_type[plot_i] == 0) {
+                    plot->Fill(vars[plot_vars[plot_i][0]]);
+                }
+                if (plot_type[plot_i] == 1) {
+                    plot->Fill(
+                            vars[plot_vars[plot_i][0]],
+                            vars[plot_vars[plot_i][1]]
+                    );
+                }
             }
-            if (plot_type[plot_i] == 1) {
-                plot_arr[plot_i][idx]->Fill(
-                        vars[plot_vars[plot_i][0]], vars[plot_vars[plot_i][1]]
-                );
+        }
+    }
+
+    // Add up plots from all ranks. From here on, only rank 0 works.
+    for (luint sel_i = 0; sel_i < nsels; ++sel_i) {
+        for (luint plot_i = 0; plot_i < plot_arr_size; ++plot_i) {
+            for (luint bin_i = 0; bin_i < bin_arr_size; ++bin_i) {
+                rge_dist_reduce_hist(plot_arr[sel_i][plot_i][bin_i]);
             }
         }
     }
+    if (rge_dist_rank() != 0) apply_acc_corr = false;
 
     // === APPLY ACCEPTANCE CORRECTION =========================================
     // Array for storing number of bins (for simplicity).
@@ -810,16 +889,19 @@ static int run(
             acc_nedges[3]-1, acc_nedges[4]-1
     };
 
-    // Interate through plot variables and bins.
+    // Interate through selections and plot variables. The correction factor
+    //     is the same for every bin of the binning grid.
     for (
-            luint plot_i = 0;
-            plot_i < plot_arr_size && acc_plot && apply_acc_corr;
-            ++plot_i
+            luint sel_i = 0;
+            sel_i < nsels && acc_plot && apply_acc_corr;
+            ++sel_i
     ) {
-        for (luint bin_i = 0; bin_i < bin_arr_size; ++bin_i) {
+        lint *n_thrown = acc_n_thrown[acc_pid_idx[sel_i]];
+        lint *n_simul  = acc_n_simul [acc_pid_idx[sel_i]];
+        for (luint plot_i = 0; plot_i < plot_arr_size; ++plot_i) {
             // Integrate through other variables.
-            int y_thrown[bn[plot_i]];
-            int y_simul [bn[plot_i]];
+            lint y_thrown[bn[plot_i]];
+            lint y_simul [bn[plot_i]];
             for (
                     luint acc_bin_i = 0;
                     acc_bin_i < bn[plot_i];
@@ -861,10 +943,8 @@ static int run(
                                 }
 
                                 // Increment appropriate counters.
-                                y_thrown[sel_idx] +=
-                                        acc_n_thrown[acc_pid_idx][bin_pos];
-                                y_simul[sel_idx] +=
-                                        acc_n_simul[acc_pid_idx][bin_pos];
+                                y_thrown[sel_idx] += n_thrown[bin_pos];
+                                y_simul [sel_idx] += n_simul [bin_pos];
                             }
                         }
                     }
@@ -880,36 +960,75 @@ static int run(
             }
 
             // Multiply each plot bin by its corresponding correction factor.
-            for (luint plt_bin_i = 1; plt_bin_i <= bn[plot_i]; ++plt_bin_i) {
-                double bin = plot_arr[plot_i][bin_i]->GetBinContent(plt_bin_i);
-                plot_arr[plot_i][bin_i]->SetBinContent(
-                        plt_bin_i, bin * acc_corr_factor[plt_bin_i-1]
-                );
+            for (luint bin_i = 0; bin_i < bin_arr_size; ++bin_i) {
+                TH1 *plot = plot_arr[sel_i][plot_i][bin_i];
+                for (luint bin_j = 1; bin_j <= bn[plot_i]; ++bin_j) {
+                    plot->SetBinContent(
+                            bin_j,
+                            plot->GetBinContent(bin_j)*acc_corr_factor[bin_j-1]
+                    );
+                }
             }
         }
     }
 
     // === WRITE TO OUTPUT FILE ================================================
     // Create output file.
-    TFile *f_out = TFile::Open(out_filename, "RECREATE");
-    if (!f_out || f_out->IsZombie()) {
-        rge_errno = RGEERR_OUTPUTROOTFAILED;
-        return 1;
+    bool write_out = rge_dist_rank() == 0;
+    TFile *f_out   = NULL;
+    if (write_out) {
+        f_out = TFile::Open(out_filename, "RECREATE");
+        if (!f_out || f_out->IsZombie()) {
+            rge_errno = RGEERR_OUTPUTROOTFAILED;
+            return 1;
+        }
     }
 
-    // Write plots to output file.
-    for (luint bin_i = 0; bin_i < bin_arr_size; ++bin_i) {
-        // Find dir.
-        TString dir;
-        find_bin(&dir, dim_bins, bin_i, 0, INT_MAX, bin_arr_size, bin_vars,
-                bin_nbins, bin_range, bin_binsize);
+    // Each selection is written to its own directory, if it has one.
+    for (luint sel_i = 0; sel_i < nsels && write_out; ++sel_i) {
+        TString sel_dir(sels->at(sel_i).dir);
+        if (sel_dir.Length() > 0) sel_dir.Append("/");
+
+        // Write each plot as a single THnSparse containing the full binning
+        //     grid.
+        for (
+                luint plot_i = 0;
+                plot_i < plot_arr_size && grid_out;
+                ++plot_i
+        ) {
+            TString plot_title;
+            if (acc_plot || plot_type[plot_i] == 0) {
+                plot_title = Form("%s", RGE_VARS[plot_vars[plot_i][0]]);
+            }
+            else {
+                plot_title = Form("%s vs %s", RGE_VARS[plot_vars[plot_i][0]],
+                        RGE_VARS[plot_vars[plot_i][1]]);
+            }
+
+            THnSparse *grid = rge_grid_pack(
+                    plot_title, plot_title, plot_arr[sel_i][plot_i], dim_bins,
+                    bin_vars, bin_nbins, bin_range
+            );
+            if (sel_dir.Length() > 0) f_out->mkdir(sel_dir, "", true);
+            f_out->cd(sel_dir);
+            grid->Write();
+            delete grid;
+        }
 
-        f_out->mkdir(dir);
-        f_out->cd(dir);
+        // Write plots to output file, one directory per bin.
+        for (luint bin_i = 0; bin_i < bin_arr_size && !grid_out; ++bin_i) {
+            // Find dir.
+            TString dir(sel_dir);
+            find_bin(&dir, dim_bins, bin_i, 0, INT_MAX, bin_arr_size,
+                    bin_vars, bin_nbins, bin_range, bin_binsize);
 
-        // Write plot(s).
-        for (luint plot_i = 0; plot_i < plot_arr_size; ++plot_i) {
-            plot_arr[plot_i][bin_i]->Write();
+            f_out->mkdir(dir, "", true);
+            f_out->cd(dir);
+
+            // Write plot(s).
+            for (luint plot_i = 0; plot_i < plot_arr_size; ++plot_i) {
+                plot_arr[sel_i][plot_i][bin_i]->Write();
+            }
         }
     }
 
@@ -917,22 +1036,14 @@ static int run(
 
     // === CLEAN-UP ============================================================
     f_in ->Close();
-    f_out->Close();
+    if (f_out != NULL) f_out->Close();
 
     free(valid_event);
 
     if (acc_plot) {
-        for (luint bin_i = 0; bin_i < 5; ++bin_i) {
-            free(acc_edges[bin_i]);
-        }
-        free(acc_edges);
-        free(acc_pids);
-        for (luint plot_i = 0; plot_i < acc_npids; ++plot_i) {
-            free(acc_n_thrown[plot_i]);
-            free(acc_n_simul[plot_i]);
-        }
-        free(acc_n_thrown);
-        free(acc_n_simul);
+        rge_free_acc_corr(
+                acc_edges, acc_npids, acc_pids, acc_n_thrown, acc_n_simul
+        );
     }
 
     rge_errno = RGEERR_NOERR;
@@ -944,21 +1055,30 @@ static int run(
  *     explained in the handle_err() function.
  */
 static int handle_args(
-        int argc, char **argv, lint *sel_pid, bool *apply_all_cuts,
-        lint *binning_setup, lint *nentries, char **out_filename,
-        char **acc_filename, bool *apply_acc_corr, char **work_dir,
-        char **in_filename, int *run_no
+        int argc, char **argv, std::vector<part_sel> *sels,
+        bool *apply_all_cuts, lint *binning_setup, lint *nentries,
+        char **out_filename, char **acc_filename, bool *apply_acc_corr,
+        bool *grid_out, char **work_dir, char **in_filename, int *run_no
 ) {
     // Handle arguments.
     int opt;
     char *tmp_out_filename = NULL;
-    while ((opt = getopt(argc, argv, "-hp:cb:n:o:a:Aw:")) != -1) {
+    lint sel_pid           = 0;
+    bool multi_sel         = false;
+    while ((opt = getopt(argc, argv, "-hp:P:cb:n:o:a:ASw:")) != -1) {
         switch (opt) {
             case 'h':
                 rge_errno = RGEERR_USAGE;
                 return 1;
             case 'p':
-                if (rge_process_pid(sel_pid, optarg)) return 1;
+                if (rge_process_pid(&sel_pid, optarg)) return 1;
+                break;
+            case 'P':
+                if (multi_sel || parse_selections(optarg, sels)) {
+                    rge_errno = RGEERR_BADSELECTIONS;
+                    return 1;
+                }
+                multi_sel = true;
                 break;
             case 'c':
                 *apply_all_cuts = true;
@@ -982,6 +1102,9 @@ static int handle_args(
             case 'A':
                 *apply_acc_corr = false;
                 break;
+            case 'S':
+                *grid_out = true;
+                break;
             case 'w':
                 *work_dir = static_cast<char *>(malloc(strlen(optarg) + 1));
                 strcpy(*work_dir, optarg);
@@ -1002,6 +1125,17 @@ static int handle_args(
         sprintf(*work_dir, "%s/../root_io", dirname(argv[0]));
     }
 
+    // -p selects a single PID, and can't be combined with -P.
+    if (sel_pid != 0) {
+        if (multi_sel) {
+            rge_errno = RGEERR_BADSELECTIONS;
+            return 1;
+        }
+        part_sel sel = {.charge = INT_MAX, .pid = INT_MAX, .dir = ""};
+        sel.pid = static_cast<int>(sel_pid);
+        sels->push_back(sel);
+    }
+
     // -A is only valid if -a is also specified.
     if (*apply_acc_corr == false && *acc_filename == NULL) {
         rge_errno = RGEERR_INVALIDACCEPTANCEOPT;
@@ -1044,29 +1178,33 @@ static int handle_args(
 
 /** Entry point of the program. */
 int main(int argc, char **argv) {
+    rge_dist_init(&argc, &argv);
+
     // Handle arguments.
-    lint sel_pid          = 0;
+    std::vector<part_sel> sels;
     bool apply_all_cuts   = false;
     lint binning_setup[4] = {-1, -1, -1, -1};
     lint nentries         = -1;
     char *out_filename    = NULL;
     char *acc_filename    = NULL;
     bool apply_acc_corr   = true;
+    bool grid_out         = false;
     char *work_dir        = NULL;
     char *in_filename     = NULL;
     int  run_no           = -1;
 
     int err = handle_args(
-            argc, argv, &sel_pid, &apply_all_cuts, binning_setup, &nentries,
-            &out_filename, &acc_filename, &apply_acc_corr, &work_dir,
-            &in_filename, &run_no
+            argc, argv, &sels, &apply_all_cuts, binning_setup, &nentries,
+            &out_filename, &acc_filename, &apply_acc_corr, &grid_out,
+            &work_dir, &in_filename, &run_no
     );
 
     // Run.
     if (rge_errno == RGEERR_UNDEFINED && err == 0) {
         run(
                 in_filename, out_filename, acc_filename, work_dir, run_no,
-                nentries, sel_pid, apply_all_cuts, apply_acc_corr, binning_setup
+                nentries, &sels, apply_all_cuts, apply_acc_corr,
+                binning_setup, grid_out
         );
     }
 
@@ -1077,5 +1215,5 @@ int main(int argc, char **argv) {
     if (work_dir     != NULL) free(work_dir);
 
     // Return errcode.
-    return rge_print_usage(USAGE_MESSAGE);
+    return rge_dist_finalize(rge_print_usage(USAGE_MESSAGE));
 }
@@ -0,0 +1,344 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+// C.
+#include <libgen.h>
+#include <limits.h>
+#include <math.h>
+
+// C++.
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// ROOT.
+#include <TFile.h>
+#include <THnSparse.h>
+
+// rge-analysis.
+#include "../lib/rge_constants.h"
+#include "../lib/rge_err_handler.h"
+#include "../lib/rge_filename_handler.h"
+#include "../lib/rge_io_handler.h"
+#include "../lib/rge_math_utils.h"
+
+static const char *USAGE_MESSAGE =
+"Usage: fit_phipq [-hj:o:w:] infile\n"
+" * -h          : show this message and exit.\n"
+" * -j nthreads : number of threads used to fit. Default is 1.\n"
+" * -o outfile  : output file name. Default is phipq_fits_<run_no>.txt.\n"
+" * -w workdir  : location where the output file is stored. Default is\n"
+"                 root_io.\n"
+" * infile      : input file produced by draw_plots with -S, containing\n"
+"                 the binning grid of phiPQ plots.\n\n"
+"    Fit A + B cos(phiPQ) + C cos(2 phiPQ) to the phiPQ plot of every cell of\n"
+"    the binning grid, and write the coefficients to a table.\n";
+
+/** Number of cells taken at once by each fitting thread. */
+#define FIT_CHUNK 64
+
+/**
+ * Result of fitting one cell of the binning grid.
+ *
+ * @param status : 0 if the fit succeeded, 1 if the cell had too few non-empty
+ *                 bins or the fit was singular.
+ * @param yield  : sum of the phiPQ plot contents.
+ * @param par    : fitted A, B, and C.
+ * @param cov    : covariance matrix of par.
+ * @param chi2   : chi2 of the fit.
+ * @param ndf    : number of degrees of freedom of the fit.
+ */
+typedef struct {
+    int status;
+    double yield;
+    double par[3];
+    double cov[3][3];
+    double chi2;
+    luint ndf;
+} cell_fit;
+
+/**
+ * Get ratio r = num/den and its error, propagated from the variances of num
+ *     and den and their covariance.
+ */
+static int get_ratio(
+        double num, double den, double var_num, double var_den, double cov,
+        double *r, double *err
+) {
+    *r = num / den;
+    double var = (var_num - 2*(*r)*cov + (*r)*(*r)*var_den) / (den*den);
+    *err = var > 0 ? sqrt(var) : 0.;
+    return 0;
+}
+
+/** run() function of the program. Check USAGE_MESSAGE for details. */
+static int run(char *in_filename, char *out_filename, lint nthreads) {
+    // Get grid.
+    TFile *f_in = TFile::Open(in_filename, "READ");
+    if (!f_in || f_in->IsZombie()) {
+        rge_errno = RGEERR_BADINPUTFILE;
+        return 1;
+    }
+    THnSparse *grid = f_in->Get<THnSparse>(RGE_PHIPQ.name);
+    if (grid == NULL) {
+        rge_errno = RGEERR_NOPHIPQGRID;
+        return 1;
+    }
+
+    // The last axis is phiPQ, and the rest are binning variables.
+    int dim_bins = grid->GetNdimensions() - 1;
+    luint dim_size = dim_bins > 0 ? static_cast<luint>(dim_bins) : 1;
+    luint ncells = 1;
+    int bin_nbins[dim_size];
+    for (int bin_dim_i = 0; bin_dim_i < dim_bins; ++bin_dim_i) {
+        bin_nbins[bin_dim_i] = grid->GetAxis(bin_dim_i)->GetNbins();
+        ncells *= static_cast<luint>(bin_nbins[bin_dim_i]);
+    }
+    TAxis *phi_ax = grid->GetAxis(dim_bins);
+    luint nphi    = static_cast<luint>(phi_ax->GetNbins());
+    std::vector<double> phi_edges(nphi + 1);
+    for (luint phi_i = 0; phi_i < nphi; ++phi_i) {
+        phi_edges[phi_i] = phi_ax->GetBinLowEdge(static_cast<int>(phi_i) + 1);
+    }
+    phi_edges[nphi] = phi_ax->GetXmax();
+
+    // Unpack the grid into one flat array of contents and errors per cell, in
+    //     a single pass over its filled bins. Under and overflow bins are
+    //     dropped.
+    std::vector<double> contents(ncells * nphi, 0.);
+    std::vector<double> errors  (ncells * nphi, 0.);
+    int coord[static_cast<luint>(grid->GetNdimensions())];
+    for (Long64_t lin_i = 0; lin_i < grid->GetNbins(); ++lin_i) {
+        double content = grid->GetBinContent(lin_i, coord);
+
+        int phi_bin = coord[dim_bins];
+        if (phi_bin < 1 || phi_bin > static_cast<int>(nphi)) continue;
+        luint cell_i = 0;
+        bool in_range = true;
+        for (int bin_dim_i = 0; bin_dim_i < dim_bins; ++bin_dim_i) {
+            int bin = coord[bin_dim_i];
+            if (bin < 1 || bin > bin_nbins[bin_dim_i]) in_range = false;
+            cell_i = cell_i * static_cast<luint>(bin_nbins[bin_dim_i]) +
+                    static_cast<luint>(bin - 1);
+        }
+        if (!in_range) continue;
+
+        luint idx = cell_i * nphi + static_cast<luint>(phi_bin - 1);
+        contents[idx] = content;
+        errors  [idx] = sqrt(grid->GetBinError2(lin_i));
+    }
+
+    // Fit cells, with each thread taking the next available chunk.
+    lint nworkers = static_cast<lint>(ncells) < nthreads ?
+            static_cast<lint>(ncells) : nthreads;
+    printf(
+            "Fitting %lu cells using %ld thread(s).\n", ncells, nworkers
+    );
+
+    std::vector<cell_fit> fits(ncells);
+    std::atomic<luint> next_cell(0);
+    std::vector<std::thread> workers;
+    for (lint worker_i = 0; worker_i < nworkers; ++worker_i) {
+        workers.emplace_back([&] {
+            for (
+                    luint start = next_cell.fetch_add(FIT_CHUNK);
+                    start < ncells; start = next_cell.fetch_add(FIT_CHUNK)
+            ) {
+                luint end = start + FIT_CHUNK < ncells ?
+                        start + FIT_CHUNK : ncells;
+                for (luint cell_i = start; cell_i < end; ++cell_i) {
+                    cell_fit *fit = &(fits[cell_i]);
+                    const double *y   = &(contents[cell_i * nphi]);
+                    const double *err = &(errors  [cell_i * nphi]);
+
+                    fit->yield = 0;
+                    for (luint phi_i = 0; phi_i < nphi; ++phi_i) {
+                        fit->yield += y[phi_i];
+                    }
+                    fit->status = rge_fit_cos_modulation(
+                            nphi, phi_edges.data(), y, err, fit->par,
+                            fit->cov, &(fit->chi2), &(fit->ndf)
+                    );
+                }
+            }
+        });
+    }
+    for (std::thread &worker : workers) worker.join();
+
+    // === WRITE TO OUTPUT FILE ================================================
+    FILE *f_out = fopen(out_filename, "w");
+    if (f_out == NULL) {
+        rge_errno = RGEERR_OUTPUTTEXTFAILED;
+        return 1;
+    }
+
+    // Header, with the lower and upper limit of each binning variable.
+    fprintf(f_out, "# input: %s\n", in_filename);
+    fprintf(f_out, "# model: A + B cos(phiPQ) + C cos(2 phiPQ)\n#");
+    for (int bin_dim_i = 0; bin_dim_i < dim_bins; ++bin_dim_i) {
+        const char *var = grid->GetAxis(bin_dim_i)->GetTitle();
+        fprintf(f_out, " \"%s\" low, \"%s\" high,", var, var);
+    }
+    fprintf(
+            f_out, " status, yield, A, A err, B, B err, C, C err, B/A, "
+            "B/A err, C/A, C/A err, chi2, ndf\n"
+    );
+
+    luint nfailed = 0;
+    int idx[dim_size];
+    for (luint cell_i = 0; cell_i < ncells; ++cell_i) {
+        // Find the bin of each binning variable, last one first.
+        luint cell_rem = cell_i;
+        for (int bin_dim_i = dim_bins-1; bin_dim_i >= 0; --bin_dim_i) {
+            idx[bin_dim_i] = static_cast<int>(
+                    cell_rem % static_cast<luint>(bin_nbins[bin_dim_i])
+            ) + 1;
+            cell_rem /= static_cast<luint>(bin_nbins[bin_dim_i]);
+        }
+        for (int bin_dim_i = 0; bin_dim_i < dim_bins; ++bin_dim_i) {
+            TAxis *ax = grid->GetAxis(bin_dim_i);
+            fprintf(
+                    f_out, "%12.6f %12.6f ", ax->GetBinLowEdge(idx[bin_dim_i]),
+                    ax->GetBinUpEdge(idx[bin_dim_i])
+            );
+        }
+
+        cell_fit *fit = &(fits[cell_i]);
+        fprintf(f_out, "%d %14.6e ", fit->status, fit->yield);
+        if (fit->status != 0) {
+            ++nfailed;
+            fprintf(f_out, "nan nan nan nan nan nan nan nan nan nan nan 0\n");
+            continue;
+        }
+
+        double b_a, b_a_err, c_a, c_a_err;
+        get_ratio(
+                fit->par[1], fit->par[0], fit->cov[1][1], fit->cov[0][0],
+                fit->cov[0][1], &b_a, &b_a_err
+        );
+        get_ratio(
+                fit->par[2], fit->par[0], fit->cov[2][2], fit->cov[0][0],
+                fit->cov[0][2], &c_a, &c_a_err
+        );
+        for (int par_i = 0; par_i < 3; ++par_i) {
+            fprintf(
+                    f_out, "%14.6e %14.6e ", fit->par[par_i],
+                    sqrt(fit->cov[par_i][par_i])
+            );
+        }
+        fprintf(
+                f_out, "%12.6f %12.6f %12.6f %12.6f %12.4f %lu\n",
+                b_a, b_a_err, c_a, c_a_err, fit->chi2, fit->ndf
+        );
+    }
+
+    fclose(f_out);
+    f_in->Close();
+
+    printf("%lu of %lu cells couldn't be fitted.\n", nfailed, ncells);
+    printf("Done! Check out the fits at %s.\n", out_filename);
+
+    rge_errno = RGEERR_NOERR;
+    return 0;
+}
+
+/** Handle arguments for fit_phipq using optarg. */
+static int handle_args(
+        int argc, char **argv, char **in_filename, char **out_filename,
+        char **work_dir, lint *nthreads
+) {
+    // Handle arguments.
+    int opt;
+    char *tmp_out_filename = NULL;
+    while ((opt = getopt(argc, argv, "-hj:o:w:")) != -1) {
+        switch (opt) {
+            case 'h':
+                rge_errno = RGEERR_USAGE;
+                return 1;
+            case 'j':
+                if (rge_process_nthreads(nthreads, optarg)) return 1;
+                break;
+            case 'o':
+                rge_grab_string(optarg, &tmp_out_filename);
+                break;
+            case 'w':
+                rge_grab_string(optarg, work_dir);
+                break;
+            case 1:
+                rge_grab_string(optarg, in_filename);
+                break;
+            default:
+                rge_errno = RGEERR_BADOPTARGS;
+                return 1;
+        }
+    }
+
+    // Define workdir if undefined.
+    if (*work_dir == NULL) {
+        *work_dir = static_cast<char *>(malloc(PATH_MAX));
+        sprintf(*work_dir, "%s/../root_io", dirname(argv[0]));
+    }
+
+    // Check positional argument.
+    if (*in_filename == NULL) {
+        rge_errno = RGEERR_NOINPUTFILE;
+        if (tmp_out_filename != NULL) free(tmp_out_filename);
+        return 1;
+    }
+
+    // Check input filename validity and get run number.
+    int run_no;
+    if (rge_handle_root_filename(*in_filename, &run_no)) {
+        if (tmp_out_filename != NULL) free(tmp_out_filename);
+        return 1;
+    }
+
+    // Define output filename, including work_dir.
+    if (tmp_out_filename == NULL) {
+        tmp_out_filename = static_cast<char *>(malloc(PATH_MAX));
+        sprintf(tmp_out_filename, "phipq_fits_%06d.txt", run_no);
+    }
+    *out_filename = static_cast<char *>(malloc(PATH_MAX));
+    sprintf(*out_filename, "%s/%s", *work_dir, tmp_out_filename);
+    free(tmp_out_filename);
+
+    return 0;
+}
+
+/** Entry point of the program. */
+int main(int argc, char **argv) {
+    // Handle arguments.
+    char *in_filename  = NULL;
+    char *out_filename = NULL;
+    char *work_dir     = NULL;
+    lint nthreads      = 1;
+
+    int err = handle_args(
+            argc, argv, &in_filename, &out_filename, &work_dir, &nthreads
+    );
+
+    // Run.
+    if (rge_errno == RGEERR_UNDEFINED && err == 0) {
+        run(in_filename, out_filename, nthreads);
+    }
+
+    // Free up memory.
+    if (in_filename  != NULL) free(in_filename);
+    if (out_filename != NULL) free(out_filename);
+    if (work_dir     != NULL) free(work_dir);
+
+    // Return errcode.
+    return rge_print_usage(USAGE_MESSAGE);
+}
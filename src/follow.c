@@ -0,0 +1,567 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+// C.
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// C++.
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+// rge-analysis.
+#include "../lib/rge_err_handler.h"
+#include "../lib/rge_filename_handler.h"
+#include "../lib/rge_io_handler.h"
+#include "../lib/rge_metadata.h"
+
+static const char *USAGE_MESSAGE =
+"Usage: follow [-hf:j:p:s:w:] indir\n"
+" * -h         : show this message and exit.\n"
+" * -f fmtlyrs : number of FMT layers required by make_ntuples. If set to\n"
+"                something other than 0, FMT::Tracks is also converted by\n"
+"                hipo2root. Default is 0.\n"
+" * -j nthread : number of threads used by make_ntuples. Default is 1.\n"
+" * -p period  : seconds between two scans of indir. Default is 30.\n"
+" * -s settle  : seconds a file has to stay unmodified before it is\n"
+"                processed. Default is 60.\n"
+" * -w workdir : location where output root files are to be stored. Default\n"
+"                is root_io.\n"
+" * indir      : directory watched for HIPO files. Expected format of the\n"
+"                files is <text>run_no.hipo.\n\n"
+"    Watch a directory during data taking and process each HIPO file once it\n"
+"    settles, running hipo2root, make_ntuples, and draw_plots (with all cuts\n"
+"    and the standard plots) on it. Intermediate outputs of each file are\n"
+"    kept in workdir/follow/<file>/, so that only new or modified files are\n"
+"    processed. After each file, the ntuples and plots of its run are merged\n"
+"    into ntuples_<dc|fmtN>_<run_no>.root and monitor_<run_no>.root in\n"
+"    workdir, which are replaced atomically and can be reopened at any time.\n"
+"    A file that is modified after being processed is processed again, and\n"
+"    its previous contribution is replaced. Stop with Ctrl-C.\n";
+
+/** Name of the subdirectory of workdir holding the outputs of each file. */
+static const char *FOLLOW_DIR = "follow";
+
+/** Answer given to draw_plots' prompt for the number of plots. */
+static const char *STDPLT_ANSWER = "0\n";
+
+/** State of an input file seen by follow. */
+typedef struct {
+    int run_no;      /** Run number of the file. */
+    lint size;       /** Size of the file when it was last processed. */
+    time_t mtime;    /** Modification time when it was last processed. */
+    bool ok;         /** True if the last processing of the file succeeded. */
+    std::string dir; /** Directory holding the outputs of the file. */
+} follow_file;
+
+/** Set by the signal handler to stop watching after the current file. */
+static volatile sig_atomic_t stop = 0;
+
+/** Handle SIGINT and SIGTERM, asking the main loop to stop. */
+static void handle_signal(int sig) {
+    (void) sig;
+    stop = 1;
+}
+
+/**
+ * Run a program with args, writing its stdout and stderr to log_filename and
+ *     feeding it stdin_text through a pipe if it isn't NULL.
+ *
+ * @param args         : program to run, followed by its arguments.
+ * @param log_filename : file where the output of the program is appended.
+ * @param stdin_text   : text sent to the standard input of the program.
+ * @return             : error code. 0 if successful, 1 otherwise.
+ */
+static int run_step(
+        std::vector<std::string> *args, const char *log_filename,
+        const char *stdin_text
+) {
+    std::vector<char *> argv_child;
+    for (luint ai = 0; ai < args->size(); ++ai) {
+        argv_child.push_back(const_cast<char *>(args->at(ai).c_str()));
+    }
+    argv_child.push_back(NULL);
+
+    int fds[2] = {-1, -1};
+    if (stdin_text != NULL && pipe(fds) != 0) {
+        rge_errno = RGEERR_COMMANDFAILED;
+        return 1;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        int fd = open(log_filename, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        if (stdin_text != NULL) {
+            dup2(fds[0], STDIN_FILENO);
+            close(fds[0]);
+            close(fds[1]);
+        }
+        execv(argv_child[0], argv_child.data());
+        _exit(127);
+    }
+
+    // Answers are a few bytes, so they fit in the pipe buffer.
+    if (stdin_text != NULL) {
+        close(fds[0]);
+        if (pid > 0 && write(fds[1], stdin_text, strlen(stdin_text)) < 0) {
+            fprintf(stderr, "Failed to write to %s.\n", argv_child[0]);
+        }
+        close(fds[1]);
+    }
+
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) < 0) {
+        rge_errno = RGEERR_COMMANDFAILED;
+        return 1;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        rge_errno = RGEERR_COMMANDFAILED;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Write the names of the ntuples and plots files written for run_no in dir to
+ *     ntuples_filename and plots_filename.
+ */
+static int get_output_filenames(
+        const char *dir, int run_no, lint fmt_nlayers, char *ntuples_filename,
+        char *plots_filename
+) {
+    if (fmt_nlayers == 0) {
+        sprintf(ntuples_filename, "%s/ntuples_dc_%06d.root", dir, run_no);
+    }
+    else {
+        sprintf(
+                ntuples_filename, "%s/ntuples_fmt%1ld_%06d.root", dir,
+                fmt_nlayers, run_no
+        );
+    }
+    sprintf(plots_filename, "%s/plots_%06d.root", dir, run_no);
+    return 0;
+}
+
+/**
+ * Process one HIPO file, running hipo2root, make_ntuples, and draw_plots on it.
+ *     Outputs of a previous processing of the file are removed first.
+ *
+ * @param in_filename : HIPO file to process.
+ * @param file        : state of the file. Its output directory must be set.
+ * @param bin_dir     : directory where the programs of rge-analysis are.
+ * @param fmt_nlayers : number of FMT layers required by make_ntuples.
+ * @param nthreads    : number of threads used by make_ntuples.
+ * @return            : error code. 0 if successful, 1 otherwise.
+ */
+static int process_file(
+        const char *in_filename, follow_file *file, const char *bin_dir,
+        lint fmt_nlayers, lint nthreads
+) {
+    const char *dir = file->dir.c_str();
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        rge_errno = RGEERR_OUTPUTROOTFAILED;
+        return 1;
+    }
+
+    char banks_filename[PATH_MAX];
+    char ntuples_filename[PATH_MAX];
+    char plots_filename[PATH_MAX];
+    char log_filename[PATH_MAX];
+    sprintf(banks_filename, "%s/banks_%06d.root", dir, file->run_no);
+    get_output_filenames(
+            dir, file->run_no, fmt_nlayers, ntuples_filename, plots_filename
+    );
+    sprintf(log_filename, "%s/follow.log", dir);
+    unlink(banks_filename);
+    unlink(ntuples_filename);
+    unlink(plots_filename);
+    unlink(log_filename);
+
+    // hipo2root.
+    std::vector<std::string> args;
+    args.push_back(std::string(bin_dir) + "/hipo2root");
+    if (fmt_nlayers != 0) args.push_back("-f");
+    args.push_back("-w");
+    args.push_back(dir);
+    args.push_back(in_filename);
+    if (run_step(&args, log_filename, NULL)) return 1;
+
+    // make_ntuples.
+    args.clear();
+    args.push_back(std::string(bin_dir) + "/make_ntuples");
+    args.push_back("-f");
+    args.push_back(std::to_string(fmt_nlayers));
+    args.push_back("-j");
+    args.push_back(std::to_string(nthreads));
+    args.push_back("-w");
+    args.push_back(dir);
+    args.push_back(banks_filename);
+    if (run_step(&args, log_filename, NULL)) return 1;
+
+    // Banks are only needed by make_ntuples.
+    unlink(banks_filename);
+
+    // draw_plots, with all cuts, no binning, and the standard plots.
+    args.clear();
+    args.push_back(std::string(bin_dir) + "/draw_plots");
+    args.push_back("-c");
+    args.push_back("-P");
+    args.push_back("all");
+    args.push_back("-b");
+    for (int i = 0; i < 4; ++i) args.push_back("0");
+    args.push_back("-w");
+    args.push_back(dir);
+    args.push_back(ntuples_filename);
+    if (run_step(&args, log_filename, STDPLT_ANSWER)) return 1;
+
+    return 0;
+}
+
+/**
+ * Merge filenames into out_filename through a temporary file, which is then
+ *     renamed to out_filename. Since rename() is atomic, readers always see
+ *     either the previous or the new version of out_filename.
+ */
+static int merge_atomic(
+        std::vector<std::string> *filenames, const char *out_filename,
+        bool merge_meta
+) {
+    char tmp_filename[PATH_MAX];
+    sprintf(tmp_filename, "%s.tmp.root", out_filename);
+
+    std::vector<char *> names;
+    for (luint fi = 0; fi < filenames->size(); ++fi) {
+        names.push_back(const_cast<char *>(filenames->at(fi).c_str()));
+    }
+    if (rge_merge_files(
+            names.data(), static_cast<int>(names.size()), tmp_filename,
+            merge_meta
+    )) {
+        unlink(tmp_filename);
+        return 1;
+    }
+    if (rename(tmp_filename, out_filename) != 0) {
+        unlink(tmp_filename);
+        rge_errno = RGEERR_OUTPUTROOTFAILED;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Merge the ntuples and plots of every successfully processed file of run_no
+ *     into the run's ntuples and monitoring files in work_dir.
+ */
+static int update_run(
+        std::map<std::string, follow_file> *files, int run_no,
+        const char *work_dir, lint fmt_nlayers
+) {
+    std::vector<std::string> ntuples_filenames;
+    std::vector<std::string> plots_filenames;
+    for (auto it = files->begin(); it != files->end(); ++it) {
+        follow_file *file = &(it->second);
+        if (file->run_no != run_no || !file->ok) continue;
+
+        char ntuples_filename[PATH_MAX];
+        char plots_filename[PATH_MAX];
+        get_output_filenames(
+                file->dir.c_str(), run_no, fmt_nlayers, ntuples_filename,
+                plots_filename
+        );
+        ntuples_filenames.push_back(ntuples_filename);
+        plots_filenames.push_back(plots_filename);
+    }
+    if (ntuples_filenames.empty()) return 0;
+
+    char ntuples_filename[PATH_MAX];
+    char monitor_filename[PATH_MAX];
+    get_output_filenames(
+            work_dir, run_no, fmt_nlayers, ntuples_filename, monitor_filename
+    );
+    sprintf(monitor_filename, "%s/monitor_%06d.root", work_dir, run_no);
+
+    if (merge_atomic(&ntuples_filenames, ntuples_filename, true))  return 1;
+    if (merge_atomic(&plots_filenames,   monitor_filename, false)) return 1;
+
+    printf(
+            "Updated %s and %s with %lu files.\n", ntuples_filename,
+            monitor_filename, ntuples_filenames.size()
+    );
+    return 0;
+}
+
+/**
+ * Scan in_dir for HIPO files that are ready to be processed. A file is ready
+ *     if it was modified at least settle seconds ago, and it wasn't processed
+ *     yet or changed since. Files processed by a previous run of the program,
+ *     whose plots are newer than the file itself, are recovered as processed.
+ *
+ * @param in_dir      : directory to scan.
+ * @param follow_dir  : directory holding the outputs of each file.
+ * @param settle      : seconds a file has to stay unmodified.
+ * @param fmt_nlayers : number of FMT layers required by make_ntuples.
+ * @param files       : state of each file seen, indexed by its path.
+ * @param ready       : list where the paths of ready files are written.
+ * @return            : error code. 0 if successful, 1 otherwise.
+ */
+static int scan_dir(
+        const char *in_dir, const char *follow_dir, lint settle,
+        lint fmt_nlayers, std::map<std::string, follow_file> *files,
+        std::vector<std::string> *ready
+) {
+    DIR *d = opendir(in_dir);
+    if (d == NULL) {
+        rge_errno = RGEERR_NOWATCHDIR;
+        return 1;
+    }
+
+    time_t now = time(NULL);
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        std::string name(entry->d_name);
+        if (name.size() <= 5 || name.compare(name.size() - 5, 5, ".hipo")) {
+            continue;
+        }
+        std::string path = std::string(in_dir) + "/" + name;
+
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (now - st.st_mtime < settle) continue;
+
+        auto it = files->find(path);
+        if (it == files->end()) {
+            follow_file file;
+            if (rge_handle_hipo_filename(
+                    const_cast<char *>(path.c_str()), &(file.run_no)
+            )) {
+                // Skip files that don't follow the naming convention.
+                rge_errno = RGEERR_UNDEFINED;
+                continue;
+            }
+            file.size  = -1;
+            file.mtime = 0;
+            file.ok    = false;
+            file.dir   = std::string(follow_dir) + "/" +
+                    name.substr(0, name.size() - 5);
+
+            // Recover files processed before a restart.
+            char ntuples_filename[PATH_MAX];
+            char plots_filename[PATH_MAX];
+            get_output_filenames(
+                    file.dir.c_str(), file.run_no, fmt_nlayers,
+                    ntuples_filename, plots_filename
+            );
+            struct stat out_st;
+            if (
+                    stat(plots_filename, &out_st) == 0 &&
+                    out_st.st_mtime >= st.st_mtime
+            ) {
+                file.size  = static_cast<lint>(st.st_size);
+                file.mtime = st.st_mtime;
+                file.ok    = true;
+            }
+            it = files->insert(std::make_pair(path, file)).first;
+        }
+
+        follow_file *file = &(it->second);
+        if (
+                file->size  == static_cast<lint>(st.st_size) &&
+                file->mtime == st.st_mtime
+        ) {
+            continue;
+        }
+        file->size  = static_cast<lint>(st.st_size);
+        file->mtime = st.st_mtime;
+        ready->push_back(path);
+    }
+    closedir(d);
+
+    return 0;
+}
+
+/** run() function of the program. Check USAGE_MESSAGE for details. */
+static int run(
+        char *in_dir, char *work_dir, char *bin_dir, lint fmt_nlayers,
+        lint nthreads, lint period, lint settle
+) {
+    char follow_dir[PATH_MAX];
+    sprintf(follow_dir, "%s/%s", work_dir, FOLLOW_DIR);
+    if (mkdir(follow_dir, 0755) != 0 && errno != EEXIST) {
+        rge_errno = RGEERR_OUTPUTROOTFAILED;
+        return 1;
+    }
+
+    signal(SIGINT,  handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    std::map<std::string, follow_file> files;
+    bool first_scan = true;
+    printf("Watching %s.\n", in_dir);
+    while (!stop) {
+        std::vector<std::string> ready;
+        if (scan_dir(
+                in_dir, follow_dir, settle, fmt_nlayers, &files, &ready
+        )) {
+            return 1;
+        }
+
+        // Merge runs recovered from a previous run of the program once.
+        std::vector<int> runs;
+        if (first_scan) {
+            for (auto it = files.begin(); it != files.end(); ++it) {
+                if (it->second.ok) runs.push_back(it->second.run_no);
+            }
+            first_scan = false;
+        }
+
+        for (luint fi = 0; fi < ready.size() && !stop; ++fi) {
+            follow_file *file = &(files[ready[fi]]);
+            printf("Processing %s.\n", ready[fi].c_str());
+            file->ok = process_file(
+                    ready[fi].c_str(), file, bin_dir, fmt_nlayers, nthreads
+            ) == 0;
+            if (!file->ok) {
+                // A bad file shouldn't stop the monitoring of the others.
+                fprintf(
+                        stderr, "Failed to process %s. Check %s/follow.log.\n",
+                        ready[fi].c_str(), file->dir.c_str()
+                );
+                rge_errno = RGEERR_UNDEFINED;
+            }
+            runs.push_back(file->run_no);
+        }
+
+        // Update the outputs of each run that changed.
+        std::sort(runs.begin(), runs.end());
+        runs.erase(std::unique(runs.begin(), runs.end()), runs.end());
+        for (luint ri = 0; ri < runs.size(); ++ri) {
+            if (update_run(&files, runs[ri], work_dir, fmt_nlayers)) return 1;
+        }
+
+        for (lint s = 0; s < period && !stop; ++s) sleep(1);
+    }
+    printf("Stopped watching %s.\n", in_dir);
+
+    rge_errno = RGEERR_NOERR;
+    return 0;
+}
+
+/** Handle arguments for follow using optarg. */
+static int handle_args(
+        int argc, char **argv, char **in_dir, char **work_dir, char **bin_dir,
+        lint *fmt_nlayers, lint *nthreads, lint *period, lint *settle
+) {
+    // Handle arguments.
+    int opt;
+    while ((opt = getopt(argc, argv, "-hf:j:p:s:w:")) != -1) {
+        switch (opt) {
+            case 'h':
+                rge_errno = RGEERR_USAGE;
+                return 1;
+            case 'f':
+                if (rge_process_fmtnlayers(fmt_nlayers, optarg)) return 1;
+                break;
+            case 'j':
+                if (rge_process_nthreads(nthreads, optarg)) return 1;
+                break;
+            case 'p':
+                if (rge_process_period(period, optarg)) return 1;
+                break;
+            case 's':
+                if (rge_process_period(settle, optarg)) return 1;
+                break;
+            case 'w':
+                rge_grab_string(optarg, work_dir);
+                break;
+            case 1:
+                rge_grab_string(optarg, in_dir);
+                break;
+            default:
+                rge_errno = RGEERR_BADOPTARGS;
+                return 1;
+        }
+    }
+
+    // Check that the watched directory exists.
+    if (*in_dir == NULL) {
+        rge_errno = RGEERR_NOINPUTFILE;
+        return 1;
+    }
+    struct stat st;
+    if (stat(*in_dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        rge_errno = RGEERR_NOWATCHDIR;
+        return 1;
+    }
+
+    // Programs are run from the directory of this one.
+    *bin_dir = static_cast<char *>(malloc(PATH_MAX));
+    sprintf(*bin_dir, "%s", dirname(argv[0]));
+
+    // Define workdir if undefined.
+    if (*work_dir == NULL) {
+        *work_dir = static_cast<char *>(malloc(PATH_MAX));
+        sprintf(*work_dir, "%s/../root_io", *bin_dir);
+    }
+
+    return 0;
+}
+
+/** Entry point of the program. */
+int main(int argc, char **argv) {
+    // Handle arguments.
+    char *in_dir     = NULL;
+    char *work_dir   = NULL;
+    char *bin_dir    = NULL;
+    lint fmt_nlayers = 0;
+    lint nthreads    = 1;
+    lint period      = 30;
+    lint settle      = 60;
+
+    int err = handle_args(
+            argc, argv, &in_dir, &work_dir, &bin_dir, &fmt_nlayers, &nthreads,
+            &period, &settle
+    );
+
+    // Run.
+    if (rge_errno == RGEERR_UNDEFINED && err == 0) {
+        run(in_dir, work_dir, bin_dir, fmt_nlayers, nthreads, period, settle);
+    }
+
+    // Free up memory.
+    if (in_dir   != NULL) free(in_dir);
+    if (work_dir != NULL) free(work_dir);
+    if (bin_dir  != NULL) free(bin_dir);
+
+    // Return errcode.
+    return rge_print_usage(USAGE_MESSAGE);
+}
@@ -15,9 +15,18 @@
 
 // C.
 #include <libgen.h>
+#include <unistd.h>
+
+// C++.
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
 
 // ROOT.
 #include "TFile.h"
+#include "TROOT.h"
 #include "TTree.h"
 
 // HIPO.
@@ -32,21 +41,36 @@
 #include "../lib/rge_filename_handler.h"
 #include "../lib/rge_hipo_bank.h"
 #include "../lib/rge_io_handler.h"
+#include "../lib/rge_metadata.h"
 #include "../lib/rge_progress.h"
+#include "../lib/rge_readahead.h"
+#include "../lib/rge_staging.h"
 
 static const char *USAGE_MESSAGE =
-"Usage: hipo2root [-hfn:w:] infile\n"
-" * -h         : show this message and exit.\n"
-" * -f         : set this to true to process FMT::Tracks bank. If this is set\n"
-"                and FMT::Tracks bank is not present in the HIPO file, the\n"
-"                program will crash.\n"
-" * -n nevents : number of events.\n"
-" * -w workdir : location where output root files are to be stored. Default\n"
-"                is root_io.\n"
-" * infile     : input HIPO file. Expected format is <text>run_no.hipo.\n\n"
-"    Convert a file from hipo to root format. This program only conserves the\n"
+"Usage: hipo2root [-hafmn:j:T:w:] infile1 [infile2 ...]\n"
+" * -h          : show this message and exit.\n"
+" * -a          : read input files ahead in the background, keeping many\n"
+"                 reads in flight, so that hipo's blocking reads are served\n"
+"                 from the page cache.\n"
+" * -f          : set this to true to process FMT::Tracks bank. If this is\n"
+"                 set and FMT::Tracks bank is not present in the HIPO file,\n"
+"                 the program will crash.\n"
+" * -m          : merge the output files of each run into one file.\n"
+" * -n nevents  : number of events per input file.\n"
+" * -j nthreads : number of files converted concurrently. Default is 1.\n"
+" * -T nthreads : enable ROOT's implicit multi-threading with nthreads\n"
+"                 threads, compressing output baskets in parallel.\n"
+" * -w workdir  : location where output root files are to be stored.\n"
+"                 Default is root_io.\n"
+" * infile      : input HIPO files. Expected format is <text>run_no.hipo.\n\n"
+"    Convert files from hipo to root format. This program only conserves the\n"
 "    banks that are useful for RG-E analysis, as specified in the\n"
-"    lib/rge_hipo_bank.h file.\n";
+"    lib/rge_hipo_bank.h file. If a run has a single input file, its output\n"
+"    is banks_<run_no>.root. Otherwise, the output of the n-th file of the\n"
+"    run is banks_<n>_<run_no>.root, unless -m is set.\n";
+
+/** Number of bytes read ahead of hipo::reader with -a. */
+static const lint READAHEAD_WINDOW = 64 << 20;
 
 /** Number of banks in BANKLIST. */
 static const uint NBANKS       = 6;
@@ -58,54 +82,107 @@ static const char *BANKLIST[NBANKS] = {
     RGE_RECSCINTILLATOR, RGE_FMTTRACKS
 };
 
-/** run() function of the program. Check USAGE_MESSAGE for details. */
-static int run(
-        char *in_filename, char *work_dir, bool use_fmt, int run_no,
-        lint nevents
-) {
-    // Number of banks to read/write depends on type of analysis.
-    uint nbanks = use_fmt ? NBANKS : NBANKS_NOFMT;
+/** Time between progress bar updates when converting many files (us). */
+static const useconds_t PBAR_PERIOD = 50000;
+
+/** Return the wall time elapsed since start, in seconds. */
+static double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start
+    ).count();
+}
 
+/**
+ * Banks used by one converter thread. The dictionary and banks are built from
+ *     the first file converted by the thread, and reused for the rest, since
+ *     all files share the same schemas.
+ *
+ * @param is_init : true if the dictionary and banks were already built.
+ * @param factory : hipo dictionary.
+ * @param hbanks  : hipo banks, one for each bank in BANKLIST.
+ * @param rbanks  : rge banks, one for each bank in BANKLIST.
+ */
+typedef struct {
+    bool is_init;
+    hipo::dictionary factory;
+    hipo::bank   hbanks[NBANKS];
+    rge_hipobank rbanks[NBANKS];
+} converter;
+
+/**
+ * Convert one hipo file to root format.
+ *
+ * @param conv         : converter with the banks used by this thread.
+ * @param in_filename  : input hipo file.
+ * @param out_filename : output root file.
+ * @param nbanks       : number of banks to read/write.
+ * @param run_no       : run number of the input file.
+ * @param nevents      : number of events to convert. -1 to convert all.
+ * @param show_pbar    : set to true to print a progress bar over events.
+ * @param readahead    : set to true to read the input file ahead.
+ * @param write_time   : pointer to double where the wall time spent writing
+ *                       the output tree at the end, including compression of
+ *                       the last baskets, is added.
+ * @return             : error code. 0 if successful, 1 otherwise.
+ */
+static int convert_file(
+        converter *conv, const char *in_filename, const char *out_filename,
+        uint nbanks, int run_no, lint nevents, bool show_pbar, bool readahead,
+        double *write_time
+) {
     // Access input sources.
     hipo::reader reader;
-    hipo::dictionary factory;
     hipo::event event;
-
     reader.open(in_filename);
-    reader.readDictionary(factory);
 
-    // Create output tree and file.
-    TTree *out_tree = new TTree(RGE_TREENAMEDATA, RGE_TREENAMEDATA);
-
-    char out_filename[PATH_MAX];
-    sprintf(out_filename, "%s/banks_%06d.root", work_dir, run_no);
-    TFile *out_file = TFile::Open(out_filename, "RECREATE");
+    // Get hipo schemas, only for the first file converted.
+    if (!conv->is_init) {
+        reader.readDictionary(conv->factory);
+        for (uint i = 0; i < nbanks; ++i) {
+            // Initialize hipo banks.
+            conv->hbanks[i] = hipo::bank(conv->factory.getSchema(BANKLIST[i]));
 
-    // Open input file and get hipo schemas.
-    hipo::bank   hbanks[nbanks];
-    rge_hipobank rbanks[nbanks];
+            // Initialize rge banks.
+            conv->rbanks[i] = rge_hipobank_init(BANKLIST[i]);
+            if (rge_errno != RGEERR_UNDEFINED) return 1;
+        }
+        conv->is_init = true;
+    }
 
+    // Create output file and tree.
+    TFile *out_file = TFile::Open(out_filename, "RECREATE");
+    if (!out_file || out_file->IsZombie()) {
+        rge_errno = RGEERR_OUTPUTROOTFAILED;
+        return 1;
+    }
+    TTree *out_tree = new TTree(RGE_TREENAMEDATA, RGE_TREENAMEDATA);
     for (uint i = 0; i < nbanks; ++i) {
-        // Initialize hipo banks.
-        hbanks[i] = hipo::bank(factory.getSchema(BANKLIST[i]));
-
-        // Initialize rge banks.
-        rbanks[i] = rge_hipobank_init(BANKLIST[i]);
-        if (rge_errno != RGEERR_UNDEFINED) return 1;
-        rge_link_branches(&(rbanks[i]), out_tree);
+        rge_link_branches(&(conv->rbanks[i]), out_tree);
     }
 
     // Get event count.
-    if (nevents == -1 || nevents > reader.getEntries())
-        nevents = reader.getEntries();
-    printf("Reading %ld events from %s.\n", nevents, in_filename);
+    lint nentries = reader.getEntries();
+    if (nevents == -1 || nevents > nentries) nevents = nentries;
 
-    // Prepare fancy progress bar.
-    rge_pbar_set_nentries(nevents);
+    // Start reading ahead of the reader. Its position in the file is estimated
+    //     from the fraction of events read.
+    rge_readahead ra;
+    if (readahead) rge_readahead_open(&ra, in_filename, READAHEAD_WINDOW);
+
+    if (show_pbar) {
+        printf("Reading %ld events from %s.\n", nevents, in_filename);
+        rge_pbar_set_nentries(nevents);
+    }
 
-    for (int event_no = 0; event_no < nevents; ++event_no) {
+    for (lint event_no = 0; event_no < nevents; ++event_no) {
         // Print fancy progress bar.
-        rge_pbar_update(event_no);
+        if (show_pbar) rge_pbar_update(event_no);
+        if (readahead) {
+            rge_readahead_update(
+                    &ra, static_cast<double>(event_no) /
+                    static_cast<double>(nentries)
+            );
+        }
 
         // Read next event.
         reader.next();
@@ -114,19 +191,189 @@ static int run(
         // Fill banks from hipo event.
         luint total_nrows = 0;
         for (uint i = 0; i < nbanks; ++i) {
-            event.getStructure(hbanks[i]);
-            if (rge_fill(&(rbanks[i]), hbanks[i])) return 1;
-            total_nrows += rbanks[i].nrows;
+            event.getStructure(conv->hbanks[i]);
+            if (rge_fill(&(conv->rbanks[i]), conv->hbanks[i])) {
+                if (readahead) rge_readahead_close(&ra);
+                return 1;
+            }
+            total_nrows += conv->rbanks[i].nrows;
         }
 
         // Write to tree *if* event is not empty.
         if (total_nrows > 0) out_tree->Fill();
     }
 
-    // Write to root tree and clean up after ourselves.
+    if (readahead) rge_readahead_close(&ra);
+
+    // Write to root tree and metadata, and clean up after ourselves.
+    out_file->cd();
+    auto write_start = std::chrono::steady_clock::now();
     out_tree->Write();
+    *write_time += elapsed(write_start);
+    std::set<int> runs = {run_no};
+    rge_write_runlist(out_file, &runs);
     out_file->Close();
 
+    return 0;
+}
+
+/** run() function of the program. Check USAGE_MESSAGE for details. */
+static int run(
+        char **in_filenames, int *run_nos, int nfiles, char *work_dir,
+        bool use_fmt, bool merge, bool readahead, lint nevents, lint nthreads,
+        lint imt_nthreads
+) {
+    // Number of banks to read/write depends on type of analysis.
+    uint nbanks = use_fmt ? NBANKS : NBANKS_NOFMT;
+
+    // Count input files of each run.
+    std::map<int, int> run_nfiles;
+    for (int file_i = 0; file_i < nfiles; ++file_i) {
+        ++run_nfiles[run_nos[file_i]];
+    }
+
+    // Define output filenames. Runs with a single file keep the usual name.
+    std::vector<std::vector<char>> out_filenames(static_cast<luint>(nfiles));
+    std::map<int, int> run_counter;
+    for (luint file_i = 0; file_i < out_filenames.size(); ++file_i) {
+        int run_no = run_nos[file_i];
+        out_filenames[file_i].resize(PATH_MAX);
+        if (run_nfiles[run_no] == 1) {
+            sprintf(
+                    out_filenames[file_i].data(), "%s/banks_%06d.root",
+                    work_dir, run_no
+            );
+        }
+        else {
+            sprintf(
+                    out_filenames[file_i].data(), "%s/banks_%03d_%06d.root",
+                    work_dir, run_counter[run_no]++, run_no
+            );
+        }
+    }
+
+    // Convert files, with each worker thread taking the next available file.
+    lint nworkers = nfiles < nthreads ? nfiles : nthreads;
+    if (nfiles > 1) {
+        printf(
+                "Converting %d files using %ld thread(s).\n", nfiles, nworkers
+        );
+        rge_pbar_set_nentries(nfiles);
+    }
+    if (nworkers > 1) ROOT::EnableThreadSafety();
+    if (imt_nthreads > 0) {
+        ROOT::EnableImplicitMT(static_cast<uint>(imt_nthreads));
+    }
+
+    // Stage input files through local scratch if RGE_SCRATCH is set, keeping
+    //     one file ready for each worker, plus the next one. Outputs are
+    //     written to scratch and moved to work_dir in the background.
+    rge_stager stager;
+    rge_stager_init(
+            &stager, in_filenames, nfiles, NULL,
+            static_cast<luint>(nworkers) + 1
+    );
+
+    std::atomic<int>  next_file(0);
+    std::atomic<int>  nconverted(0);
+    std::atomic<lint> nfinished(0);
+    std::atomic<bool> failed(false);
+    std::vector<double> write_times(static_cast<luint>(nworkers), 0.);
+    std::vector<std::thread> workers;
+    auto convert_start = std::chrono::steady_clock::now();
+    for (lint worker_i = 0; worker_i < nworkers; ++worker_i) {
+        workers.emplace_back([&, worker_i] {
+            converter conv;
+            conv.is_init = false;
+            for (
+                    int file_i = next_file++;
+                    file_i < nfiles && !failed; file_i = next_file++
+            ) {
+                const char *in_filename =
+                        rge_stager_acquire(&stager, file_i);
+                char out_filename[PATH_MAX];
+                const char *final_filename =
+                        out_filenames[static_cast<luint>(file_i)].data();
+                rge_stager_output(&stager, final_filename, out_filename);
+                if (convert_file(
+                        &conv, in_filename, out_filename, nbanks,
+                        run_nos[file_i], nevents, nfiles == 1, readahead,
+                        &(write_times[static_cast<luint>(worker_i)])
+                )) {
+                    failed = true;
+                }
+                else {
+                    rge_stager_commit(&stager, out_filename, final_filename);
+                }
+                rge_stager_release(&stager, file_i);
+                ++nconverted;
+            }
+            ++nfinished;
+        });
+    }
+
+    // Update progress bar from the main thread while workers run.
+    int shown = 0;
+    while (nfinished < nworkers) {
+        if (nfiles > 1) {
+            for (; shown < nconverted; ++shown) rge_pbar_update(shown);
+        }
+        usleep(PBAR_PERIOD);
+    }
+    for (std::thread &worker : workers) worker.join();
+    double convert_time = elapsed(convert_start);
+    if (nfiles > 1) for (; shown < nconverted; ++shown) rge_pbar_update(shown);
+
+    // Wait for outputs to reach work_dir before merging them.
+    if (rge_stager_close(&stager) || failed) return 1;
+
+    // Report the wall time of the conversion, which includes filling and
+    //     compressing the trees, so that runs with and without -T can be
+    //     compared. Final writes are timed in each thread, and their sum is
+    //     printed separately.
+    double write_time = 0.;
+    for (luint worker_i = 0; worker_i < write_times.size(); ++worker_i) {
+        write_time += write_times[worker_i];
+    }
+    printf(
+            "Wall time converting and writing trees: %.3f s (implicit MT %s).\n"
+            "Final tree writes, summed over %ld thread(s): %.3f s.\n",
+            convert_time,
+            imt_nthreads > 0 ? Form("on, %ld threads", imt_nthreads) : "off",
+            nworkers, write_time
+    );
+
+    // Merge output files of each run, following the order of input files.
+    if (merge) {
+        std::map<int, int>::const_iterator run_it;
+        for (
+                run_it = run_nfiles.begin(); run_it != run_nfiles.end();
+                ++run_it
+        ) {
+            if (run_it->second == 1) continue;
+
+            std::vector<char *> run_filenames;
+            for (luint file_i = 0; file_i < out_filenames.size(); ++file_i) {
+                if (run_nos[file_i] != run_it->first) continue;
+                run_filenames.push_back(out_filenames[file_i].data());
+            }
+
+            char out_filename[PATH_MAX];
+            sprintf(
+                    out_filename, "%s/banks_%06d.root", work_dir,
+                    run_it->first
+            );
+            printf("Merging %d files into %s.\n", run_it->second, out_filename);
+            if (rge_merge_files(
+                    run_filenames.data(), run_it->second, out_filename, true
+            )) return 1;
+
+            for (luint i = 0; i < run_filenames.size(); ++i) {
+                unlink(run_filenames[i]);
+            }
+        }
+    }
+
     rge_errno = RGEERR_NOERR;
     return 0;
 }
@@ -136,29 +383,41 @@ static int run(
  *     in the handle_err() function.
  */
 static int handle_args(
-        int argc, char **argv, char **in_filename, char **work_dir,
-        bool *use_fmt, int *run_no, lint *nevents
+        int argc, char **argv, char **in_filenames, int *run_nos, int *nfiles,
+        char **work_dir, bool *use_fmt, bool *merge, bool *readahead,
+        lint *nevents, lint *nthreads, lint *imt_nthreads
 ) {
     // Handle arguments.
     int opt;
-    while ((opt = getopt(argc, argv, "-hfn:w:")) != -1) {
+    while ((opt = getopt(argc, argv, "-hafmn:j:T:w:")) != -1) {
         switch (opt) {
             case 'h':
                 rge_errno = RGEERR_USAGE;
                 return 1;
+            case 'a':
+                *readahead = true;
+                break;
             case 'f':
                 *use_fmt = true;
                 break;
+            case 'm':
+                *merge = true;
+                break;
             case 'n':
                 if (rge_process_nentries(nevents, optarg)) return 1;
                 break;
+            case 'j':
+                if (rge_process_nthreads(nthreads, optarg)) return 1;
+                break;
+            case 'T':
+                if (rge_process_nthreads(imt_nthreads, optarg)) return 1;
+                break;
             case 'w':
                 *work_dir = static_cast<char *>(malloc(strlen(optarg) + 1));
                 strcpy(*work_dir, optarg);
                 break;
             case 1:
-                *in_filename = static_cast<char *>(malloc(strlen(optarg) + 1));
-                strcpy(*in_filename, optarg);
+                rge_grab_string(optarg, &(in_filenames[(*nfiles)++]));
                 break;
             default:
                 rge_errno = RGEERR_BADOPTARGS;
@@ -172,13 +431,16 @@ static int handle_args(
         sprintf(*work_dir, "%s/../root_io", dirname(argv[0]));
     }
 
-    // Check that a positional argument was given.
-    if (*in_filename == NULL) {
+    // Check that positional arguments were given.
+    if (*nfiles == 0) {
         rge_errno = RGEERR_NOINPUTFILE;
         return 1;
     }
 
-    if (rge_handle_hipo_filename(*in_filename, run_no)) return 1;
+    for (int file_i = 0; file_i < *nfiles; ++file_i) {
+        if (rge_handle_hipo_filename(in_filenames[file_i], &(run_nos[file_i])))
+            return 1;
+    }
 
     return 0;
 }
@@ -186,24 +448,36 @@ static int handle_args(
 /** Entry point of hipo2root. Check usage() for details. */
 int main(int argc, char **argv) {
     // Handle arguments.
-    char *in_filename  = NULL;
-    char *work_dir     = NULL;
-    bool use_fmt       = false;
-    int  run_no        = -1;
-    lint nevents       = -1;
+    luint nargs         = static_cast<luint>(argc);
+    char **in_filenames = static_cast<char **>(malloc(nargs * sizeof(char *)));
+    int *run_nos        = static_cast<int *>(malloc(nargs * sizeof(int)));
+    int nfiles          = 0;
+    char *work_dir      = NULL;
+    bool use_fmt        = false;
+    bool merge          = false;
+    bool readahead      = false;
+    lint nevents        = -1;
+    lint nthreads       = 1;
+    lint imt_nthreads   = 0;
 
     handle_args(
-            argc, argv, &in_filename, &work_dir, &use_fmt, &run_no, &nevents
+            argc, argv, in_filenames, run_nos, &nfiles, &work_dir, &use_fmt,
+            &merge, &readahead, &nevents, &nthreads, &imt_nthreads
     );
 
     // Run.
     if (rge_errno == RGEERR_UNDEFINED) {
-        run(in_filename, work_dir, use_fmt, run_no, nevents);
+        run(
+                in_filenames, run_nos, nfiles, work_dir, use_fmt, merge,
+                readahead, nevents, nthreads, imt_nthreads
+        );
     }
 
     // Free up memory.
-    if (in_filename != NULL) free(in_filename);
-    if (work_dir    != NULL) free(work_dir);
+    for (int file_i = 0; file_i < nfiles; ++file_i) free(in_filenames[file_i]);
+    free(in_filenames);
+    free(run_nos);
+    if (work_dir != NULL) free(work_dir);
 
     // Return errcode.
     return rge_print_usage(USAGE_MESSAGE);
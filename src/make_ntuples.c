@@ -16,6 +16,14 @@
 // C.
 #include <libgen.h>
 #include <limits.h>
+#include <unistd.h>
+
+// C++.
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+#include <vector>
 
 // ROOT.
 #include <TFile.h>
@@ -24,17 +32,23 @@
 
 // rge-analysis.
 #include "../lib/rge_constants.h"
+#include "../lib/rge_dist.h"
 #include "../lib/rge_err_handler.h"
 #include "../lib/rge_extract_sf.h"
+#include "../lib/rge_fiducial.h"
 #include "../lib/rge_file_handler.h"
 #include "../lib/rge_filename_handler.h"
 #include "../lib/rge_hipo_bank.h"
 #include "../lib/rge_io_handler.h"
+#include "../lib/rge_latency.h"
+#include "../lib/rge_metadata.h"
 #include "../lib/rge_particle.h"
 #include "../lib/rge_progress.h"
+#include "../lib/rge_staging.h"
+#include "../lib/rge_trace.h"
 
 static const char *USAGE_MESSAGE =
-"Usage: make_ntuples [-hDf:cn:w:d:] infile\n"
+"Usage: make_ntuples [-hDf:cgspLRn:j:T:l:t:e:w:d:] infile1 [infile2 ...]\n"
 " * -h         : show this message and exit.\n"
 " * -D         : activate debug mode.\n"
 " * -f fmtlyrs : define how many FMT layers should the track have hit.\n"
@@ -42,13 +56,48 @@ static const char *USAGE_MESSAGE =
 "                something other than 0 and there is no FMT::Tracks bank in\n"
 "                the input file, the program will crash. Default is 0.\n"
 " * -c         : apply FMT geometry cut on data.\n"
-" * -n nevents : number of events.\n"
+" * -g         : apply DC fiducial cuts on data, and PCAL fiducial cuts on\n"
+"                the trigger electron.\n"
+" * -s         : only write events passing the DIS selection (Q2, W2, and\n"
+"                Yb cuts on the trigger electron). Downstream programs then\n"
+"                skip their own DIS cuts.\n"
+" * -p         : reconstruct pi0 candidates from pairs of photons in each\n"
+"                event with a trigger electron, and write them to a\n"
+"                separate pi0 tree.\n"
+" * -L         : load banks lazily. REC::Particle and REC::Track are read\n"
+"                first, and the calorimeter, Cherenkov, scintillator, and\n"
+"                FMT banks are only read for events with a trigger electron\n"
+"                candidate (a negative track with status < 0). Output is the\n"
+"                same, and the compressed bytes not read are reported.\n"
+" * -R         : recompute mode. Input files are ntuples files written by\n"
+"                this program, whose kinematics tree is recomputed in place\n"
+"                from the primary variables in their data tree, using the\n"
+"                current beam energies and kinematics definitions. Files can\n"
+"                be from different runs. All other options are ignored.\n"
+" * -n nevents : number of events, counted across all input files.\n"
+" * -j nthread : number of threads used to process events. Default is 1.\n"
+" * -T nthread : enable ROOT's implicit multi-threading with nthread threads,\n"
+"                compressing output baskets in parallel.\n"
+" * -l nslow   : record the processing time of each event, and print its\n"
+"                distribution and the nslow slowest events together with\n"
+"                the size of their banks.\n"
+" * -t period  : trace the PID decisions, detector sums, and cut outcomes of\n"
+"                each track in every event whose number is a multiple of\n"
+"                period. Trace is written to a binary file in workdir, read\n"
+"                by decode_trace. Requires building with `make TRACE=1`.\n"
+" * -e evn     : trace event number evn. Can be given more than once, and\n"
+"                combined with -t. Requires building with `make TRACE=1`.\n"
 " * -w workdir : location where output root files are to be stored. Default\n"
 "                is root_io.\n"
 " * -d datadir : location where sampling fraction files are. Default is data.\n"
-" * infile     : input ROOT file. Expected file format: <text>run_no.root`.\n\n"
+" * infile     : input ROOT files, all from the same run. Expected file\n"
+"                format: <text>run_no.root`.\n\n"
 "    Generate ntuples relevant to SIDIS analysis based on the reconstructed\n"
-"    variables from CLAS12 data.\n";
+"    variables from CLAS12 data. All input files are treated as partitions of\n"
+"    one run, processed concurrently, and written to a single output file\n"
+"    with continuous event numbers, following the order of the input files.\n"
+"    Primary variables are written to the data tree, and the derived DIS and\n"
+"    SIDIS kinematics (and the beam energy) to its kinematics friend tree.\n";
 
 /** Detector IDs from CLAS12 reconstruction. */
 static const uint FTOF_ID = 12;
@@ -66,6 +115,61 @@ static const double FMTCUT_RMAX  = 18.4800;
 static const double FMTCUT_Z0    = 26.1197;
 static const double FMTCUT_ANGLE = 57.29;
 
+/** pi0 reconstruction constants. */
+static const double PI0_MINPHOTONE = 0.2; /** Minimum photon energy (GeV). */
+static const double PI0_MAXMASS    = 0.4; /** Maximum diphoton mass (GeV). */
+static const luint  PI0_NPHOTONS   = 32;  /** Photons preallocated per task. */
+
+/** Number of tasks per thread, used to balance partitions of different size. */
+static const lint TASKS_PER_THREAD = 4;
+
+/** Banks whose sizes are logged for the slowest events, in recording order. */
+static const char *LATENCY_BANKS[RGE_LATENCYNBANKS] = {
+        RGE_RECPARTICLE, RGE_RECTRACK, RGE_RECCALORIMETER, RGE_RECCHERENKOV,
+        RGE_RECSCINTILLATOR
+};
+
+/** Time between progress bar updates when using threads (us). */
+static const useconds_t PBAR_PERIOD = 50000;
+
+/**
+ * Range of events from one input file processed by a single thread.
+ *
+ * @param file_i       : index of the input file in the list of inputs.
+ * @param filename_in  : input file. Set to its staged copy before processing.
+ * @param first_event  : first entry of the input file processed.
+ * @param last_event   : entry after the last one processed.
+ * @param event_offset : number of events in the previous input files, added to
+ *                       entry numbers to get continuous event numbers.
+ * @param filename_out : file where the task's ntuples are written.
+ * @param counters     : number of trigger electrons, pi+, pi-, and pi0
+ *                       candidates found.
+ * @param write_time   : wall time spent writing the output ntuples at the end,
+ *                       including compression of the last baskets (s).
+ * @param latency      : processing time of the task's events, if recorded.
+ * @param nlazy        : number of events whose detector banks weren't read
+ *                       when loading banks lazily.
+ * @param lazy_bytes   : estimated compressed size of the banks not read.
+ */
+typedef struct {
+    int file_i;
+    const char *filename_in;
+    lint first_event, last_event, event_offset;
+    char filename_out[PATH_MAX];
+    lint counters[4];
+    double write_time;
+    rge_latency latency;
+    lint nlazy;
+    double lazy_bytes;
+} ntuples_task;
+
+/** Return the wall time elapsed since start, in seconds. */
+static double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start
+    ).count();
+}
+
 /**
  * Find and return the most precise time of flight (TOF). Both the Forward Time
  *     Of Flight (FTOF) detectors and the Electronic Calorimeter (EC) can
@@ -270,79 +374,174 @@ static int apply_fmtgeomtry_cut(rge_particle *p) {
     return 0;
 }
 
-/** run() function of the program. Check USAGE_MESSAGE for details. */
-static int run(
-        char *filename_in, char *work_dir, char *data_dir, bool debug,
-        lint fmt_nlayers, bool fmt_cut, lint n_events, int run_no,
-        double energy_beam
+/**
+ * Check if an event can have a trigger electron, using only REC::Particle and
+ *     REC::Track. rge_set_pid() only assigns PID 11 to negative particles, and
+ *     the trigger must have status < 0, so events without such a track are
+ *     discarded by the trigger search regardless of the other banks.
+ *
+ * @param particle : pointer to rge_hipobank struct with particle data.
+ * @param track    : pointer to rge_hipobank struct with track data.
+ * @return         : true if the event has a trigger electron candidate.
+ */
+static bool has_trigger_candidate(rge_hipobank *particle, rge_hipobank *track) {
+    for (uint pos = 0; pos < track->nrows; ++pos) {
+        uint pindex = rge_get_uint(track, "pindex", pos);
+        if (
+                rge_get_double(particle, "charge", pindex) < 0 &&
+                rge_get_double(particle, "status", pindex) < 0
+        ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Get the local coordinates of a particle's hit in PCAL.
+ *
+ * @param calorimeter : pointer to rge_hipobank struct with calorimeter data.
+ * @param pindex      : particle index of the particle we're studying.
+ * @param sector      : pointer to int where we'll write the hit's sector.
+ * @param lv          : pointer to double where we'll write the hit's lv.
+ * @param lw          : pointer to double where we'll write the hit's lw.
+ * @return            : 0 if a PCAL hit was found, 1 otherwise.
+ */
+static int get_pcal_coordinates(
+        rge_hipobank *calorimeter, uint pindex, int *sector, double *lv,
+        double *lw
 ) {
-    // Get sampling fraction.
-    char sampling_fraction_file[PATH_MAX];
-    if (run_no / 1000 != 999) {
-        // Input file is data.
-        sprintf(
-                sampling_fraction_file, "%s/sf_params_%06d.txt",
-                data_dir, run_no
-        );
+    for (uint i = 0; i < calorimeter->nrows; ++i) {
+        if (rge_get_uint(calorimeter, "pindex", i) != pindex) continue;
+        if (rge_get_int (calorimeter, "layer",  i) != PCAL_LYR) continue;
+
+        *sector = rge_get_int   (calorimeter, "sector", i);
+        *lv     = rge_get_double(calorimeter, "lv",     i);
+        *lw     = rge_get_double(calorimeter, "lw",     i);
+        return 0;
     }
-    else {
-        // Input file is simulation.
-        sprintf(sampling_fraction_file, "%s/sf_params_mc.txt", data_dir);
+
+    return 1;
+}
+
+/**
+ * Join the names in RGE_VARS of the variables at addrs with ':', as expected
+ *     by the TNtuple constructor.
+ */
+static TString join_vars(const int *addrs, int size) {
+    TString vars_string("");
+    for (int var_i = 0; var_i < size; ++var_i) {
+        vars_string.Append(Form("%s", RGE_VARS[addrs[var_i]]));
+        if (var_i != size-1) vars_string.Append(":");
     }
-    double sampling_fraction_params[RGE_NSECTORS][RGE_NSFPARAMS][2];
-    if (access(sampling_fraction_file, F_OK) != 0) {
-        // No sampling fraction file for this run, we need to extract it.
-        printf(
-                "No sampling fraction data found for run %d. Running "
-                "extract_sf().\n", run_no
-        );
-        if (rge_extract_sf(filename_in, work_dir, data_dir, n_events, run_no)) {
-            return 1;
-        }
-        printf("Done!\n\n");
-        rge_errno = RGEERR_UNDEFINED;
+    return vars_string;
+}
+
+/**
+ * Fill the data tree with the primary variables of arr, and the kinematics
+ *     friend tree with its derived kinematics. arr follows the order of
+ *     RGE_VARS.
+ */
+static int fill_ntuples(TNtuple *data, TNtuple *kin, Float_t *arr) {
+    Float_t prim_arr[RGE_PRIMVARS_SIZE];
+    for (int var_i = 0; var_i < RGE_PRIMVARS_SIZE; ++var_i) {
+        prim_arr[var_i] = arr[RGE_PRIMVARS[var_i]];
     }
-    if (rge_get_sf_params(sampling_fraction_file, sampling_fraction_params)) {
-        return 1;
+    Float_t kin_arr[RGE_KINVARS_SIZE];
+    for (int var_i = 0; var_i < RGE_KINVARS_SIZE; ++var_i) {
+        kin_arr[var_i] = arr[RGE_KINVARS[var_i]];
     }
 
+    data->Fill(prim_arr);
+    kin->Fill(kin_arr);
+    return 0;
+}
+
+/**
+ * Process the events of one task, writing their ntuples and metadata to the
+ *     task's output file. Tasks run concurrently, so all the state used here is
+ *     either local or read-only.
+ *
+ * @param task       : task to be processed. Its counters are filled here.
+ * @param nprocessed : number of events processed, shared by all tasks.
+ * @return           : error code. 0 if successful, 1 otherwise.
+ *
+ * All other parameters are the same as in run().
+ */
+static int process_task(
+        ntuples_task *task, lint fmt_nlayers, bool fmt_cut, bool fid_cut,
+        bool dis_skim, bool pi0, bool lazy, lint nslow,
+        rge_tracelog *tracelog, rge_fiducial *fiducial,
+        double sampling_fraction_params[RGE_NSECTORS][RGE_NSFPARAMS][2],
+        int run_no, double energy_beam, std::atomic<lint> *nprocessed
+) {
     // Access input file.
-    TFile *file_in  = TFile::Open(filename_in, "READ");
+    TFile *file_in = TFile::Open(task->filename_in, "READ");
     if (!file_in || file_in->IsZombie()) {
         rge_errno = RGEERR_BADINPUTFILE;
         return 1;
     }
-
-    // If fmt_nlayers != 0, check that FMT::Tracks bank exists.
-    if (fmt_nlayers != 0 && file_in->GetListOfKeys()->Contains(RGE_FMTTRACKS)) {
-        rge_errno = RGEERR_NOFMTBANK;
+    TTree *tree_in = file_in->Get<TTree>(RGE_TREENAMEDATA);
+    if (tree_in == NULL) {
+        file_in->Close();
+        rge_errno = RGEERR_BADROOTFILE;
         return 1;
     }
 
-    // Return to top directory (weird root stuff).
-    gROOT->cd();
-
-    // Generate lists of variables.
-    TString vars_string("");
-    for (int var_i = 0; var_i < RGE_VARS_SIZE; ++var_i) {
-        vars_string.Append(Form("%s", RGE_VARS[var_i]));
-        if (var_i != RGE_VARS_SIZE-1) vars_string.Append(":");
+    // Create output file.
+    TFile *file_out = TFile::Open(task->filename_out, "RECREATE");
+    if (!file_out || file_out->IsZombie()) {
+        file_in->Close();
+        rge_errno = RGEERR_OUTPUTROOTFAILED;
+        return 1;
     }
 
-    // Create TTree and TNTuples.
-    TTree *tree_in = file_in->Get<TTree>(RGE_TREENAMEDATA);
-    if (tree_in == NULL) {
-        rge_errno = RGEERR_BADROOTFILE;
+    // Close both files before returning on error.
+    auto fail = [file_in, file_out]() {
+        file_in ->Close();
+        file_out->Close();
         return 1;
-    }
-    TNtuple *tree_out;
-    tree_out = new TNtuple(RGE_TREENAMEDATA, RGE_TREENAMEDATA, vars_string);
+    };
 
-    // Change n_events to number of entries if it is equal to -1 or invalid.
-    if (n_events == -1 || n_events > tree_in->GetEntries()) {
-        n_events = tree_in->GetEntries();
+    // Create TNtuples in output file. Primary variables go to the data tree,
+    //     and derived kinematics to its friend tree, so that they can be
+    //     recomputed with -R.
+    file_out->cd();
+    TNtuple *tree_out = new TNtuple(
+            RGE_TREENAMEDATA, RGE_TREENAMEDATA,
+            join_vars(RGE_PRIMVARS, RGE_PRIMVARS_SIZE)
+    );
+    TNtuple *kin_out = new TNtuple(
+            RGE_TREENAMEKIN, RGE_TREENAMEKIN,
+            join_vars(RGE_KINVARS, RGE_KINVARS_SIZE)
+    );
+
+    // Exact event number, filled by TNtuple::Fill() along with the Float_t
+    //     variables.
+    Long64_t evn64 = 0;
+    tree_out->Branch(RGE_EVENTNO64, &evn64, RGE_EVENTNO64 "/L");
+
+    // Create pi0 TNtuple in output file.
+    TNtuple *pi0_out = NULL;
+    if (pi0) {
+        TString pi0_vars_string("");
+        for (int var_i = 0; var_i < RGE_PI0VARS_SIZE; ++var_i) {
+            pi0_vars_string.Append(Form("%s", RGE_PI0VARS[var_i]));
+            if (var_i != RGE_PI0VARS_SIZE-1) pi0_vars_string.Append(":");
+        }
+        pi0_out = new TNtuple(
+                RGE_TREENAMEPI0, RGE_TREENAMEPI0, pi0_vars_string
+        );
+        pi0_out->Branch(RGE_EVENTNO64, &evn64, RGE_EVENTNO64 "/L");
     }
 
+    // Photons of the current event. Preallocated once per task, since clear()
+    //     keeps their capacity between events.
+    std::vector<rge_particle> photons;
+    std::vector<double> photons_E;
+    photons.reserve(PI0_NPHOTONS);
+    photons_E.reserve(PI0_NPHOTONS);
+
     // Associate banks to TTree.
     rge_hipobank bpart = rge_hipobank_init(RGE_RECPARTICLE,     tree_in);
     rge_hipobank btrk  = rge_hipobank_init(RGE_RECTRACK,        tree_in);
@@ -351,30 +550,106 @@ static int run(
     rge_hipobank bsci  = rge_hipobank_init(RGE_RECSCINTILLATOR, tree_in);
     rge_hipobank bfmt  = rge_hipobank_init(RGE_FMTTRACKS,       tree_in);
 
-    // Iterate through input file. Each TTree entry is one event.
-    printf("Processing %ld events from %s.\n", n_events, filename_in);
+    // PCAL fiducial cuts need the lv and lw columns, which files converted by
+    //     older versions of hipo2root lack.
+    if (fid_cut && (!bcal.entries.count("lv") || !bcal.entries.count("lw"))) {
+        rge_errno = RGEERR_NOPCALCOORDS;
+        return fail();
+    }
 
-    // Prepare fancy progress bar.
-    rge_pbar_reset();
-    rge_pbar_set_nentries(n_events);
+    // Banks are read in batches of RGE_BATCHNEVENTS events. When loading
+    //     lazily, only REC::Particle and REC::Track are batched, and the
+    //     rest are read per event if needed. When timing events, batches
+    //     have one event so that each event's time includes its reads.
+    std::vector<rge_hipobank *> banks = {&bpart, &btrk, &bcal, &bchkv, &bsci};
+    if (fmt_nlayers != 0) banks.push_back(&bfmt);
+    luint nbatched  = lazy ? 2 : banks.size();
+    lint batch_size = nslow >= 0 ? 1 : RGE_BATCHNEVENTS;
+    std::vector<rge_hipobatch> batches(nbatched, rge_hipobatch_init());
+    lint batch_end  = task->first_event;
+
+    // Average compressed size of the banks skipped when loading lazily.
+    double lazy_entry_bytes = 0.;
+    if (lazy && tree_in->GetEntries() > 0) {
+        lint nbytes = rge_get_zipbytes(&bcal) + rge_get_zipbytes(&bchkv) +
+                rge_get_zipbytes(&bsci);
+        if (fmt_nlayers != 0) nbytes += rge_get_zipbytes(&bfmt);
+        lazy_entry_bytes = static_cast<double>(nbytes) /
+                static_cast<double>(tree_in->GetEntries());
+    }
 
     // Particle counters.
-    int trigger_counter = 0;
-    int pionp_counter   = 0;
-    int pionm_counter   = 0;
-
-    // Loop through events in input file.
-    for (lint event = 0; event < n_events; ++event) {
-        // Print fancy progress bar.
-        if (!debug) rge_pbar_update(event);
-
-        // Get entries from input file.
-        rge_get_entries(&bpart, tree_in, event);
-        rge_get_entries(&btrk,  tree_in, event);
-        rge_get_entries(&bcal,  tree_in, event);
-        rge_get_entries(&bchkv, tree_in, event);
-        rge_get_entries(&bsci,  tree_in, event);
-        if (fmt_nlayers != 0) rge_get_entries(&bfmt, tree_in, event);
+    lint trigger_counter = 0;
+    lint pionp_counter   = 0;
+    lint pionm_counter   = 0;
+    lint pi0_counter     = 0;
+
+    // Debug tracer, only used in builds with RGE_TRACING.
+    rge_tracer tracer = rge_tracer_init(tracelog);
+
+    // Record the processing time of the last event read, whose data is still
+    //     in the banks. Events end at many different points of the loop,
+    //     so each one is recorded when the next one starts.
+    auto event_start = std::chrono::steady_clock::now();
+    auto record_latency = [&](lint evn) {
+        luint nrows[RGE_LATENCYNBANKS] = {
+                bpart.nrows, btrk.nrows, bcal.nrows, bchkv.nrows, bsci.nrows
+        };
+        rge_latency_record(&(task->latency), elapsed(event_start), evn, nrows);
+    };
+
+    // Loop through events in task.
+    for (lint event = task->first_event; event < task->last_event; ++event) {
+        // Count event for the progress bar.
+        nprocessed->fetch_add(1, std::memory_order_relaxed);
+
+        // Record previous event and start timing this one.
+        if (nslow >= 0) {
+            if (event != task->first_event) {
+                record_latency(task->event_offset + event - 1);
+            }
+            event_start = std::chrono::steady_clock::now();
+        }
+
+        // Event number, continuous across partitions.
+        lint evn = task->event_offset + event;
+        evn64 = evn;
+        RGE_TRACEEVENT(&tracer, evn);
+
+        // Get entries from input file, reading the next batch if needed.
+        if (event == batch_end) {
+            batch_end = event + batch_size < task->last_event ?
+                    event + batch_size : task->last_event;
+            for (luint bi = 0; bi < nbatched; ++bi) {
+                rge_get_batch(
+                        banks[bi], tree_in, event, batch_end - event,
+                        &(batches[bi])
+                );
+            }
+        }
+        for (luint bi = 0; bi < nbatched; ++bi) {
+            if (rge_select_event(banks[bi], &(batches[bi]), event)) {
+                return fail();
+            }
+        }
+
+        // When loading lazily, the detector banks are skipped if the event
+        //     can't have a trigger electron, unless the event is traced.
+        if (lazy && !tracer.active && (
+                bpart.nrows == 0 || btrk.nrows == 0 ||
+                !has_trigger_candidate(&bpart, &btrk)
+        )) {
+            bcal.nrows  = 0;
+            bchkv.nrows = 0;
+            bsci.nrows  = 0;
+            bfmt.nrows  = 0;
+            ++(task->nlazy);
+            task->lazy_bytes += lazy_entry_bytes;
+            continue;
+        }
+        for (luint bi = nbatched; bi < banks.size(); ++bi) {
+            rge_get_entries(banks[bi], tree_in, event);
+        }
 
         // Filter events without the necessary banks.
         if (bpart.nrows == 0 || btrk.nrows == 0) continue;
@@ -394,25 +669,81 @@ static int run(
             );
 
             // Skip particle if it doesn't fit requirements.
-            if (!part_trigger.is_valid) continue;
+            if (!part_trigger.is_valid) {
+                RGE_TRACECUT(
+                        &tracer, RGE_TRACEINVALID, RGE_TRACESEARCH, pindex, -1,
+                        -1.
+                );
+                continue;
+            }
 
             // Cut triggers outside of FMT's active region.
             if (fmt_cut) {
                 int result = apply_fmtgeomtry_cut(&part_trigger);
-                if (result == 1) continue;
-                if (result == 2) return 1;
+                if (result == 1) {
+                    RGE_TRACECUT(
+                            &tracer, RGE_TRACEFMTCUT, RGE_TRACESEARCH, pindex,
+                            part_trigger.sector, rge_calc_magnitude(
+                                    part_trigger.px, part_trigger.py,
+                                    part_trigger.pz
+                            )
+                    );
+                    continue;
+                }
+                if (result == 2) return fail();
+            }
+
+            // Cut triggers outside of DC's and PCAL's fiducial regions.
+            if (fid_cut) {
+                int result = rge_apply_dc_fiducial_cut(
+                        fiducial, part_trigger.sector, part_trigger.px,
+                        part_trigger.py, part_trigger.pz
+                );
+                if (result == 1) {
+                    RGE_TRACECUT(
+                            &tracer, RGE_TRACEDCCUT, RGE_TRACESEARCH, pindex,
+                            part_trigger.sector, rge_calc_magnitude(
+                                    part_trigger.px, part_trigger.py,
+                                    part_trigger.pz
+                            )
+                    );
+                    continue;
+                }
+                if (result == 2) return fail();
+
+                int pcal_sector;
+                double lv, lw;
+                result = 1;
+                if (!get_pcal_coordinates(
+                        &bcal, pindex, &pcal_sector, &lv, &lw
+                )) {
+                    result = rge_apply_pcal_fiducial_cut(
+                            fiducial, pcal_sector, lv, lw
+                    );
+                }
+                if (result == 1) {
+                    RGE_TRACECUT(
+                            &tracer, RGE_TRACEPCALCUT, RGE_TRACESEARCH, pindex,
+                            part_trigger.sector, rge_calc_magnitude(
+                                    part_trigger.px, part_trigger.py,
+                                    part_trigger.pz
+                            )
+                    );
+                    continue;
+                }
+                if (result == 2) return fail();
             }
 
             // Get energy deposited in calorimeters.
             double energy_PCAL, energy_ECIN, energy_ECOU;
             if (get_deposited_energy(
                     &bcal, pindex, &energy_PCAL, &energy_ECIN, &energy_ECOU
-            )) return 1;
+            )) return fail();
 
             // Get number of photoelectrons from Cherenkov counters.
             int nphe_HTCC, nphe_LTCC;
             if (count_photoelectrons(&bchkv, pindex, &nphe_HTCC, &nphe_LTCC))
-                return 1;
+                return fail();
 
             // Get time of flight from scintillators or calorimeters.
             double tof = get_tof(&bsci, &bcal, pindex);
@@ -428,7 +759,16 @@ static int run(
                     status, energy_PCAL+energy_ECIN+energy_ECOU, energy_PCAL,
                     nphe_HTCC, nphe_LTCC,
                     sampling_fraction_params[rge_get_uint(&btrk, "sector", pos)]
-            )) return 1;
+            )) return fail();
+            RGE_TRACEPID(
+                    &tracer, RGE_TRACESEARCH, pindex, part_trigger.sector,
+                    rge_calc_magnitude(
+                            part_trigger.px, part_trigger.py, part_trigger.pz
+                    ),
+                    rge_get_int(&bpart, "pid", pindex), part_trigger.pid,
+                    status, energy_PCAL, energy_ECIN, energy_ECOU, nphe_HTCC,
+                    nphe_LTCC
+            );
 
             // Skip particle if its not the trigger electron.
             if (!part_trigger.is_trigger) continue;
@@ -436,12 +776,30 @@ static int run(
             // Fill TNtuple with trigger electron information.
             Float_t arr[RGE_VARS_SIZE];
             if (rge_fill_ntuples_arr(
-                    arr, part_trigger, part_trigger, run_no, event, status,
+                    arr, part_trigger, part_trigger, run_no, evn, status,
                     energy_beam, chi2, ndf, energy_PCAL, energy_ECIN,
                     energy_ECOU, tof, tof, nphe_LTCC, nphe_HTCC
-            )) return 1;
+            )) return fail();
+
+            // Skip event if skimming and it fails the DIS selection.
+            if (dis_skim && (
+                    arr[RGE_Q2.addr] < RGE_Q2CUT ||
+                    arr[RGE_W2.addr] < RGE_W2CUT ||
+                    arr[RGE_YB.addr] > RGE_YBCUT
+            )) {
+                RGE_TRACECUT(
+                        &tracer, RGE_TRACEDISSKIM, RGE_TRACESEARCH, pindex,
+                        part_trigger.sector, arr[RGE_P.addr]
+                );
+                break;
+            }
 
-            tree_out->Fill(arr);
+            RGE_TRACECUT(
+                    &tracer, RGE_TRACETRIGGER, RGE_TRACESEARCH, pindex,
+                    part_trigger.sector, arr[RGE_P.addr]
+            );
+
+            fill_ntuples(tree_out, kin_out, arr);
 
             // Fill out trigger electron data and end loop.
             trigger_exist  = true;
@@ -470,25 +828,54 @@ static int run(
             );
 
             // Skip particle if it doesn't fit requirements.
-            if (!part.is_valid) continue;
+            if (!part.is_valid) {
+                RGE_TRACECUT(
+                        &tracer, RGE_TRACEINVALID, RGE_TRACEPARTICLES, pindex,
+                        -1, -1.
+                );
+                continue;
+            }
 
             // Cut particles outside of FMT's active region.
             if (fmt_cut) {
                 int result = apply_fmtgeomtry_cut(&part);
-                if (result == 1) continue;
-                if (result == 2) return 1;
+                if (result == 1) {
+                    RGE_TRACECUT(
+                            &tracer, RGE_TRACEFMTCUT, RGE_TRACEPARTICLES,
+                            pindex, part.sector,
+                            rge_calc_magnitude(part.px, part.py, part.pz)
+                    );
+                    continue;
+                }
+                if (result == 2) return fail();
+            }
+
+            // Cut particles outside of DC's fiducial region.
+            if (fid_cut) {
+                int result = rge_apply_dc_fiducial_cut(
+                        fiducial, part.sector, part.px, part.py, part.pz
+                );
+                if (result == 1) {
+                    RGE_TRACECUT(
+                            &tracer, RGE_TRACEDCCUT, RGE_TRACEPARTICLES,
+                            pindex, part.sector,
+                            rge_calc_magnitude(part.px, part.py, part.pz)
+                    );
+                    continue;
+                }
+                if (result == 2) return fail();
             }
 
             // Get energy deposited in calorimeters.
             double energy_PCAL, energy_ECIN, energy_ECOU;
             if (get_deposited_energy(
                     &bcal, pindex, &energy_PCAL, &energy_ECIN, &energy_ECOU
-            )) return 1;
+            )) return fail();
 
             // Get Cherenkov counters data.
             int nphe_HTCC, nphe_LTCC;
             if (count_photoelectrons(&bchkv, pindex, &nphe_HTCC, &nphe_LTCC))
-                return 1;
+                return fail();
 
             // Get time-of-flight (tof).
             double tof = get_tof(&bsci, &bcal, pindex);
@@ -504,30 +891,403 @@ static int run(
                     energy_PCAL + energy_ECIN + energy_ECOU, energy_PCAL,
                     nphe_HTCC, nphe_LTCC,
                     sampling_fraction_params[rge_get_uint(&btrk, "sector", pos)]
-            )) return 1;
+            )) return fail();
+            RGE_TRACEPID(
+                    &tracer, RGE_TRACEPARTICLES, pindex, part.sector,
+                    rge_calc_magnitude(part.px, part.py, part.pz),
+                    rge_get_int(&bpart, "pid", pindex), part.pid, status,
+                    energy_PCAL, energy_ECIN, energy_ECOU, nphe_HTCC, nphe_LTCC
+            );
 
             // Fill TNtuples. If adding new variables, check their order in
-            //     RGE_VARS.
+            //     RGE_VARS, and add them to RGE_PRIMVARS or RGE_KINVARS.
             Float_t arr[RGE_VARS_SIZE];
             if (rge_fill_ntuples_arr(
-                    arr, part, part_trigger, run_no, event, status, energy_beam,
+                    arr, part, part_trigger, run_no, evn, status, energy_beam,
                     chi2, ndf, energy_PCAL, energy_ECIN, energy_ECOU, tof,
                     trigger_tof, nphe_LTCC, nphe_HTCC
-            )) return 1;
+            )) return fail();
 
-            tree_out->Fill(arr);
+            fill_ntuples(tree_out, kin_out, arr);
 
             if (part.pid ==  211) ++pionp_counter;
             if (part.pid == -211) ++pionm_counter;
         }
+
+        // Reconstruct pi0 candidates from pairs of photons.
+        if (!pi0) continue;
+        photons.clear();
+        photons_E.clear();
+        for (uint pindex = 0; pindex < bpart.nrows; ++pindex) {
+            // Get energy deposited in calorimeters.
+            double energy_PCAL, energy_ECIN, energy_ECOU;
+            if (get_deposited_energy(
+                    &bcal, pindex, &energy_PCAL, &energy_ECIN, &energy_ECOU
+            )) return fail();
+
+            // Get photon from particle bank.
+            rge_particle photon = rge_photon_init(
+                    &bpart, pindex, energy_PCAL + energy_ECIN + energy_ECOU
+            );
+            if (!photon.is_valid) continue;
+
+            // Photons are massless, so their energy is their momentum.
+            double energy = rge_calc_magnitude(photon.px, photon.py, photon.pz);
+            if (energy < PI0_MINPHOTONE) continue;
+
+            // Cut photons outside of PCAL's fiducial region.
+            if (fid_cut) {
+                int pcal_sector;
+                double lv, lw;
+                if (get_pcal_coordinates(&bcal, pindex, &pcal_sector, &lv, &lw))
+                    continue;
+                int result = rge_apply_pcal_fiducial_cut(
+                        fiducial, pcal_sector, lv, lw
+                );
+                if (result == 1) continue;
+                if (result == 2) return fail();
+            }
+
+            photons.push_back(photon);
+            photons_E.push_back(energy);
+        }
+
+        // Pair photons, using M^2 = 2 (E1 E2 - p1.p2) to reject pairs outside
+        //     the mass window before computing anything else.
+        for (luint i = 0; i < photons.size(); ++i) {
+            for (luint j = i+1; j < photons.size(); ++j) {
+                double mass2 = 2 * (
+                        photons_E[i]*photons_E[j] -
+                        photons[i].px*photons[j].px -
+                        photons[i].py*photons[j].py -
+                        photons[i].pz*photons[j].pz
+                );
+                if (mass2 > PI0_MAXMASS*PI0_MAXMASS) continue;
+
+                Float_t arr[RGE_PI0VARS_SIZE];
+                if (rge_fill_pi0_arr(
+                        arr, photons[i], photons[j], part_trigger, run_no, evn,
+                        energy_beam
+                )) return fail();
+
+                pi0_out->Fill(arr);
+                ++pi0_counter;
+            }
+        }
     }
 
-    // Print number of particles found to detect errors early.
-    printf("e-  found: %d\n",   trigger_counter);
-    printf("pi+ found: %d\n",   pionp_counter);
-    printf("pi- found: %d\n\n", pionm_counter);
+    // Record last event.
+    if (nslow >= 0 && task->last_event > task->first_event) {
+        record_latency(task->event_offset + task->last_event - 1);
+    }
+    if (RGE_TRACEFLUSH(&tracer)) return fail();
 
-    // Create output file.
+    // Write to output file.
+    file_out->cd();
+    auto write_start = std::chrono::steady_clock::now();
+    tree_out->Write();
+    kin_out->Write();
+    if (pi0) pi0_out->Write();
+    task->write_time = elapsed(write_start);
+
+    // Write metadata.
+    std::set<int> runs = {run_no};
+    rge_write_runlist(file_out, &runs);
+    rge_write_sf_params(file_out, run_no, sampling_fraction_params);
+
+    const char *cutflow_labels[4] = {"events", "e-", "pi+", "pi-"};
+    luint cutflow_counts[4] = {
+            static_cast<luint>(task->last_event - task->first_event),
+            static_cast<luint>(trigger_counter),
+            static_cast<luint>(pionp_counter), static_cast<luint>(pionm_counter)
+    };
+    rge_write_cutflow(file_out, 4, cutflow_labels, cutflow_counts);
+    if (dis_skim) rge_write_dis_skim(file_out);
+
+    // Clean up after ourselves.
+    file_in ->Close();
+    file_out->Close();
+
+    task->counters[0] = trigger_counter;
+    task->counters[1] = pionp_counter;
+    task->counters[2] = pionm_counter;
+    task->counters[3] = pi0_counter;
+    return 0;
+}
+
+/**
+ * Recompute the kinematics friend tree of an ntuples file from the primary
+ *     variables in its data tree, replacing the previous one. Only the
+ *     branches needed to rebuild each particle are read. The trigger electron
+ *     is the first entry of each event, and the beam energy is taken from the
+ *     run number of each entry, so files merged from several runs are handled.
+ *     The new tree is filled under a temporary name, and the previous one is
+ *     only replaced once it is complete, so it survives any error. The DIS
+ *     skim record is only kept if every trigger electron still passes the DIS
+ *     cuts with the new kinematics.
+ *
+ * @param filename : ntuples file, written by make_ntuples.
+ * @return         : error code. 0 if successful, 1 otherwise.
+ */
+static int recompute_kinematics(char *filename) {
+    TFile *f = TFile::Open(filename, "UPDATE");
+    if (!f || f->IsZombie()) {
+        rge_errno = RGEERR_BADINPUTFILE;
+        return 1;
+    }
+    TTree *data = f->Get<TTree>(RGE_TREENAMEDATA);
+    if (data == NULL) {
+        f->Close();
+        rge_errno = RGEERR_BADROOTFILE;
+        return 1;
+    }
+    if (data->GetBranch(RGE_VARS[RGE_Q2.addr]) != NULL) {
+        f->Close();
+        rge_errno = RGEERR_UNSPLITNTUPLES;
+        return 1;
+    }
+
+    // Associate the branches needed by rge_ntuples_particle_init().
+    const int read_addrs[] = {
+            RGE_RUNNO.addr, RGE_EVENTNO.addr, RGE_PID.addr, RGE_CHARGE.addr,
+            RGE_STATUS.addr, RGE_MASS.addr, RGE_VX.addr, RGE_VY.addr,
+            RGE_VZ.addr, RGE_PX.addr, RGE_PY.addr, RGE_PZ.addr, RGE_BETA.addr
+    };
+    Float_t arr[RGE_VARS_SIZE];
+    std::vector<TBranch *> branches;
+    for (int addr : read_addrs) {
+        TBranch *b = data->GetBranch(RGE_VARS[addr]);
+        if (b == NULL) {
+            f->Close();
+            rge_errno = RGEERR_BADROOTFILE;
+            return 1;
+        }
+        data->SetBranchAddress(RGE_VARS[addr], &arr[addr]);
+        branches.push_back(b);
+    }
+    Long64_t evn64 = 0;
+    TBranch *b_evn64 = data->GetBranch(RGE_EVENTNO64);
+    if (b_evn64 != NULL) {
+        data->SetBranchAddress(RGE_EVENTNO64, &evn64);
+        branches.push_back(b_evn64);
+    }
+
+    // Fill new kinematics tree under a temporary name. Its header is never
+    //     autosaved, so nothing but its baskets reaches the file until the
+    //     previous tree is replaced.
+    f->cd();
+    TNtuple *kin = new TNtuple(
+            RGE_TREENAMEKIN "_tmp", RGE_TREENAMEKIN,
+            join_vars(RGE_KINVARS, RGE_KINVARS_SIZE)
+    );
+    kin->SetAutoSave(0);
+
+    lint nentries = data->GetEntries();
+    printf(
+            "Recomputing kinematics of %ld entries in %s.\n", nentries,
+            filename
+    );
+    rge_pbar_set_nentries(nentries);
+
+    rge_particle trigger;
+    int prev_run_no = -1;
+    lint prev_evn   = -1;
+    double beam_E   = 0.;
+    lint ndis_fail  = 0;
+    for (lint entry = 0; entry < nentries; ++entry) {
+        rge_pbar_update(entry);
+        for (TBranch *b : branches) b->GetEntry(entry);
+
+        int run_no = static_cast<int>(arr[RGE_RUNNO.addr]);
+        lint evn   = b_evn64 != NULL ?
+                static_cast<lint>(evn64) :
+                static_cast<lint>(arr[RGE_EVENTNO.addr] + .5);
+        bool is_first = run_no != prev_run_no || evn != prev_evn;
+        if (run_no != prev_run_no && rge_get_beam_energy(run_no, &beam_E)) {
+            f->Close();
+            return 1;
+        }
+        prev_run_no = run_no;
+        prev_evn    = evn;
+
+        // Other electrons in the event get DIS kinematics too, as in
+        //     rge_set_pid().
+        bool is_trigger = is_first || (
+                static_cast<int>(arr[RGE_PID.addr]) == 11 &&
+                arr[RGE_STATUS.addr] < 0
+        );
+        rge_particle p = rge_ntuples_particle_init(arr, is_trigger);
+        if (is_first) trigger = p;
+        if (rge_fill_kinematics_arr(arr, p, trigger, beam_E)) {
+            f->Close();
+            return 1;
+        }
+        if (is_first && (
+                arr[RGE_Q2.addr] < RGE_Q2CUT ||
+                arr[RGE_W2.addr] < RGE_W2CUT ||
+                arr[RGE_YB.addr] > RGE_YBCUT
+        )) ++ndis_fail;
+
+        Float_t kin_arr[RGE_KINVARS_SIZE];
+        for (int var_i = 0; var_i < RGE_KINVARS_SIZE; ++var_i) {
+            kin_arr[var_i] = arr[RGE_KINVARS[var_i]];
+        }
+        kin->Fill(kin_arr);
+    }
+
+    // Replace previous kinematics tree.
+    f->Delete(RGE_TREENAMEKIN ";*");
+    kin->SetName(RGE_TREENAMEKIN);
+    kin->Write();
+
+    // Check that the DIS skim record still holds.
+    if (rge_read_dis_skim(f)) {
+        if (ndis_fail == 0) {
+            printf(
+                    "All trigger electrons pass the DIS cuts, skim record "
+                    "kept.\n"
+            );
+        }
+        else {
+            rge_remove_dis_skim(f);
+            printf(
+                    "%ld trigger electrons fail the DIS cuts, skim record "
+                    "removed.\n", ndis_fail
+            );
+        }
+    }
+    f->Close();
+
+    return 0;
+}
+
+/**
+ * run() function of the program in recompute mode (-R). Check USAGE_MESSAGE
+ *     for details. Input files are split across ranks.
+ */
+static int run_recompute(char **filenames_in, int nfiles) {
+    for (
+            int file_i = rge_dist_rank(); file_i < nfiles;
+            file_i += rge_dist_size()
+    ) {
+        if (recompute_kinematics(filenames_in[file_i])) return 1;
+    }
+
+    rge_errno = RGEERR_NOERR;
+    return 0;
+}
+
+/** run() function of the program. Check USAGE_MESSAGE for details. */
+static int run(
+        char **filenames_in, int nfiles, char *work_dir, char *data_dir,
+        bool debug, lint fmt_nlayers, bool fmt_cut, bool fid_cut,
+        bool dis_skim, bool pi0, bool lazy, lint n_events, int run_no,
+        double energy_beam, lint nthreads, lint imt_nthreads, lint nslow,
+        lint trace_every, std::set<lint> *trace_events
+) {
+    // Get sampling fraction.
+    char sampling_fraction_file[PATH_MAX];
+    if (run_no / 1000 != 999) {
+        // Input file is data.
+        sprintf(
+                sampling_fraction_file, "%s/sf_params_%06d.txt",
+                data_dir, run_no
+        );
+    }
+    else {
+        // Input file is simulation.
+        sprintf(sampling_fraction_file, "%s/sf_params_mc.txt", data_dir);
+    }
+    double sampling_fraction_params[RGE_NSECTORS][RGE_NSFPARAMS][2];
+    if (access(sampling_fraction_file, F_OK) != 0) {
+        // No sampling fraction file for this run, we need to extract it. Only
+        //     rank 0 does this, while the other ranks wait for the file.
+        printf(
+                "No sampling fraction data found for run %d. Running "
+                "extract_sf().\n", run_no
+        );
+        if (rge_dist_rank() == 0 && rge_extract_sf(
+                filenames_in[0], work_dir, data_dir, n_events, run_no
+        )) {
+            return 1;
+        }
+        rge_dist_barrier();
+        printf("Done!\n\n");
+        rge_errno = RGEERR_UNDEFINED;
+    }
+    if (rge_get_sf_params(sampling_fraction_file, sampling_fraction_params)) {
+        return 1;
+    }
+
+    // Count events in each partition.
+    lint nentries[static_cast<luint>(nfiles)];
+    lint nentries_total = 0;
+    for (int file_i = 0; file_i < nfiles; ++file_i) {
+        TFile *file_in = TFile::Open(filenames_in[file_i], "READ");
+        if (!file_in || file_in->IsZombie()) {
+            rge_errno = RGEERR_BADINPUTFILE;
+            return 1;
+        }
+
+        // If fmt_nlayers != 0, check that FMT::Tracks bank exists.
+        if (
+                fmt_nlayers != 0 &&
+                file_in->GetListOfKeys()->Contains(RGE_FMTTRACKS)
+        ) {
+            rge_errno = RGEERR_NOFMTBANK;
+            return 1;
+        }
+
+        TTree *tree_in = file_in->Get<TTree>(RGE_TREENAMEDATA);
+        if (tree_in == NULL) {
+            rge_errno = RGEERR_BADROOTFILE;
+            return 1;
+        }
+        nentries[file_i] = tree_in->GetEntries();
+        nentries_total  += nentries[file_i];
+        file_in->Close();
+    }
+
+    // Change n_events to number of entries if it is equal to -1 or invalid.
+    if (n_events == -1 || n_events > nentries_total) {
+        n_events = nentries_total;
+    }
+
+    // Precompute fiducial cut maps.
+    rge_fiducial fiducial;
+    if (fid_cut) rge_fiducial_init(&fiducial);
+
+    // Open trace file. Each rank writes its own.
+    rge_tracelog tracelog;
+    bool trace = trace_every > 0 || trace_events->size() > 0;
+    if (trace) {
+        char filename_trace[PATH_MAX];
+        if (rge_dist_size() == 1) {
+            sprintf(filename_trace, "%s/trace_%06d.bin", work_dir, run_no);
+        }
+        else {
+            sprintf(
+                    filename_trace, "%s/trace_%06d.rank%03d.bin", work_dir,
+                    run_no, rge_dist_rank()
+            );
+        }
+        if (rge_tracelog_open(
+                &tracelog, filename_trace, trace_every, trace_events
+        )) return 1;
+        printf("Writing debug trace to %s.\n", filename_trace);
+    }
+
+    // Iterate through input files. Each TTree entry is one event.
+    printf("Processing %ld events from %d file(s).\n", n_events, nfiles);
+
+    // Get shard of events processed by this rank.
+    lint first_event, last_event;
+    rge_dist_shard(n_events, &first_event, &last_event);
+    if (rge_dist_size() > 1) {
+        printf("Distributed across %d processes.\n", rge_dist_size());
+    }
+
+    // Create output filenames.
     char filename_out[PATH_MAX];
     if (fmt_nlayers == 0) {
         sprintf(filename_out, "%s/ntuples_dc_%06d.root", work_dir, run_no);
@@ -538,15 +1298,229 @@ static int run(
                 fmt_nlayers, run_no
         );
     }
-    TFile *file_out = TFile::Open(filename_out, "RECREATE");
+    // Each rank writes its own partial file, merged at rank 0 at the end.
+    char filename_part[PATH_MAX];
+    rge_dist_part_filename(filename_out, filename_part);
+
+    // Number of slowest events kept by each latency record.
+    luint nkeep = nslow > 0 ? static_cast<luint>(nslow) : 0;
+
+    // Split shard into tasks. Tasks never span more than one partition, and
+    //     with more than one thread, there are a few tasks per thread to
+    //     balance partitions of different sizes.
+    lint shard_size = last_event - first_event;
+    lint task_size  = shard_size;
+    if (nthreads > 1) {
+        task_size = (shard_size + TASKS_PER_THREAD*nthreads - 1) /
+                (TASKS_PER_THREAD*nthreads);
+    }
+    if (task_size < 1) task_size = 1;
+
+    std::vector<ntuples_task> tasks;
+    lint offset = 0;
+    for (int file_i = 0; file_i < nfiles; ++file_i) {
+        lint start = first_event > offset ? first_event : offset;
+        lint end   = offset + nentries[file_i];
+        if (end > last_event) end = last_event;
+        for (lint event = start; event < end; event += task_size) {
+            ntuples_task task;
+            task.file_i       = file_i;
+            task.filename_in  = filenames_in[file_i];
+            task.first_event  = event - offset;
+            task.last_event   = (event + task_size < end ?
+                    event + task_size : end) - offset;
+            task.event_offset = offset;
+            task.write_time   = 0.;
+            task.latency      = rge_latency_init(nkeep);
+            task.nlazy        = 0;
+            task.lazy_bytes   = 0.;
+            tasks.push_back(task);
+        }
+        offset += nentries[file_i];
+    }
+    // Empty shards still write an output file with their metadata.
+    if (tasks.size() == 0) {
+        ntuples_task task;
+        task.file_i       = 0;
+        task.filename_in  = filenames_in[0];
+        task.first_event  = 0;
+        task.last_event   = 0;
+        task.event_offset = 0;
+        task.write_time   = 0.;
+        task.latency      = rge_latency_init(nkeep);
+        task.nlazy        = 0;
+        task.lazy_bytes   = 0.;
+        tasks.push_back(task);
+    }
 
-    // Write to output file.
-    file_out->cd();
-    tree_out->Write();
+    // Stage input files through local scratch if RGE_SCRATCH is set. Tasks
+    //     take files in order, so at most one file per thread is in use.
+    lint nuses[static_cast<luint>(nfiles)];
+    for (int file_i = 0; file_i < nfiles; ++file_i) nuses[file_i] = 0;
+    for (luint task_i = 0; task_i < tasks.size(); ++task_i) {
+        ++nuses[tasks[task_i].file_i];
+    }
+    rge_stager stager;
+    rge_stager_init(
+            &stager, filenames_in, nfiles, nuses,
+            static_cast<luint>(nthreads) + 1
+    );
 
-    // Clean up after ourselves.
-    file_in ->Close();
-    file_out->Close();
+    // The partial file is written in scratch and moved to its final path once
+    //     complete. A single task writes it directly. Task files are only
+    //     read back to merge them, so they are kept in scratch.
+    char filename_local[PATH_MAX];
+    rge_stager_output(&stager, filename_part, filename_local);
+    for (luint task_i = 0; task_i < tasks.size(); ++task_i) {
+        if (tasks.size() == 1) {
+            sprintf(tasks[task_i].filename_out, "%s", filename_local);
+        }
+        else {
+            char filename_task[PATH_MAX];
+            sprintf(
+                    filename_task, "%s.task%04lu.root", filename_part, task_i
+            );
+            rge_stager_output(
+                    &stager, filename_task, tasks[task_i].filename_out
+            );
+        }
+    }
+
+    // Prepare fancy progress bar.
+    rge_pbar_reset();
+    rge_pbar_set_nentries(shard_size);
+
+    // Process tasks, with each worker thread taking the next available task.
+    if (nthreads > 1) ROOT::EnableThreadSafety();
+    if (imt_nthreads > 0) {
+        ROOT::EnableImplicitMT(static_cast<uint>(imt_nthreads));
+    }
+    lint nworkers = static_cast<lint>(tasks.size()) < nthreads ?
+            static_cast<lint>(tasks.size()) : nthreads;
+    std::atomic<luint> next_task(0);
+    std::atomic<lint>  nprocessed(0);
+    std::atomic<lint>  nfinished(0);
+    std::atomic<bool>  failed(false);
+    std::vector<std::thread> workers;
+    auto process_start = std::chrono::steady_clock::now();
+    for (lint worker_i = 0; worker_i < nworkers; ++worker_i) {
+        workers.emplace_back([&] {
+            for (
+                    luint task_i = next_task++;
+                    task_i < tasks.size() && !failed; task_i = next_task++
+            ) {
+                ntuples_task *task = &(tasks[task_i]);
+                task->filename_in = rge_stager_acquire(&stager, task->file_i);
+                if (process_task(
+                        task, fmt_nlayers, fmt_cut, fid_cut,
+                        dis_skim, pi0, lazy, nslow, trace ? &tracelog : NULL,
+                        &fiducial,
+                        sampling_fraction_params, run_no, energy_beam,
+                        &nprocessed
+                )) failed = true;
+                rge_stager_release(&stager, task->file_i);
+            }
+            ++nfinished;
+        });
+    }
+
+    // Update progress bar from the main thread while workers run.
+    lint shown = 0;
+    while (nfinished < nworkers) {
+        if (!debug) for (; shown < nprocessed; ++shown) rge_pbar_update(shown);
+        usleep(PBAR_PERIOD);
+    }
+    for (std::thread &worker : workers) worker.join();
+    double process_time = elapsed(process_start);
+    if (!debug) for (; shown < nprocessed; ++shown) rge_pbar_update(shown);
+    if (failed) {
+        rge_stager_close(&stager);
+        return 1;
+    }
+
+    // Print number of particles found to detect errors early.
+    lint counters[4] = {0, 0, 0, 0};
+    for (luint task_i = 0; task_i < tasks.size(); ++task_i) {
+        for (int ci = 0; ci < 4; ++ci) {
+            counters[ci] += tasks[task_i].counters[ci];
+        }
+    }
+    rge_dist_reduce_sum(counters, 4);
+    printf("e-  found: %ld\n", counters[0]);
+    printf("pi+ found: %ld\n", counters[1]);
+    printf("pi- found: %ld\n", counters[2]);
+    if (pi0) printf("pi0 candidates found: %ld\n", counters[3]);
+    printf("\n");
+
+    // Report the wall time of processing, which includes filling and
+    //     compressing the ntuples, so that runs with and without -T can be
+    //     compared. Final writes are timed in each thread, and their sum is
+    //     printed separately.
+    double write_time = 0.;
+    for (luint task_i = 0; task_i < tasks.size(); ++task_i) {
+        write_time += tasks[task_i].write_time;
+    }
+    printf(
+            "Wall time processing and writing ntuples: %.3f s (implicit MT "
+            "%s).\nFinal ntuple writes, summed over %ld thread(s): %.3f s.\n\n",
+            process_time,
+            imt_nthreads > 0 ? Form("on, %ld threads", imt_nthreads) : "off",
+            nworkers, write_time
+    );
+
+    // Report detector banks skipped by lazy loading.
+    if (lazy) {
+        lint nlazy        = 0;
+        double lazy_bytes = 0.;
+        for (luint task_i = 0; task_i < tasks.size(); ++task_i) {
+            nlazy      += tasks[task_i].nlazy;
+            lazy_bytes += tasks[task_i].lazy_bytes;
+        }
+        rge_dist_reduce_sum(&nlazy, 1);
+        rge_dist_reduce_sum(&lazy_bytes, 1);
+        printf(
+                "Lazy loading skipped the detector banks of %ld events, "
+                "about %.1f MB of compressed data not read.\n\n", nlazy,
+                lazy_bytes / 1e6
+        );
+    }
+
+    // Report per-event processing times.
+    if (nslow >= 0) {
+        rge_latency latency = rge_latency_init(nkeep);
+        for (luint task_i = 0; task_i < tasks.size(); ++task_i) {
+            rge_latency_merge(&latency, &(tasks[task_i].latency));
+        }
+        rge_latency_reduce(&latency);
+        rge_latency_print(&latency, LATENCY_BANKS);
+    }
+    if (trace) rge_tracelog_close(&tracelog);
+
+    // Merge task files in order, so that events keep their order.
+    if (tasks.size() > 1) {
+        std::vector<char *> task_filenames;
+        for (luint task_i = 0; task_i < tasks.size(); ++task_i) {
+            task_filenames.push_back(tasks[task_i].filename_out);
+        }
+        int err = rge_merge_files(
+                task_filenames.data(), static_cast<int>(tasks.size()),
+                filename_local, true
+        );
+        for (luint task_i = 0; task_i < tasks.size(); ++task_i) {
+            unlink(tasks[task_i].filename_out);
+        }
+        if (err) {
+            rge_stager_close(&stager);
+            return 1;
+        }
+    }
+
+    // Move the partial file out of scratch before gathering partial files.
+    rge_stager_commit(&stager, filename_local, filename_part);
+    if (rge_stager_close(&stager)) return 1;
+
+    // Merge partial files.
+    if (rge_dist_gather_files(filename_out)) return 1;
 
     rge_errno = RGEERR_NOERR;
     return 0;
@@ -554,13 +1528,17 @@ static int run(
 
 /** Handle arguments for make_ntuples using optarg. */
 static int handle_args(
-        int argc, char **argv, char **filename_in, char **work_dir,
-        char **data_dir, bool *debug, lint *fmt_nlayers, bool *fmt_cut,
-        lint *n_events, int *run_no, double *energy_beam
+        int argc, char **argv, char **filenames_in, int *nfiles,
+        char **work_dir, char **data_dir, bool *debug, lint *fmt_nlayers,
+        bool *fmt_cut, bool *fid_cut, bool *dis_skim, bool *pi0, bool *lazy,
+        bool *recompute, lint *n_events, lint *nthreads, lint *imt_nthreads,
+        lint *nslow, lint *trace_every, std::set<lint> *trace_events,
+        int *run_no, double *energy_beam
 ) {
     // Handle arguments.
     int opt;
-    while ((opt = getopt(argc, argv, "-hDf:cn:w:d:")) != -1) {
+    lint trace_evn;
+    while ((opt = getopt(argc, argv, "-hDf:cgspLRn:j:T:l:t:e:w:d:")) != -1) {
         switch (opt) {
             case 'h':
                 rge_errno = RGEERR_USAGE;
@@ -574,9 +1552,44 @@ static int handle_args(
             case 'c':
                 *fmt_cut = true;
                 break;
+            case 'g':
+                *fid_cut = true;
+                break;
+            case 's':
+                *dis_skim = true;
+                break;
+            case 'p':
+                *pi0 = true;
+                break;
+            case 'L':
+                *lazy = true;
+                break;
+            case 'R':
+                *recompute = true;
+                break;
             case 'n':
                 if (rge_process_nentries(n_events, optarg)) return 1;
                 break;
+            case 'j':
+                if (rge_process_nthreads(nthreads, optarg)) return 1;
+                break;
+            case 'T':
+                if (rge_process_nthreads(imt_nthreads, optarg)) return 1;
+                break;
+            case 'l':
+                if (rge_process_nslow(nslow, optarg)) return 1;
+                break;
+            case 't':
+                if (rge_process_evn(trace_every, optarg)) return 1;
+                if (*trace_every == 0) {
+                    rge_errno = RGEERR_INVALIDTRACEOPT;
+                    return 1;
+                }
+                break;
+            case 'e':
+                if (rge_process_evn(&trace_evn, optarg)) return 1;
+                trace_events->insert(trace_evn);
+                break;
             case 'w':
                 *work_dir = static_cast<char *>(malloc(strlen(optarg) + 1));
                 strcpy(*work_dir, optarg);
@@ -586,8 +1599,7 @@ static int handle_args(
                 strcpy(*data_dir, optarg);
                 break;
             case 1:
-                *filename_in = static_cast<char *>(malloc(strlen(optarg) + 1));
-                strcpy(*filename_in, optarg);
+                rge_grab_string(optarg, &(filenames_in[(*nfiles)++]));
                 break;
             default:
                 rge_errno = RGEERR_BADOPTARGS;
@@ -595,6 +1607,14 @@ static int handle_args(
         }
     }
 
+#ifndef RGE_TRACING
+    // Trace points are compiled out, so tracing can't be done.
+    if (*trace_every > 0 || trace_events->size() > 0) {
+        rge_errno = RGEERR_NOTRACING;
+        return 1;
+    }
+#endif
+
     // Define workdir if undefined.
     char tmpfilename[PATH_MAX];
     sprintf(tmpfilename, "%s", argv[0]);
@@ -609,47 +1629,89 @@ static int handle_args(
         sprintf(*data_dir, "%s/../data", dirname(tmpfilename));
     }
 
-    // Check positional argument.
-    if (*filename_in == NULL) {
+    // Check positional arguments. All of them must be from the same run,
+    //     unless recomputing kinematics.
+    if (*nfiles == 0) {
         rge_errno = RGEERR_NOINPUTFILE;
         return 1;
     }
-    if (rge_handle_root_filename(*filename_in, run_no, energy_beam)) return 1;
+    if (*recompute) {
+        for (int file_i = 0; file_i < *nfiles; ++file_i) {
+            if (rge_check_root_filename(filenames_in[file_i])) return 1;
+        }
+        return 0;
+    }
+    if (rge_handle_root_filename(filenames_in[0], run_no, energy_beam)) {
+        return 1;
+    }
+    for (int file_i = 1; file_i < *nfiles; ++file_i) {
+        int file_run_no;
+        if (rge_handle_root_filename(filenames_in[file_i], &file_run_no)) {
+            return 1;
+        }
+        if (file_run_no != *run_no) {
+            rge_errno = RGEERR_RUNMISMATCH;
+            return 1;
+        }
+    }
 
     return 0;
 }
 
 /** Entry point of the program. */
 int main(int argc, char **argv) {
+    rge_dist_init(&argc, &argv);
+
     // Handle arguments.
-    char *filename_in  = NULL;
+    char **filenames_in = static_cast<char **>(
+            malloc(static_cast<luint>(argc) * sizeof(char *))
+    );
+    int nfiles         = 0;
     char *work_dir     = NULL;
     char *data_dir     = NULL;
     bool debug         = false;
     lint fmt_nlayers   = 0;
     bool fmt_cut       = false;
+    bool fid_cut       = false;
+    bool dis_skim      = false;
+    bool pi0           = false;
+    bool lazy          = false;
+    bool recompute     = false;
     lint n_events      = -1;
+    lint nthreads      = 1;
+    lint imt_nthreads  = 0;
+    lint nslow         = -1;
+    lint trace_every   = 0;
+    std::set<lint> trace_events;
     int run_no         = -1;
     double energy_beam = -1;
 
     int err = handle_args(
-            argc, argv, &filename_in, &work_dir, &data_dir, &debug,
-            &fmt_nlayers, &fmt_cut, &n_events, &run_no, &energy_beam
+            argc, argv, filenames_in, &nfiles, &work_dir, &data_dir, &debug,
+            &fmt_nlayers, &fmt_cut, &fid_cut, &dis_skim, &pi0, &lazy,
+            &recompute, &n_events, &nthreads, &imt_nthreads, &nslow,
+            &trace_every, &trace_events, &run_no, &energy_beam
     );
 
     // Run.
-    if (rge_errno == RGEERR_UNDEFINED && err == 0) {
+    if (rge_errno == RGEERR_UNDEFINED && err == 0 && recompute) {
+        run_recompute(filenames_in, nfiles);
+    }
+    else if (rge_errno == RGEERR_UNDEFINED && err == 0) {
         run(
-                filename_in, work_dir, data_dir, debug, fmt_nlayers, fmt_cut,
-                n_events, run_no, energy_beam
+                filenames_in, nfiles, work_dir, data_dir, debug, fmt_nlayers,
+                fmt_cut, fid_cut, dis_skim, pi0, lazy, n_events, run_no,
+                energy_beam, nthreads, imt_nthreads, nslow, trace_every,
+                &trace_events
         );
     }
 
     // Free up memory.
-    if (filename_in != NULL) free(filename_in);
+    for (int file_i = 0; file_i < nfiles; ++file_i) free(filenames_in[file_i]);
+    free(filenames_in);
     if (work_dir    != NULL) free(work_dir);
     if (data_dir    != NULL) free(data_dir);
 
     // Return errcode.
-    return rge_print_usage(USAGE_MESSAGE);
+    return rge_dist_finalize(rge_print_usage(USAGE_MESSAGE));
 }
@@ -0,0 +1,197 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+// C.
+#include <limits.h>
+#include <unistd.h>
+
+// C++.
+#include <thread>
+#include <vector>
+
+// ROOT.
+#include <TFile.h>
+#include <TROOT.h>
+
+// rge-analysis.
+#include "../lib/rge_err_handler.h"
+#include "../lib/rge_filename_handler.h"
+#include "../lib/rge_io_handler.h"
+#include "../lib/rge_metadata.h"
+
+static const char *USAGE_MESSAGE =
+"Usage: merge_files [-hj:o:] infile1 [infile2 ...]\n"
+" * -h          : show this message and exit.\n"
+" * -j nthreads : number of threads used to merge. Default is 1.\n"
+" * -o outfile  : output file.\n"
+" * infiles     : input ROOT files, all produced by either hipo2root or\n"
+"                 make_ntuples.\n\n"
+"    Merge a list of banks or ntuples files into one file. Trees are\n"
+"    concatenated by copying their compressed baskets, histograms are added,\n"
+"    and metadata (run lists, sampling fraction parameters, and cutflows) is\n"
+"    merged.\n";
+
+/** run() function of the program. Check USAGE_MESSAGE for details. */
+static int run(
+        char **in_filenames, int nfiles, char *out_filename, lint nthreads
+) {
+    if (!access(out_filename, F_OK)) {
+        rge_errno = RGEERR_OUTFILEEXISTS;
+        return 1;
+    }
+
+    // Split input files into contiguous chunks, one per thread. Keeping them
+    //     contiguous preserves the order of entries in the output trees.
+    int nchunks = static_cast<int>(nthreads) < nfiles ?
+            static_cast<int>(nthreads) : nfiles;
+    printf("Merging %d files using %d thread(s).\n", nfiles, nchunks);
+
+    if (nchunks == 1) {
+        if (rge_merge_files(in_filenames, nfiles, out_filename, false)) {
+            return 1;
+        }
+    }
+    else {
+        ROOT::EnableThreadSafety();
+
+        // Merge each chunk into a temporary file.
+        char *tmp_filenames[static_cast<luint>(nchunks)];
+        int chunk_err[static_cast<luint>(nchunks)];
+        std::vector<std::thread> workers;
+        for (int chunk_i = 0; chunk_i < nchunks; ++chunk_i) {
+            int start = (nfiles *  chunk_i)    / nchunks;
+            int end   = (nfiles * (chunk_i+1)) / nchunks;
+
+            tmp_filenames[chunk_i] = static_cast<char *>(malloc(PATH_MAX));
+            sprintf(tmp_filenames[chunk_i], "%s.tmp%02d.root", out_filename,
+                    chunk_i);
+
+            workers.emplace_back([&, chunk_i, start, end] {
+                chunk_err[chunk_i] = rge_merge_files(
+                        &(in_filenames[start]), end - start,
+                        tmp_filenames[chunk_i], false
+                );
+            });
+        }
+        for (std::thread &worker : workers) worker.join();
+
+        // Merge temporary files.
+        int err = 0;
+        for (int chunk_i = 0; chunk_i < nchunks; ++chunk_i) {
+            err |= chunk_err[chunk_i];
+        }
+        if (!err) {
+            err = rge_merge_files(tmp_filenames, nchunks, out_filename, false);
+        }
+
+        // Clean up temporary files.
+        for (int chunk_i = 0; chunk_i < nchunks; ++chunk_i) {
+            unlink(tmp_filenames[chunk_i]);
+            free(tmp_filenames[chunk_i]);
+        }
+
+        if (err) {
+            rge_errno = RGEERR_MERGEFAILED;
+            return 1;
+        }
+    }
+
+    // Merge metadata.
+    TFile *f_out = TFile::Open(out_filename, "UPDATE");
+    if (!f_out || f_out->IsZombie()) {
+        rge_errno = RGEERR_OUTPUTROOTFAILED;
+        return 1;
+    }
+    if (rge_merge_metadata(f_out, nfiles, in_filenames)) return 1;
+    f_out->Close();
+
+    printf("Done! Merged file written to %s.\n", out_filename);
+
+    rge_errno = RGEERR_NOERR;
+    return 0;
+}
+
+/** Handle arguments for merge_files using optarg. */
+static int handle_args(
+        int argc, char **argv, char **in_filenames, int *nfiles,
+        char **out_filename, lint *nthreads
+) {
+    // Handle arguments.
+    int opt;
+    while ((opt = getopt(argc, argv, "-hj:o:")) != -1) {
+        switch (opt) {
+            case 'h':
+                rge_errno = RGEERR_USAGE;
+                return 1;
+            case 'j':
+                if (rge_process_nthreads(nthreads, optarg)) return 1;
+                break;
+            case 'o':
+                rge_grab_string(optarg, out_filename);
+                break;
+            case 1:
+                rge_grab_string(optarg, &(in_filenames[(*nfiles)++]));
+                break;
+            default:
+                rge_errno = RGEERR_BADOPTARGS;
+                return 1;
+        }
+    }
+
+    // Check output file.
+    if (*out_filename == NULL) {
+        rge_errno = RGEERR_NOOUTPUTFILE;
+        return 1;
+    }
+
+    // Check positional arguments.
+    if (*nfiles == 0) {
+        rge_errno = RGEERR_NOINPUTFILE;
+        return 1;
+    }
+    for (int file_i = 0; file_i < *nfiles; ++file_i) {
+        if (rge_check_root_filename(in_filenames[file_i])) return 1;
+    }
+
+    return 0;
+}
+
+/** Entry point of the program. */
+int main(int argc, char **argv) {
+    // Handle arguments.
+    char **in_filenames = static_cast<char **>(
+            malloc(static_cast<luint>(argc) * sizeof(char *))
+    );
+    int nfiles          = 0;
+    char *out_filename  = NULL;
+    lint nthreads       = 1;
+
+    int err = handle_args(
+            argc, argv, in_filenames, &nfiles, &out_filename, &nthreads
+    );
+
+    // Run.
+    if (rge_errno == RGEERR_UNDEFINED && err == 0) {
+        run(in_filenames, nfiles, out_filename, nthreads);
+    }
+
+    // Free up memory.
+    for (int file_i = 0; file_i < nfiles; ++file_i) free(in_filenames[file_i]);
+    free(in_filenames);
+    if (out_filename != NULL) free(out_filename);
+
+    // Return errcode.
+    return rge_print_usage(USAGE_MESSAGE);
+}
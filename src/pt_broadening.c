@@ -0,0 +1,516 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+// C.
+#include <libgen.h>
+#include <limits.h>
+#include <math.h>
+#include <unistd.h>
+
+// C++.
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// ROOT.
+#include <TFile.h>
+#include <TNtuple.h>
+#include <TROOT.h>
+
+// rge-analysis.
+#include "../lib/rge_constants.h"
+#include "../lib/rge_err_handler.h"
+#include "../lib/rge_filename_handler.h"
+#include "../lib/rge_io_handler.h"
+#include "../lib/rge_kernels.h"
+#include "../lib/rge_math_utils.h"
+#include "../lib/rge_metadata.h"
+#include "../lib/rge_moments.h"
+#include "../lib/rge_progress.h"
+
+static const char *USAGE_MESSAGE =
+"Usage: pt_broadening [-hq:n:z:d:s:p:j:o:w:] infile\n"
+" * -h          : show this message and exit.\n"
+" * -q ...      : Q2 bins.\n"
+" * -n ...      : nu bins.\n"
+" * -z ...      : z_h bins.\n"
+" * -d lo hi    : vz range of the liquid deuterium target (cm).\n"
+" * -s lo hi    : vz range of the solid target (cm).\n"
+" * -p pid      : PID of the hadrons used. Default is 211.\n"
+" * -j nthreads : number of threads used to read the input. Default is 1.\n"
+" * -o outfile  : output file name. Default is pt_broadening_<run_no>.txt.\n"
+" * -w workdir  : location where the output file is stored. Default is\n"
+"                 root_io.\n"
+" * infile      : input file produced by make_ntuples.\n\n"
+"    Compute the mean Pt2 of hadrons for each target and each (Q2, nu, z_h)\n"
+"    bin in a single pass over the ntuples, applying all the cuts of\n"
+"    draw_plots -c, and write the Pt broadening DeltaPt2 = <Pt2>_solid -\n"
+"    <Pt2>_D2 with its statistical error to a table. Bins are given as in\n"
+"    acc_corr: the first double is the lower limit of the leftmost bin, the\n"
+"    last double the upper limit of the rightmost bin, and the ones in\n"
+"    between the separators between bins.\n";
+
+/** Targets, separated by vz. */
+#define NTARGETS 2
+#define TGT_D2    0
+#define TGT_SOLID 1
+static const char *TARGET_LIST[NTARGETS] = {"D2", "solid"};
+
+/** Binning variables. */
+#define NBINVARS 3
+static const RGE_VAR BIN_VARS[NBINVARS] = {RGE_Q2, RGE_NU, RGE_ZH};
+
+/**
+ * Number of ntuple entries per chunk. Each chunk fills its own accumulators,
+ *     and chunks are merged in order, so the output doesn't depend on the
+ *     number of threads.
+ */
+static const lint CHUNK_SIZE = 1 << 18;
+
+/** Time between progress bar updates (us). */
+static const useconds_t PBAR_PERIOD = 50000;
+
+/**
+ * Fill the accumulators of one chunk of entries. Events are assigned to the
+ *     chunk where their first entry lies, so entries before the first event
+ *     starting in [start, end) are skipped, and the last event is read past
+ *     end. The trigger electron is always the first entry of an event.
+ *
+ * @param ntuple   : ntuple to read, with its branches set to vars.
+ * @param vars     : array where the variables of each entry are read.
+ * @param evn64    : exact event number of each entry, or NULL if the ntuple
+ *                   doesn't have the RGE_EVENTNO64 branch.
+ * @param start    : first entry of the chunk.
+ * @param end      : last entry of the chunk (not included).
+ * @param nentries : number of entries in ntuple.
+ * @param pid      : PID of the hadrons used.
+ * @param skimmed  : true if the input is DIS-skimmed, so DIS cuts are skipped.
+ * @param edges    : bin edges of each binning variable.
+ * @param nedges   : number of bin edges of each binning variable.
+ * @param vz_range : vz range of each target.
+ * @param acc      : accumulators of the chunk, of size NTARGETS*ncells.
+ * @return         : error code, which is always 0 (no error).
+ */
+static int fill_chunk(
+        TNtuple *ntuple, Float_t *vars, Long64_t *evn64, lint start, lint end,
+        lint nentries, lint pid, bool skimmed, double **edges, luint *nedges,
+        double vz_range[NTARGETS][2], rge_moments *acc
+) {
+    luint ncells = 1;
+    for (int var_i = 0; var_i < NBINVARS; ++var_i) ncells *= nedges[var_i]-1;
+
+    // Start with the event of the entry before the chunk, so that its
+    //     remaining entries are skipped.
+    auto event_no = [&]() -> lint {
+        if (evn64 != NULL) return *evn64;
+        return llround(vars[RGE_EVENTNO.addr]);
+    };
+    lint evn       = -1;
+    bool valid_evn = false;
+    if (start > 0) {
+        ntuple->GetEntry(start - 1);
+        evn = event_no();
+    }
+
+    for (lint entry = start; entry < nentries; ++entry) {
+        ntuple->GetEntry(entry);
+
+        // A new event starts with its trigger electron.
+        if (event_no() != evn) {
+            if (entry >= end) break;
+            evn = event_no();
+            valid_evn =
+                    10.5 < vars[RGE_PID.addr] && vars[RGE_PID.addr] <= 11.5 &&
+                    vars[RGE_STATUS.addr] <= 0 && (skimmed ||
+                    rge_kernel_dis_cut(
+                            vars[RGE_Q2.addr], vars[RGE_W2.addr],
+                            vars[RGE_YB.addr]
+                    ));
+            continue;
+        }
+        if (!valid_evn) continue;
+
+        // Select hadrons passing general and geometry cuts.
+        if (lround(vars[RGE_PID.addr]) != pid) continue;
+        if (!rge_kernel_general_cut(
+                vars[RGE_PID.addr], vars[RGE_CHI2.addr], vars[RGE_NDF.addr]
+        )) continue;
+        if (!rge_kernel_geometry_cut(
+                vars[RGE_VX.addr], vars[RGE_VY.addr], vars[RGE_VZ.addr]
+        )) continue;
+        if (vars[RGE_Q2.addr] == 0 || vars[RGE_NU.addr] == 0) continue;
+        if (vars[RGE_ZH.addr] == 0 || vars[RGE_PT2.addr] == 0) continue;
+
+        // Find target.
+        int tgt = -1;
+        for (int tgt_i = 0; tgt_i < NTARGETS; ++tgt_i) {
+            if (
+                    vz_range[tgt_i][0] <= vars[RGE_VZ.addr] &&
+                    vars[RGE_VZ.addr]  <  vz_range[tgt_i][1]
+            ) {
+                tgt = tgt_i;
+            }
+        }
+        if (tgt == -1) continue;
+
+        // Find cell, last binning variable running fastest.
+        lint cell = 0;
+        for (int var_i = 0; var_i < NBINVARS; ++var_i) {
+            int pos = rge_find_pos(
+                    vars[BIN_VARS[var_i].addr], edges[var_i],
+                    static_cast<int>(nedges[var_i]-1)
+            );
+            if (pos == -1) {
+                cell = -1;
+                break;
+            }
+            cell = cell * static_cast<lint>(nedges[var_i]-1) + pos;
+        }
+        if (cell == -1) continue;
+
+        rge_moments_add(
+                &(acc[static_cast<luint>(tgt)*ncells +
+                        static_cast<luint>(cell)]),
+                vars[RGE_PT2.addr]
+        );
+    }
+
+    return 0;
+}
+
+/** run() function of the program. Check USAGE_MESSAGE for details. */
+static int run(
+        char *in_filename, char *out_filename, lint pid, double **edges,
+        luint *nedges, double vz_range[NTARGETS][2], lint nthreads
+) {
+    // Get number of entries, and check if the file was DIS-skimmed.
+    TFile *f_in = TFile::Open(in_filename, "READ");
+    if (!f_in || f_in->IsZombie()) {
+        rge_errno = RGEERR_BADINPUTFILE;
+        return 1;
+    }
+    TNtuple *ntuple = f_in->Get<TNtuple>(RGE_TREENAMEDATA);
+    if (ntuple == NULL) {
+        rge_errno = RGEERR_BADROOTFILE;
+        return 1;
+    }
+    if (rge_attach_kinematics(f_in, ntuple)) return 1;
+    lint nentries = ntuple->GetEntries();
+    bool skimmed  = rge_read_dis_skim(f_in);
+    f_in->Close();
+    if (skimmed) printf("Input file is DIS-skimmed, skipping DIS cuts.\n");
+
+    luint ncells = 1;
+    for (int var_i = 0; var_i < NBINVARS; ++var_i) ncells *= nedges[var_i]-1;
+
+    // Fill accumulators, with each thread taking the next available chunk.
+    lint nchunks  = (nentries + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    lint nworkers = nchunks < nthreads ? nchunks : nthreads;
+    printf(
+            "Processing %ld entries in %ld chunks using %ld thread(s).\n",
+            nentries, nchunks, nworkers
+    );
+    if (nworkers > 1) ROOT::EnableThreadSafety();
+    rge_pbar_set_nentries(nchunks);
+
+    std::vector<rge_moments> acc(
+            static_cast<luint>(nchunks) * NTARGETS * ncells,
+            rge_moments_init()
+    );
+    std::atomic<lint> next_chunk(0);
+    std::atomic<lint> nfilled(0);
+    std::atomic<lint> nfinished(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> workers;
+    for (lint worker_i = 0; worker_i < nworkers; ++worker_i) {
+        workers.emplace_back([&] {
+            // Each thread reads through its own file handle.
+            TFile *f = TFile::Open(in_filename, "READ");
+            TNtuple *t = (f && !f->IsZombie()) ?
+                    f->Get<TNtuple>(RGE_TREENAMEDATA) : NULL;
+            if (t == NULL || rge_attach_kinematics(f, t)) {
+                failed = true;
+                ++nfinished;
+                return;
+            }
+            Float_t vars[RGE_VARS_SIZE];
+            for (int var_i = 0; var_i < RGE_VARS_SIZE; ++var_i) {
+                t->SetBranchAddress(RGE_VARS[var_i], &vars[var_i]);
+            }
+            Long64_t evn64;
+            bool has_evn64 = t->GetBranch(RGE_EVENTNO64) != NULL;
+            if (has_evn64) t->SetBranchAddress(RGE_EVENTNO64, &evn64);
+
+            for (
+                    lint chunk_i = next_chunk++;
+                    chunk_i < nchunks && !failed; chunk_i = next_chunk++
+            ) {
+                lint start = chunk_i * CHUNK_SIZE;
+                lint end   = start + CHUNK_SIZE < nentries ?
+                        start + CHUNK_SIZE : nentries;
+                fill_chunk(
+                        t, vars, has_evn64 ? &evn64 : NULL, start, end,
+                        nentries, pid, skimmed, edges, nedges, vz_range,
+                        &(acc[static_cast<luint>(chunk_i) * NTARGETS * ncells])
+                );
+                ++nfilled;
+            }
+            f->Close();
+            ++nfinished;
+        });
+    }
+
+    // Update progress bar from the main thread while workers run.
+    lint shown = 0;
+    while (nfinished < nworkers) {
+        for (; shown < nfilled; ++shown) rge_pbar_update(shown);
+        usleep(PBAR_PERIOD);
+    }
+    for (std::thread &worker : workers) worker.join();
+    for (; shown < nfilled; ++shown) rge_pbar_update(shown);
+    if (failed) {
+        rge_errno = RGEERR_BADINPUTFILE;
+        return 1;
+    }
+
+    // Merge chunks in order.
+    std::vector<rge_moments> total(NTARGETS * ncells, rge_moments_init());
+    for (lint chunk_i = 0; chunk_i < nchunks; ++chunk_i) {
+        for (luint acc_i = 0; acc_i < NTARGETS * ncells; ++acc_i) {
+            rge_moments_merge(
+                    &(total[acc_i]),
+                    &(acc[static_cast<luint>(chunk_i) * NTARGETS * ncells +
+                            acc_i])
+            );
+        }
+    }
+
+    // === WRITE TO OUTPUT FILE ================================================
+    FILE *f_out = fopen(out_filename, "w");
+    if (f_out == NULL) {
+        rge_errno = RGEERR_OUTPUTTEXTFAILED;
+        return 1;
+    }
+
+    fprintf(f_out, "# input: %s\n# pid: %ld\n#", in_filename, pid);
+    for (int var_i = 0; var_i < NBINVARS; ++var_i) {
+        fprintf(
+                f_out, " \"%s\" low, \"%s\" high,", BIN_VARS[var_i].name,
+                BIN_VARS[var_i].name
+        );
+    }
+    for (int tgt_i = 0; tgt_i < NTARGETS; ++tgt_i) {
+        const char *tgt = TARGET_LIST[tgt_i];
+        fprintf(
+                f_out, " %s n, %s <Pt2>, %s <Pt2> err, %s Pt2 var,",
+                tgt, tgt, tgt, tgt
+        );
+    }
+    fprintf(f_out, " DeltaPt2, DeltaPt2 err\n");
+
+    for (luint cell_i = 0; cell_i < ncells; ++cell_i) {
+        // Find the bin of each binning variable, last one first.
+        luint bin[NBINVARS];
+        luint cell_rem = cell_i;
+        for (int var_i = NBINVARS-1; var_i >= 0; --var_i) {
+            bin[var_i] = cell_rem % (nedges[var_i]-1);
+            cell_rem  /= nedges[var_i]-1;
+        }
+        for (int var_i = 0; var_i < NBINVARS; ++var_i) {
+            fprintf(
+                    f_out, "%12.6f %12.6f ", edges[var_i][bin[var_i]],
+                    edges[var_i][bin[var_i]+1]
+            );
+        }
+
+        for (int tgt_i = 0; tgt_i < NTARGETS; ++tgt_i) {
+            rge_moments *m =
+                    &(total[static_cast<luint>(tgt_i)*ncells + cell_i]);
+            fprintf(
+                    f_out, "%10ld %14.8f %14.8f %14.8f ", m->n, m->mean,
+                    rge_moments_mean_err(m), rge_moments_variance(m)
+            );
+        }
+
+        rge_moments *d2    = &(total[TGT_D2   *ncells + cell_i]);
+        rge_moments *solid = &(total[TGT_SOLID*ncells + cell_i]);
+        if (d2->n < 2 || solid->n < 2) {
+            fprintf(f_out, "nan nan\n");
+            continue;
+        }
+        double err_d2    = rge_moments_mean_err(d2);
+        double err_solid = rge_moments_mean_err(solid);
+        fprintf(
+                f_out, "%14.8f %14.8f\n", solid->mean - d2->mean,
+                sqrt(err_d2*err_d2 + err_solid*err_solid)
+        );
+    }
+    fclose(f_out);
+
+    printf("Done! Check out the Pt broadening at %s.\n", out_filename);
+
+    rge_errno = RGEERR_NOERR;
+    return 0;
+}
+
+/** Handle arguments for pt_broadening using optarg. */
+static int handle_args(
+        int argc, char **argv, char **in_filename, char **out_filename,
+        char **work_dir, lint *pid, luint *nedges, double **edges,
+        double vz_range[NTARGETS][2], lint *nthreads
+) {
+    // Handle arguments.
+    int opt;
+    char *tmp_out_filename = NULL;
+    luint nvz[NTARGETS]    = {0, 0};
+    double *vz[NTARGETS]   = {NULL, NULL};
+    while ((opt = getopt(argc, argv, "-hq:n:z:d:s:p:j:o:w:")) != -1) {
+        switch (opt) {
+            case 'h':
+                rge_errno = RGEERR_USAGE;
+                return 1;
+            case 'q':
+                rge_grab_multiarg(
+                        argc, argv, &optind, &(nedges[0]), &(edges[0])
+                );
+                break;
+            case 'n':
+                rge_grab_multiarg(
+                        argc, argv, &optind, &(nedges[1]), &(edges[1])
+                );
+                break;
+            case 'z':
+                rge_grab_multiarg(
+                        argc, argv, &optind, &(nedges[2]), &(edges[2])
+                );
+                break;
+            case 'd':
+                rge_grab_multiarg(
+                        argc, argv, &optind, &(nvz[TGT_D2]), &(vz[TGT_D2])
+                );
+                break;
+            case 's':
+                rge_grab_multiarg(
+                        argc, argv, &optind, &(nvz[TGT_SOLID]), &(vz[TGT_SOLID])
+                );
+                break;
+            case 'p':
+                if (rge_process_pid(pid, optarg)) return 1;
+                break;
+            case 'j':
+                if (rge_process_nthreads(nthreads, optarg)) return 1;
+                break;
+            case 'o':
+                rge_grab_string(optarg, &tmp_out_filename);
+                break;
+            case 'w':
+                rge_grab_string(optarg, work_dir);
+                break;
+            case 1:
+                rge_grab_string(optarg, in_filename);
+                break;
+            default:
+                rge_errno = RGEERR_BADOPTARGS;
+                return 1;
+        }
+    }
+
+    // Check that all binnings were defined with at least two edges.
+    for (int var_i = 0; var_i < NBINVARS; ++var_i) {
+        if (nedges[var_i] == 0) {
+            rge_errno = RGEERR_NOEDGE;
+            return 1;
+        }
+        if (nedges[var_i] < 2) {
+            rge_errno = RGEERR_BADEDGES;
+            return 1;
+        }
+    }
+
+    // Check that both targets were defined with a valid range.
+    for (int tgt_i = 0; tgt_i < NTARGETS; ++tgt_i) {
+        bool valid = nvz[tgt_i] == 2 && vz[tgt_i][0] < vz[tgt_i][1];
+        if (valid) {
+            vz_range[tgt_i][0] = vz[tgt_i][0];
+            vz_range[tgt_i][1] = vz[tgt_i][1];
+        }
+        if (vz[tgt_i] != NULL) free(vz[tgt_i]);
+        if (!valid) {
+            rge_errno = RGEERR_BADTARGETRANGE;
+            return 1;
+        }
+    }
+
+    // Define workdir if undefined.
+    if (*work_dir == NULL) {
+        *work_dir = static_cast<char *>(malloc(PATH_MAX));
+        sprintf(*work_dir, "%s/../root_io", dirname(argv[0]));
+    }
+
+    // Check positional argument.
+    if (*in_filename == NULL) {
+        rge_errno = RGEERR_NOINPUTFILE;
+        return 1;
+    }
+
+    // Check input filename validity and get run number.
+    int run_no;
+    if (rge_handle_root_filename(*in_filename, &run_no)) return 1;
+
+    // Define output filename, including work_dir.
+    if (tmp_out_filename == NULL) {
+        tmp_out_filename = static_cast<char *>(malloc(PATH_MAX));
+        sprintf(tmp_out_filename, "pt_broadening_%06d.txt", run_no);
+    }
+    *out_filename = static_cast<char *>(malloc(PATH_MAX));
+    sprintf(*out_filename, "%s/%s", *work_dir, tmp_out_filename);
+    free(tmp_out_filename);
+
+    return 0;
+}
+
+/** Entry point of the program. */
+int main(int argc, char **argv) {
+    // Handle arguments.
+    char *in_filename  = NULL;
+    char *out_filename = NULL;
+    char *work_dir     = NULL;
+    lint pid           = 211;
+    luint nedges[NBINVARS]  = {0, 0, 0};
+    double *edges[NBINVARS] = {NULL, NULL, NULL};
+    double vz_range[NTARGETS][2];
+    lint nthreads      = 1;
+
+    int err = handle_args(
+            argc, argv, &in_filename, &out_filename, &work_dir, &pid, nedges,
+            edges, vz_range, &nthreads
+    );
+
+    // Run.
+    if (rge_errno == RGEERR_UNDEFINED && err == 0) {
+        run(in_filename, out_filename, pid, edges, nedges, vz_range, nthreads);
+    }
+
+    // Free up memory.
+    if (in_filename  != NULL) free(in_filename);
+    if (out_filename != NULL) free(out_filename);
+    if (work_dir     != NULL) free(work_dir);
+    for (int var_i = 0; var_i < NBINVARS; ++var_i) {
+        if (edges[var_i] != NULL) free(edges[var_i]);
+    }
+
+    // Return errcode.
+    return rge_print_usage(USAGE_MESSAGE);
+}
@@ -30,3 +30,34 @@ const char *RGE_VARS[RGE_VARS_SIZE] = {
         RGE_ZH.name, RGE_PT2.name, RGE_PL2.name, RGE_PHIPQ.name,
                 RGE_THETAPQ.name
 };
+
+const int RGE_PRIMVARS[RGE_PRIMVARS_SIZE] = {
+        RGE_RUNNO.addr, RGE_EVENTNO.addr,
+        RGE_PID.addr, RGE_CHARGE.addr, RGE_STATUS.addr, RGE_MASS.addr,
+                RGE_VX.addr, RGE_VY.addr, RGE_VZ.addr, RGE_PX.addr,
+                RGE_PY.addr, RGE_PZ.addr, RGE_P.addr, RGE_THETA.addr,
+                RGE_PHI.addr, RGE_BETA.addr,
+        RGE_CHI2.addr, RGE_NDF.addr,
+        RGE_PCALE.addr, RGE_ECINE.addr, RGE_ECOUE.addr, RGE_TOTE.addr,
+        RGE_DTOF.addr,
+        RGE_NPHELTCC.addr, RGE_NPHEHTCC.addr
+};
+
+const int RGE_KINVARS[RGE_KINVARS_SIZE] = {
+        RGE_BEAME.addr,
+        RGE_Q2.addr, RGE_NU.addr, RGE_XB.addr, RGE_YB.addr, RGE_W2.addr,
+        RGE_ZH.addr, RGE_PT2.addr, RGE_PL2.addr, RGE_PHIPQ.addr,
+                RGE_THETAPQ.addr
+};
+
+const char *RGE_PI0VARS[RGE_PI0VARS_SIZE] = {
+        RGE_PI0_RUNNO.name, RGE_PI0_EVENTNO.name, RGE_PI0_BEAME.name,
+        RGE_PI0_E1.name, RGE_PI0_E2.name, RGE_PI0_OPENA.name,
+                RGE_PI0_MGG.name, RGE_PI0_PX.name, RGE_PI0_PY.name,
+                RGE_PI0_PZ.name, RGE_PI0_P.name, RGE_PI0_THETA.name,
+                RGE_PI0_PHI.name,
+        RGE_PI0_Q2.name, RGE_PI0_NU.name, RGE_PI0_XB.name, RGE_PI0_YB.name,
+                RGE_PI0_W2.name,
+        RGE_PI0_ZH.name, RGE_PI0_PT2.name, RGE_PI0_PL2.name,
+                RGE_PI0_PHIPQ.name, RGE_PI0_THETAPQ.name
+};
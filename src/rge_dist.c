@@ -0,0 +1,237 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#include "../lib/rge_dist.h"
+
+// --+ internal +---------------------------------------------------------------
+/** Rank of this process and number of processes, set by rge_dist_init(). */
+static int dist_rank = 0;
+static int dist_size = 1;
+
+#ifdef RGE_MPI
+int reduce_sum(void *arr, luint size, MPI_Datatype type, luint width) {
+    char *ptr = static_cast<char *>(arr);
+    for (luint start = 0; start < size; start += DIST_CHUNK) {
+        int count = static_cast<int>(
+                size - start < DIST_CHUNK ? size - start : DIST_CHUNK
+        );
+        void *buf = ptr + start * width;
+        if (dist_rank == 0) {
+            MPI_Reduce(
+                    MPI_IN_PLACE, buf, count, type, MPI_SUM, 0, MPI_COMM_WORLD
+            );
+        }
+        else {
+            MPI_Reduce(buf, NULL, count, type, MPI_SUM, 0, MPI_COMM_WORLD);
+        }
+    }
+    return 0;
+}
+#endif
+
+// --+ library +----------------------------------------------------------------
+int rge_dist_init(int *argc, char ***argv) {
+#ifdef RGE_MPI
+    MPI_Init(argc, argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &dist_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &dist_size);
+    if (dist_rank != 0 && freopen("/dev/null", "w", stdout) == NULL) {
+        return 1;
+    }
+#else
+    (void) argc;
+    (void) argv;
+#endif
+    return 0;
+}
+
+int rge_dist_finalize(int err) {
+#ifdef RGE_MPI
+    if (err != 0 && dist_size > 1) MPI_Abort(MPI_COMM_WORLD, err);
+    MPI_Finalize();
+#endif
+    return err;
+}
+
+int rge_dist_rank() {
+    return dist_rank;
+}
+
+int rge_dist_size() {
+    return dist_size;
+}
+
+int rge_dist_shard(lint nentries, lint *first, lint *last) {
+    *first = (nentries *  dist_rank)     / dist_size;
+    *last  = (nentries * (dist_rank + 1)) / dist_size;
+    return 0;
+}
+
+int rge_dist_barrier() {
+#ifdef RGE_MPI
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+    return 0;
+}
+
+int rge_dist_bcast(long *x) {
+#ifdef RGE_MPI
+    MPI_Bcast(x, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+#else
+    (void) x;
+#endif
+    return 0;
+}
+
+int rge_dist_bcast(double *x) {
+#ifdef RGE_MPI
+    MPI_Bcast(x, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+#else
+    (void) x;
+#endif
+    return 0;
+}
+
+int rge_dist_reduce_sum(int *arr, luint size) {
+#ifdef RGE_MPI
+    reduce_sum(arr, size, MPI_INT, sizeof(int));
+#else
+    (void) arr;
+    (void) size;
+#endif
+    return 0;
+}
+
+int rge_dist_reduce_sum(lint *arr, luint size) {
+#ifdef RGE_MPI
+    reduce_sum(arr, size, MPI_LONG, sizeof(lint));
+#else
+    (void) arr;
+    (void) size;
+#endif
+    return 0;
+}
+
+int rge_dist_reduce_sum(double *arr, luint size) {
+#ifdef RGE_MPI
+    reduce_sum(arr, size, MPI_DOUBLE, sizeof(double));
+#else
+    (void) arr;
+    (void) size;
+#endif
+    return 0;
+}
+
+int rge_dist_allreduce_max(luint *x) {
+#ifdef RGE_MPI
+    MPI_Allreduce(
+            MPI_IN_PLACE, x, 1, MPI_UNSIGNED_LONG, MPI_MAX, MPI_COMM_WORLD
+    );
+#else
+    (void) x;
+#endif
+    return 0;
+}
+
+int rge_dist_allreduce_lor(bool *arr, luint size) {
+#ifdef RGE_MPI
+    for (luint start = 0; start < size; start += DIST_CHUNK) {
+        int count = static_cast<int>(
+                size - start < DIST_CHUNK ? size - start : DIST_CHUNK
+        );
+        MPI_Allreduce(
+                MPI_IN_PLACE, arr + start, count, MPI_CXX_BOOL, MPI_LOR,
+                MPI_COMM_WORLD
+        );
+    }
+#else
+    (void) arr;
+    (void) size;
+#endif
+    return 0;
+}
+
+int rge_dist_allgather(double *send, luint size, double *recv) {
+#ifdef RGE_MPI
+    MPI_Allgather(
+            send, static_cast<int>(size), MPI_DOUBLE,
+            recv, static_cast<int>(size), MPI_DOUBLE, MPI_COMM_WORLD
+    );
+#else
+    for (luint i = 0; i < size; ++i) recv[i] = send[i];
+#endif
+    return 0;
+}
+
+int rge_dist_reduce_hist(TH1 *h) {
+    if (dist_size == 1) return 0;
+
+    // Pack contents, sum of squared weights, statistics, and entries.
+    luint ncells = static_cast<luint>(h->GetNcells());
+    bool sumw2   = h->GetSumw2N() > 0;
+    std::vector<double> buf(2*ncells + TH1::kNstat + 1, 0.);
+    for (luint cell = 0; cell < ncells; ++cell) {
+        buf[cell] = h->GetBinContent(static_cast<int>(cell));
+        if (sumw2) {
+            buf[ncells + cell] = h->GetSumw2()->At(static_cast<int>(cell));
+        }
+    }
+    h->GetStats(&(buf[2*ncells]));
+    buf[2*ncells + TH1::kNstat] = h->GetEntries();
+
+    rge_dist_reduce_sum(buf.data(), buf.size());
+    if (dist_rank != 0) return 0;
+
+    // Unpack. Statistics and entries go last since SetBinContent changes them.
+    for (luint cell = 0; cell < ncells; ++cell) {
+        h->SetBinContent(static_cast<int>(cell), buf[cell]);
+        if (sumw2) {
+            h->GetSumw2()->SetAt(buf[ncells + cell], static_cast<int>(cell));
+        }
+    }
+    h->PutStats(&(buf[2*ncells]));
+    h->SetEntries(buf[2*ncells + TH1::kNstat]);
+
+    return 0;
+}
+
+int rge_dist_part_filename(const char *filename, char *part_filename) {
+    if (dist_size == 1) sprintf(part_filename, "%s", filename);
+    else sprintf(part_filename, "%s.part%03d.root", filename, dist_rank);
+    return 0;
+}
+
+int rge_dist_gather_files(const char *filename) {
+    if (dist_size == 1) return 0;
+
+    // Wait for all partial files to be closed.
+    rge_dist_barrier();
+    if (dist_rank != 0) return 0;
+
+    char *part_filenames[static_cast<luint>(dist_size)];
+    for (int rank = 0; rank < dist_size; ++rank) {
+        part_filenames[rank] = static_cast<char *>(malloc(PATH_MAX));
+        sprintf(part_filenames[rank], "%s.part%03d.root", filename, rank);
+    }
+
+    int err = rge_merge_files(part_filenames, dist_size, filename, true);
+
+    for (int rank = 0; rank < dist_size; ++rank) {
+        unlink(part_filenames[rank]);
+        free(part_filenames[rank]);
+    }
+
+    return err;
+}
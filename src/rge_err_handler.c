@@ -58,6 +58,31 @@ static const std::map<uint, const char *> ERRMAP = {
             "Too many numbers passed to -b, input only four."},
     {RGEERR_BADBINNING,
             "Numbers passed to -b are invalid, check argument format."},
+    {RGEERR_INVALIDNTHREADS,
+            "Number of threads is invalid. Input a positive number after -j."},
+    {RGEERR_INVALIDNREPS,
+            "Number of repetitions is invalid. Input a positive number after "
+            "-r."},
+    {RGEERR_NOCOMMAND,
+            "No command given. Input the command to run after the options."},
+    {RGEERR_INVALIDNSLOW,
+            "Number of slowest events is invalid. Input a non-negative number "
+            "after -l."},
+    {RGEERR_NOTRACING,
+            "Program was built without tracing. Rebuild with `make TRACE=1` "
+            "to use -t and -e."},
+    {RGEERR_INVALIDTRACEOPT,
+            "Trace option is invalid. Input a positive period after -t, or a "
+            "non-negative event number after -e."},
+    {RGEERR_BADTARGETRANGE,
+            "Target vz ranges are invalid. Input a lower and an upper limit "
+            "after both -d and -s."},
+    {RGEERR_BADSELECTIONS,
+            "Particle selections are invalid. Input a comma-separated list of "
+            "all, +, -, neutral, and PIDs after -P, without using -p."},
+    {RGEERR_INVALIDPERIOD,
+            "Period is invalid. Input a positive number of seconds after -p "
+            "and -s."},
 
     // File errors.
     {RGEERR_NOINPUTFILE,
@@ -100,6 +125,35 @@ static const std::map<uint, const char *> ERRMAP = {
             "Failed to create output root file."},
     {RGEERR_OUTPUTTEXTFAILED,
             "Failed to create output text file."},
+    {RGEERR_NOOUTPUTFILE,
+            "An output file should be specified with -o."},
+    {RGEERR_MERGEFAILED,
+            "Failed to merge input files. Check that all of them are valid "
+            "and of the same type."},
+    {RGEERR_RUNMISMATCH,
+            "Input files belong to different runs. Pass the partitions of a "
+            "single run."},
+    {RGEERR_OUTPUTTRACEFAILED,
+            "Failed to write the trace file."},
+    {RGEERR_BADTRACEFILE,
+            "Trace file is invalid, or was written by a different version."},
+    {RGEERR_NOPHIPQGRID,
+            "Input file has no binning grid of phiPQ plots. Produce it with "
+            "`draw_plots -S` and acceptance correction plots enabled."},
+    {RGEERR_STAGINGFAILED,
+            "Failed to move an output from scratch to its final location. It "
+            "was left in RGE_SCRATCH."},
+    {RGEERR_NOWATCHDIR,
+            "Watched directory doesn't exist or can't be read."},
+    {RGEERR_BADKINTREE,
+            "Kinematics tree is missing or doesn't match the data tree. "
+            "Recompute it with `make_ntuples -R`."},
+    {RGEERR_UNSPLITNTUPLES,
+            "Input file keeps its kinematics in the data tree. Regenerate it "
+            "with make_ntuples before using -R."},
+    {RGEERR_NOPCALCOORDS,
+            "Input file has no REC::Calorimeter lv and lw branches, needed by "
+            "-g. Convert it again with hipo2root."},
 
     // Detector errors.
     {RGEERR_INVALIDCALLAYER,
@@ -111,6 +165,8 @@ static const std::map<uint, const char *> ERRMAP = {
     {RGEERR_NOFMTBANK,
             "FMT::Tracks bank not found in input. No FMT analysis is available "
             "for this input file."},
+    {RGEERR_INVALIDTRKSECTOR,
+            "Invalid sector in the track bank. Check bank integrity."},
 
     // Program errors.
     {RGEERR_UNIMPLEMENTEDBEAMENERGY,
@@ -132,6 +188,17 @@ static const std::map<uint, const char *> ERRMAP = {
     {RGEERR_WRONGENTRYTYPE,
             "An invalid entry type was requested to the count_entries function."
             " Check the function input in acc_corr.c."},
+    {RGEERR_BADGRIDDIMS,
+            "Requested bin doesn't match the dimensions of the binning grid. "
+            "Check the input of rge_grid_project."},
+    {RGEERR_COMMANDFAILED,
+            "Benchmarked command failed to run. Check its log file."},
+    {RGEERR_EVENTNOTINBATCH,
+            "An event outside of the events read by rge_get_batch was "
+            "selected. Check the function input in rge_hipo_bank.c."},
+    {RGEERR_BADROUNDTRIP,
+            "A value changed after being written and read back. Check the "
+            "round-trip checks printed by benchmark."},
 
     // Particle errors.
     {RGEERR_PIDNOTFOUND,
@@ -180,18 +180,32 @@ int rge_extract_sf(
     rge_hipobank track       = rge_hipobank_init(RGE_RECTRACK,       t);
     rge_hipobank calorimeter = rge_hipobank_init(RGE_RECCALORIMETER, t);
 
-    // Iterate through input file. Each TTree entry is one event.
+    // Iterate through input file. Each TTree entry is one event. Banks are
+    //     read in batches of RGE_BATCHNEVENTS events.
     if (nevn == -1 || t->GetEntries() < nevn) nevn = t->GetEntries();
     rge_pbar_set_nentries(nevn);
 
+    rge_hipobatch particle_batch    = rge_hipobatch_init();
+    rge_hipobatch track_batch       = rge_hipobatch_init();
+    rge_hipobatch calorimeter_batch = rge_hipobatch_init();
+
     printf("Reading %ld events from %s.\n", nevn, in_filename);
     for (lint evn = 0; evn < nevn; ++evn) {
         rge_pbar_update(evn);
 
+        // Read next batch of events.
+        if (evn == particle_batch.first + particle_batch.nevents) {
+            lint size = nevn - evn < RGE_BATCHNEVENTS ?
+                    nevn - evn : RGE_BATCHNEVENTS;
+            rge_get_batch(&particle,    t, evn, size, &particle_batch);
+            rge_get_batch(&track,       t, evn, size, &track_batch);
+            rge_get_batch(&calorimeter, t, evn, size, &calorimeter_batch);
+        }
+
         // Get entries from bank containers.
-        rge_get_entries(&particle,    t, evn);
-        rge_get_entries(&track,       t, evn);
-        rge_get_entries(&calorimeter, t, evn);
+        if (rge_select_event(&particle,    &particle_batch,    evn)) return 1;
+        if (rge_select_event(&track,       &track_batch,       evn)) return 1;
+        if (rge_select_event(&calorimeter, &calorimeter_batch, evn)) return 1;
 
         // Skip events without the necessary banks.
         if (particle.nrows == 0 || track.nrows == 0 || calorimeter.nrows == 0) {
@@ -0,0 +1,100 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#include "../lib/rge_fiducial.h"
+
+// --+ internal +---------------------------------------------------------------
+bool point_in_polygon(
+        double x, double y, const double poly[][2], luint nvertices
+) {
+    bool inside = false;
+    for (luint i = 0, j = nvertices - 1; i < nvertices; j = i++) {
+        if ((poly[i][1] > y) == (poly[j][1] > y)) continue;
+        double x_cross = poly[j][0] + (y - poly[j][1]) *
+                (poly[i][0] - poly[j][0]) / (poly[i][1] - poly[j][1]);
+        if (x < x_cross) inside = !inside;
+    }
+    return inside;
+}
+
+// --+ library +----------------------------------------------------------------
+int rge_fiducial_init(rge_fiducial *fid) {
+    memset(fid->dc_map, 0, sizeof(fid->dc_map));
+
+    double dtheta = (FID_THETAMAX - FID_THETAMIN) / RGE_FIDNTHETA;
+    double dphi   = (FID_PHIMAX   - FID_PHIMIN)   / RGE_FIDNPHI;
+    for (int s = 0; s < RGE_NSECTORS; ++s) {
+        // Rasterize DC polygon, testing the center of each cell.
+        for (luint i = 0; i < RGE_FIDNTHETA; ++i) {
+            double theta = FID_THETAMIN + (static_cast<double>(i) + .5)*dtheta;
+            for (luint j = 0; j < RGE_FIDNPHI; ++j) {
+                double phi = FID_PHIMIN + (static_cast<double>(j) + .5)*dphi;
+                if (!point_in_polygon(
+                        theta, phi, FID_DCPOLYGON, FID_DCNVERTICES
+                )) continue;
+                fid->dc_map[s][i][j/64] |= static_cast<uint64_t>(1) << (j%64);
+            }
+        }
+
+        // PCAL edges.
+        fid->pcal_lv_min[s] = FID_PCALLVMIN;
+        fid->pcal_lw_min[s] = FID_PCALLWMIN;
+    }
+
+    return 0;
+}
+
+int rge_apply_dc_fiducial_cut(
+        rge_fiducial *fid, int sector, double px, double py, double pz
+) {
+    if (sector < 1 || sector > RGE_NSECTORS) {
+        rge_errno = RGEERR_INVALIDTRKSECTOR;
+        return 2;
+    }
+
+    // Get theta and phi in the sector's local frame. Sector 1 is centered at
+    //     phi = 0, and each following sector is rotated by 60 degrees.
+    double theta = (180. / M_PI) * atan2(sqrt(px*px + py*py), pz);
+    double phi   = (180. / M_PI) * atan2(py, px) - 60. * (sector - 1);
+    if (phi < -180.) phi += 360.;
+
+    // Look up the cell.
+    if (theta < FID_THETAMIN || theta >= FID_THETAMAX) return 1;
+    if (phi   < FID_PHIMIN   || phi   >= FID_PHIMAX)   return 1;
+    luint i = static_cast<luint>(
+            (theta - FID_THETAMIN) * (RGE_FIDNTHETA/(FID_THETAMAX-FID_THETAMIN))
+    );
+    luint j = static_cast<luint>(
+            (phi - FID_PHIMIN) * (RGE_FIDNPHI/(FID_PHIMAX-FID_PHIMIN))
+    );
+    if (i >= RGE_FIDNTHETA || j >= RGE_FIDNPHI) return 1;
+
+    return (fid->dc_map[sector-1][i][j/64] >> (j%64)) & 1 ? 0 : 1;
+}
+
+int rge_apply_pcal_fiducial_cut(
+        rge_fiducial *fid, int sector, double lv, double lw
+) {
+    if (sector < 1 || sector > RGE_NSECTORS) {
+        rge_errno = RGEERR_INVALIDCALSECTOR;
+        return 2;
+    }
+
+    if (lv < fid->pcal_lv_min[sector-1] || lw < fid->pcal_lw_min[sector-1]) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -41,8 +41,8 @@ int get_bin_edges(
 }
 
 int get_acc_corr(
-        FILE *file_in, luint pids_size, luint nbins, lint *pids, int **n_thrown,
-        int **n_simul
+        FILE *file_in, luint pids_size, luint nbins, lint *pids,
+        lint **n_thrown, lint **n_simul
 ) {
     // Get PIDs.
     for (luint pid_i = 0; pid_i < pids_size; ++pid_i) {
@@ -52,25 +52,103 @@ int get_acc_corr(
     // Get acceptance correction.
     for (luint pid_i = 0; pid_i < pids_size; ++pid_i) {
         // Get number of thrown events.
-        n_thrown[pid_i] = static_cast<int *>(
+        n_thrown[pid_i] = static_cast<lint *>(
                 malloc(nbins * sizeof(*n_thrown[pid_i]))
         );
         for (luint bin_i = 0; bin_i < nbins; ++bin_i) {
-            fscanf_dump = fscanf(file_in, "%d ", &(n_thrown[pid_i][bin_i]));
+            fscanf_dump = fscanf(file_in, "%ld ", &(n_thrown[pid_i][bin_i]));
         }
 
         // Get number of simulated events.
-        n_simul[pid_i] = static_cast<int *>(
+        n_simul[pid_i] = static_cast<lint *>(
                 malloc(nbins * sizeof(*n_simul[pid_i]))
         );
         for (luint bin_i = 0; bin_i < nbins; ++bin_i) {
-            fscanf_dump = fscanf(file_in, "%d ", &(n_simul[pid_i][bin_i]));
+            fscanf_dump = fscanf(file_in, "%ld ", &(n_simul[pid_i][bin_i]));
         }
     }
 
     return 0;
 }
 
+int acc_corr_from_shm(
+        const void *payload, luint *bin_nedges, double ***bin_edges,
+        luint *pids_size, luint *nbins, lint **pids, lint ***n_thrown,
+        lint ***n_simul
+) {
+    const luint *sizes = static_cast<const luint *>(payload);
+    for (int bi = 0; bi < 5; ++bi) bin_nedges[bi] = sizes[bi];
+    *pids_size = sizes[5];
+    *nbins     = sizes[6];
+
+    // Bin edges.
+    double *edges = const_cast<double *>(
+            reinterpret_cast<const double *>(sizes + 7)
+    );
+    *bin_edges = static_cast<double **>(malloc(5 * sizeof(**bin_edges)));
+    for (int bi = 0; bi < 5; ++bi) {
+        (*bin_edges)[bi] = edges;
+        edges += bin_nedges[bi];
+    }
+
+    // PIDs.
+    *pids = reinterpret_cast<lint *>(edges);
+
+    // Number of thrown and simulated events.
+    lint *counts = *pids + *pids_size;
+    *n_thrown = static_cast<lint **>(malloc(*pids_size * sizeof(**n_thrown)));
+    *n_simul  = static_cast<lint **>(malloc(*pids_size * sizeof(**n_simul)));
+    for (luint pid_i = 0; pid_i < *pids_size; ++pid_i) {
+        (*n_thrown)[pid_i] = counts;
+        counts += *nbins;
+        (*n_simul)[pid_i]  = counts;
+        counts += *nbins;
+    }
+
+    return 0;
+}
+
+int acc_corr_to_shm(
+        char *acc_filename, luint *bin_nedges, double **bin_edges,
+        luint pids_size, luint nbins, lint *pids, lint **n_thrown,
+        lint **n_simul
+) {
+    luint nedges = 0;
+    for (int bi = 0; bi < 5; ++bi) nedges += bin_nedges[bi];
+
+    std::vector<char> payload(
+            7*sizeof(luint) + nedges*sizeof(double) + pids_size*sizeof(lint) +
+            2*pids_size*nbins*sizeof(lint)
+    );
+    char *ptr = payload.data();
+
+    // Sizes.
+    luint sizes[7];
+    for (int bi = 0; bi < 5; ++bi) sizes[bi] = bin_nedges[bi];
+    sizes[5] = pids_size;
+    sizes[6] = nbins;
+    memcpy(ptr, sizes, sizeof(sizes));
+    ptr += sizeof(sizes);
+
+    // Bin edges and PIDs.
+    for (int bi = 0; bi < 5; ++bi) {
+        memcpy(ptr, bin_edges[bi], bin_nedges[bi] * sizeof(double));
+        ptr += bin_nedges[bi] * sizeof(double);
+    }
+    memcpy(ptr, pids, pids_size * sizeof(lint));
+    ptr += pids_size * sizeof(lint);
+
+    // Number of thrown and simulated events.
+    for (luint pid_i = 0; pid_i < pids_size; ++pid_i) {
+        memcpy(ptr, n_thrown[pid_i], nbins * sizeof(lint));
+        ptr += nbins * sizeof(lint);
+        memcpy(ptr, n_simul[pid_i],  nbins * sizeof(lint));
+        ptr += nbins * sizeof(lint);
+    }
+
+    return rge_shm_publish("acc", acc_filename, payload.data(), payload.size());
+}
+
 // --+ library +----------------------------------------------------------------
 int rge_get_sf_params(
         char *filename, double sf[RGE_NSECTORS][RGE_NSFPARAMS][2]
@@ -79,6 +157,16 @@ int rge_get_sf_params(
         rge_errno = RGEERR_NOSAMPFRACFILE;
         return 1;
     }
+
+    // Read from shared-memory cache if available.
+    luint shm_size;
+    const void *shm = rge_shm_attach("sf", filename, &shm_size);
+    luint sf_size = sizeof(double[RGE_NSECTORS][RGE_NSFPARAMS][2]);
+    if (shm != NULL && shm_size == sf_size) {
+        memcpy(sf, shm, sf_size);
+        return 0;
+    }
+
     FILE *file_in = fopen(filename, "r");
 
     for (int sector_i = 0; sector_i < RGE_NSECTORS; ++sector_i) {
@@ -92,19 +180,31 @@ int rge_get_sf_params(
     }
 
     fclose(file_in);
+    rge_shm_publish("sf", filename, sf, sf_size);
     return 0;
 }
 
 int rge_read_acc_corr_file(
         char *acc_filename, luint bin_nedges[5], double ***bin_edges,
-        luint *pids_size, luint *nbins, lint **pids, int ***n_thrown,
-        int ***n_simul
+        luint *pids_size, luint *nbins, lint **pids, lint ***n_thrown,
+        lint ***n_simul
 ) {
     // Access file.
     if (access(acc_filename, F_OK) != 0) {
         rge_errno = RGEERR_NOACCCORRFILE;
         return 1;
     }
+
+    // Attach to shared-memory cache if available.
+    luint shm_size;
+    const void *shm = rge_shm_attach("acc", acc_filename, &shm_size);
+    if (shm != NULL) {
+        return acc_corr_from_shm(
+                shm, bin_nedges, bin_edges, pids_size, nbins, pids, n_thrown,
+                n_simul
+        );
+    }
+
     FILE *acc_file = fopen(acc_filename, "r");
 
     // Get bin_nedges, bin_edges, and pids_size.
@@ -117,8 +217,8 @@ int rge_read_acc_corr_file(
 
     // Malloc list of pids and first dimension of pids and events.
     *pids     = static_cast<lint *>(malloc(*pids_size * sizeof(**pids)));
-    *n_thrown = static_cast<int **>(malloc(*pids_size * sizeof(**n_thrown)));
-    *n_simul  = static_cast<int **>(malloc(*pids_size * sizeof(**n_simul)));
+    *n_thrown = static_cast<lint **>(malloc(*pids_size * sizeof(**n_thrown)));
+    *n_simul  = static_cast<lint **>(malloc(*pids_size * sizeof(**n_simul)));
 
     // Get pids and acc_corr from acceptance correction file.
     get_acc_corr(acc_file, *pids_size, *nbins, *pids, *n_thrown, *n_simul);
@@ -126,5 +226,31 @@ int rge_read_acc_corr_file(
     // Clean up.
     fclose(acc_file);
 
+    // Share with other processes.
+    acc_corr_to_shm(
+            acc_filename, bin_nedges, *bin_edges, *pids_size, *nbins, *pids,
+            *n_thrown, *n_simul
+    );
+
+    return 0;
+}
+
+int rge_free_acc_corr(
+        double **bin_edges, luint pids_size, lint *pids, lint **n_thrown,
+        lint **n_simul
+) {
+    // Arrays attached from shared memory are unmapped on exit.
+    if (!rge_shm_owns(bin_edges[0])) {
+        for (luint bin_i = 0; bin_i < 5; ++bin_i) free(bin_edges[bin_i]);
+        free(pids);
+        for (luint pid_i = 0; pid_i < pids_size; ++pid_i) {
+            free(n_thrown[pid_i]);
+            free(n_simul[pid_i]);
+        }
+    }
+    free(bin_edges);
+    free(n_thrown);
+    free(n_simul);
+
     return 0;
 }
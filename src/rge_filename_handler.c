@@ -121,6 +121,10 @@ int rge_handle_root_filename(char *filename, int *run_no) {
     return err;
 }
 
+int rge_get_beam_energy(int run_no, double *beam_energy) {
+    return get_beam_energy(run_no, beam_energy);
+}
+
 int rge_handle_hipo_filename(char *filename, int *run_no) {
     if (check_hipo_filename(filename)) return 1;
     if (get_run_no(filename, run_no))  return 1;
@@ -0,0 +1,143 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#include "../lib/rge_grid_utils.h"
+
+// --+ internal +---------------------------------------------------------------
+int get_axis_edges(TAxis *ax, double *edges) {
+    int nbins = ax->GetNbins();
+    for (int bin_i = 1; bin_i <= nbins; ++bin_i) {
+        edges[bin_i-1] = ax->GetBinLowEdge(bin_i);
+    }
+    edges[nbins] = ax->GetBinUpEdge(nbins);
+
+    return 0;
+}
+
+// --+ library +----------------------------------------------------------------
+THnSparse *rge_grid_pack(
+        const char *name, const char *title, TH1 *plot_arr[], luint dim_bins,
+        int bin_vars[], luint bin_nbins[], double bin_range[][2]
+) {
+    // Number of cells in the binning grid.
+    luint ncells = 1;
+    for (luint bin_dim_i = 0; bin_dim_i < dim_bins; ++bin_dim_i) {
+        ncells *= bin_nbins[bin_dim_i];
+    }
+
+    // Get dimensions of the output THnSparse.
+    luint plot_dim = static_cast<luint>(plot_arr[0]->GetDimension());
+    luint ndims    = dim_bins + plot_dim;
+    TAxis *plot_axes[2] = {plot_arr[0]->GetXaxis(), plot_arr[0]->GetYaxis()};
+
+    int    nbins[ndims];
+    double xmin [ndims];
+    double xmax [ndims];
+    for (luint bin_dim_i = 0; bin_dim_i < dim_bins; ++bin_dim_i) {
+        nbins[bin_dim_i] = static_cast<int>(bin_nbins[bin_dim_i]);
+        xmin [bin_dim_i] = bin_range[bin_dim_i][0];
+        xmax [bin_dim_i] = bin_range[bin_dim_i][1];
+    }
+    for (luint dim_i = 0; dim_i < plot_dim; ++dim_i) {
+        nbins[dim_bins + dim_i] = plot_axes[dim_i]->GetNbins();
+        xmin [dim_bins + dim_i] = plot_axes[dim_i]->GetXmin();
+        xmax [dim_bins + dim_i] = plot_axes[dim_i]->GetXmax();
+    }
+
+    // Create grid and copy axes. Plot axes might have variable bin sizes, as
+    //     is the case of acceptance corrected plots.
+    THnSparse *grid = new THnSparseF(
+            name, title, static_cast<int>(ndims), nbins, xmin, xmax
+    );
+    grid->Sumw2();
+    for (luint bin_dim_i = 0; bin_dim_i < dim_bins; ++bin_dim_i) {
+        grid->GetAxis(static_cast<int>(bin_dim_i))->SetTitle(
+                RGE_VARS[bin_vars[bin_dim_i]]
+        );
+    }
+    for (luint dim_i = 0; dim_i < plot_dim; ++dim_i) {
+        TAxis *ax = grid->GetAxis(static_cast<int>(dim_bins + dim_i));
+        double edges[static_cast<luint>(nbins[dim_bins + dim_i]) + 1];
+        get_axis_edges(plot_axes[dim_i], edges);
+        ax->Set(nbins[dim_bins + dim_i], edges);
+        ax->SetTitle(plot_axes[dim_i]->GetTitle());
+    }
+
+    // Copy non-empty bins, including underflow and overflow of the plots.
+    double entries = 0;
+    int coord[ndims];
+    for (luint cell_i = 0; cell_i < ncells; ++cell_i) {
+        TH1 *plot = plot_arr[cell_i];
+        entries += plot->GetEntries();
+
+        // Find the coordinates of the cell, last binning variable first.
+        luint cell_rem = cell_i;
+        for (luint bin_dim_i = dim_bins; bin_dim_i-- > 0;) {
+            coord[bin_dim_i] = static_cast<int>(
+                    cell_rem % bin_nbins[bin_dim_i]
+            ) + 1;
+            cell_rem /= bin_nbins[bin_dim_i];
+        }
+
+        int ny = plot_dim == 2 ? plot->GetNbinsY() + 1 : 0;
+        for (int x = 0; x <= plot->GetNbinsX() + 1; ++x) {
+            for (int y = 0; y <= ny; ++y) {
+                int bin = plot_dim == 2 ? plot->GetBin(x, y) : x;
+                double content = plot->GetBinContent(bin);
+                if (content == 0) continue;
+
+                coord[dim_bins] = x;
+                if (plot_dim == 2) coord[dim_bins+1] = y;
+                grid->SetBinContent(coord, content);
+                grid->SetBinError(coord, plot->GetBinError(bin));
+            }
+        }
+    }
+    grid->SetEntries(entries);
+
+    return grid;
+}
+
+TH1 *rge_grid_project(THnSparse *grid, luint dim_bins, luint bin_idx[]) {
+    int plot_dim = grid->GetNdimensions() - static_cast<int>(dim_bins);
+    if (plot_dim != 1 && plot_dim != 2) {
+        rge_errno = RGEERR_BADGRIDDIMS;
+        return NULL;
+    }
+
+    // Restrict binning axes to the requested cell.
+    for (luint bin_dim_i = 0; bin_dim_i < dim_bins; ++bin_dim_i) {
+        TAxis *ax = grid->GetAxis(static_cast<int>(bin_dim_i));
+        if (bin_idx[bin_dim_i] >= static_cast<luint>(ax->GetNbins())) {
+            rge_errno = RGEERR_BADGRIDDIMS;
+            return NULL;
+        }
+        int bin = static_cast<int>(bin_idx[bin_dim_i]) + 1;
+        ax->SetRange(bin, bin);
+    }
+
+    // Project. NOTE. THnSparse::Projection() takes the y axis first.
+    int x_dim = static_cast<int>(dim_bins);
+    TH1 *plot;
+    if (plot_dim == 1) plot = grid->Projection(x_dim, "E");
+    else               plot = grid->Projection(x_dim+1, x_dim, "E");
+
+    // Reset ranges so that the grid can be reused.
+    for (luint bin_dim_i = 0; bin_dim_i < dim_bins; ++bin_dim_i) {
+        grid->GetAxis(static_cast<int>(bin_dim_i))->SetRange();
+    }
+
+    return plot;
+}
@@ -23,11 +23,13 @@ rge_hipoentry entry_init(const char *in_addr, uint in_type) {
 }
 
 int set_nrows(rge_hipobank *b, luint in_nrows) {
-    // Set internal variable.
-    b->nrows = in_nrows;
+    // Set internal variables.
+    b->nrows  = in_nrows;
+    b->batch  = NULL;
+    b->offset = 0;
 
     // Resize vectors.
-    for (it = b->entries.begin(); it != b->entries.end(); ++it) {
+    for (entry_iterator it = b->entries.begin(); it != b->entries.end(); ++it) {
         const char *key = it->first;
         b->entries.at(key).data->resize(b->nrows);
     }
@@ -38,7 +40,15 @@ int set_nrows(rge_hipobank *b, luint in_nrows) {
 double get_entry(rge_hipobank *b, const char *var, luint idx) {
     double entry;
     try {
-        entry = b->entries.at(var).data->at(idx);
+        if (b->batch == NULL) {
+            entry = b->entries.at(var).data->at(idx);
+        }
+        else if (idx < b->nrows) {
+            entry = b->batch->columns.at(var).at(b->offset + idx);
+        }
+        else {
+            throw std::out_of_range(var);
+        }
     }
     catch (...) {
         entry = 0;
@@ -78,7 +88,10 @@ static std::map<
         {"layer",  entry_init("REC::Calorimeter::layer",  BYTE)},
         {"sector", entry_init("REC::Calorimeter::sector", BYTE)},
         {"energy", entry_init("REC::Calorimeter::energy", FLOAT)},
-        {"time",   entry_init("REC::Calorimeter::time",   FLOAT)}
+        {"time",   entry_init("REC::Calorimeter::time",   FLOAT)},
+        {"lu",     entry_init("REC::Calorimeter::lu",     FLOAT)},
+        {"lv",     entry_init("REC::Calorimeter::lv",     FLOAT)},
+        {"lw",     entry_init("REC::Calorimeter::lw",     FLOAT)}
     }},
     {RGE_RECCHERENKOV, {
         {"pindex",   entry_init("REC::Cherenkov::pindex",   SHORT)},
@@ -106,7 +119,9 @@ static std::map<
 // --+ library +----------------------------------------------------------------
 rge_hipobank rge_hipobank_init(const char *bank_version) {
     rge_hipobank b;
-    b.nrows = 0;
+    b.nrows  = 0;
+    b.batch  = NULL;
+    b.offset = 0;
 
     try {b.entries = ENTRYMAP.at(bank_version);}
     catch (...) {rge_errno = RGEERR_INVALIDBANKID;}
@@ -117,20 +132,24 @@ rge_hipobank rge_hipobank_init(const char *bank_version) {
 rge_hipobank rge_hipobank_init(const char *bank_version, TTree *t) {
     rge_hipobank b = rge_hipobank_init(bank_version);
 
-    for (it = b.entries.begin(); it != b.entries.end(); ++it) {
-        const char *key = it->first;
+    for (auto it = b.entries.begin(); it != b.entries.end();) {
+        // Entries missing from t, e.g. columns added to the bank after t was
+        //     written, are dropped.
+        if (t->GetBranch(it->second.addr) == NULL) {
+            it = b.entries.erase(it);
+            continue;
+        }
         t->SetBranchAddress(
-                b.entries.at(key).addr,
-                &(b.entries.at(key).data),
-                &(b.entries.at(key).branch)
+                it->second.addr, &(it->second.data), &(it->second.branch)
         );
+        ++it;
     }
 
     return b;
 }
 
 int rge_link_branches(rge_hipobank *b, TTree *t) {
-    for (it = b->entries.begin(); it != b->entries.end(); ++it) {
+    for (entry_iterator it = b->entries.begin(); it != b->entries.end(); ++it) {
         const char *key = it->first;
         t->Branch(b->entries.at(key).addr, &(b->entries.at(key).data));
     }
@@ -142,7 +161,10 @@ int rge_fill(rge_hipobank *rb, hipo::bank hb) {
     set_nrows(rb, static_cast<luint>(hb.getRows()));
 
     for (luint row = 0; row < rb->nrows; ++row) {
-        for (it = rb->entries.begin(); it != rb->entries.end(); ++it) {
+        for (
+                entry_iterator it = rb->entries.begin();
+                it != rb->entries.end(); ++it
+        ) {
             const char *key = it->first;
             double bank_data = 0;
             switch (rb->entries.at(key).type) {
@@ -169,19 +191,87 @@ int rge_fill(rge_hipobank *rb, hipo::bank hb) {
     return 0;
 }
 
-int rge_get_entries(rge_hipobank *b, TTree *t, int idx) {
+int rge_get_entries(rge_hipobank *b, TTree *t, lint idx) {
     // Get entries from TTree.
-    for (it = b->entries.begin(); it != b->entries.end(); ++it) {
-        const char *key = it->first;
-        b->entries.at(key).branch->GetEntry(t->LoadTree(idx));
+    for (entry_iterator it = b->entries.begin(); it != b->entries.end(); ++it) {
+        TBranch *branch = it->second.branch;
+        if (branch != NULL) branch->GetEntry(t->LoadTree(idx));
     }
 
     // Set nrows.
-    b->nrows = b->entries.begin()->second.data->size();
+    if (b->entries.empty()) b->nrows = 0;
+    else b->nrows = b->entries.begin()->second.data->size();
+    b->batch  = NULL;
+    b->offset = 0;
 
     return 0;
 }
 
+rge_hipobatch rge_hipobatch_init() {
+    rge_hipobatch batch;
+    batch.first   = 0;
+    batch.nevents = 0;
+    batch.offsets = {0};
+    return batch;
+}
+
+int rge_get_batch(
+        rge_hipobank *b, TTree *t, lint first, lint nevents,
+        rge_hipobatch *batch
+) {
+    batch->first   = first;
+    batch->nevents = nevents;
+    batch->offsets.assign(1, 0);
+
+    for (entry_iterator it = b->entries.begin(); it != b->entries.end(); ++it) {
+        const char *key = it->first;
+        std::vector<double> *data   = b->entries.at(key).data;
+        std::vector<double> *column = &(batch->columns[key]);
+        column->clear();
+        TBranch *branch = b->entries.at(key).branch;
+        if (branch == NULL) continue;
+
+        // All entries of a bank have the same number of rows, so offsets are
+        //     taken from the first one read.
+        bool set_offsets = batch->offsets.size() == 1;
+        for (lint idx = first; idx < first + nevents; ++idx) {
+            branch->GetEntry(t->LoadTree(idx));
+            column->insert(column->end(), data->begin(), data->end());
+            if (set_offsets) batch->offsets.push_back(column->size());
+        }
+    }
+
+    // Banks without branches have no rows.
+    batch->offsets.resize(static_cast<luint>(nevents) + 1, 0);
+
+    return 0;
+}
+
+int rge_select_event(rge_hipobank *b, rge_hipobatch *batch, lint idx) {
+    if (idx < batch->first || idx >= batch->first + batch->nevents) {
+        rge_errno = RGEERR_EVENTNOTINBATCH;
+        return 1;
+    }
+    luint pos   = static_cast<luint>(idx - batch->first);
+    luint start = batch->offsets[pos];
+    luint end   = batch->offsets[pos + 1];
+
+    b->batch  = batch;
+    b->offset = start;
+    b->nrows  = end - start;
+
+    return 0;
+}
+
+lint rge_get_zipbytes(rge_hipobank *b) {
+    lint nbytes = 0;
+    for (entry_iterator it = b->entries.begin(); it != b->entries.end(); ++it) {
+        TBranch *branch = it->second.branch;
+        if (branch != NULL) nbytes += branch->GetZipBytes();
+    }
+    return nbytes;
+}
+
 double rge_get_double(rge_hipobank *b, const char *var, luint idx) {
     return get_entry(b, var, idx);
 }
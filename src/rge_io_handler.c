@@ -127,6 +127,56 @@ int rge_process_nentries(lint *nentries, char *arg) {
     return 0;
 }
 
+int rge_process_nthreads(lint *nthreads, char *arg) {
+    int err = run_strtol(nthreads, arg);
+    if (err == 1 || err == 2 || *nthreads <= 0) {
+        rge_errno = RGEERR_INVALIDNTHREADS;
+        return 1;
+    }
+
+    return 0;
+}
+
+int rge_process_nreps(lint *nreps, char *arg) {
+    int err = run_strtol(nreps, arg);
+    if (err == 1 || err == 2 || *nreps <= 0) {
+        rge_errno = RGEERR_INVALIDNREPS;
+        return 1;
+    }
+
+    return 0;
+}
+
+int rge_process_period(lint *period, char *arg) {
+    int err = run_strtol(period, arg);
+    if (err == 1 || err == 2 || *period <= 0) {
+        rge_errno = RGEERR_INVALIDPERIOD;
+        return 1;
+    }
+
+    return 0;
+}
+
+int rge_process_nslow(lint *nslow, char *arg) {
+    int err = run_strtol(nslow, arg);
+    if (err == 1 || err == 2 || *nslow < 0) {
+        rge_errno = RGEERR_INVALIDNSLOW;
+        return 1;
+    }
+
+    return 0;
+}
+
+int rge_process_evn(lint *evn, char *arg) {
+    int err = run_strtol(evn, arg);
+    if (err == 1 || err == 2 || *evn < 0) {
+        rge_errno = RGEERR_INVALIDTRACEOPT;
+        return 1;
+    }
+
+    return 0;
+}
+
 int rge_process_pid(lint *pid, char *arg) {
     int err = run_strtol(pid, arg);
     if (err == 1 || err == 2) {
@@ -150,19 +200,23 @@ int rge_process_fmtnlayers(lint *nlayers, char *arg) {
 }
 
 bool rge_catch_yn() {
-    while (true) {
+    long r = -1;
+    while (rge_dist_rank() == 0 && r == -1) {
         char str[32];
         printf(">>> ");
         scanf_dump = scanf("%31s", str);
 
-        if (!strcmp(str, "y") || !strcmp(str, "Y")) return true;
-        if (!strcmp(str, "n") || !strcmp(str, "N")) return false;
+        if (!strcmp(str, "y") || !strcmp(str, "Y")) r = 1;
+        if (!strcmp(str, "n") || !strcmp(str, "N")) r = 0;
     }
+
+    rge_dist_bcast(&r);
+    return r == 1;
 }
 
 long rge_catch_long() {
-    long r;
-    while (true) {
+    long r = 0;
+    while (rge_dist_rank() == 0) {
         char str[32];
         char *endptr;
         printf(">>> ");
@@ -172,12 +226,13 @@ long rge_catch_long() {
         if (endptr != str) break;
     }
 
+    rge_dist_bcast(&r);
     return r;
 }
 
 double rge_catch_double() {
-    double r;
-    while (true) {
+    double r = 0;
+    while (rge_dist_rank() == 0) {
         char str[32];
         char *endptr;
         printf(">>> ");
@@ -187,12 +242,13 @@ double rge_catch_double() {
         if (endptr != str) break;
     }
 
+    rge_dist_bcast(&r);
     return r;
 }
 
 int rge_catch_string(const char *arr[], int size) {
-    int x;
-    while (true) {
+    long x = -1;
+    while (rge_dist_rank() == 0) {
         char str[32];
         printf(">>> ");
         scanf_dump = scanf("%31s", str);
@@ -201,12 +257,13 @@ int rge_catch_string(const char *arr[], int size) {
         if (x != -1) break;
     }
 
-    return x;
+    rge_dist_bcast(&x);
+    return static_cast<int>(x);
 }
 
 int rge_catch_var(const char *arr[], int size) {
-    long x;
-    while (true) {
+    long x = 0;
+    while (rge_dist_rank() == 0) {
         char str[32];
         char *endptr;
         printf(">>> ");
@@ -216,5 +273,6 @@ int rge_catch_var(const char *arr[], int size) {
         if (endptr != str && 0 <= x && x < size) break;
     }
 
-    return x;
+    rge_dist_bcast(&x);
+    return static_cast<int>(x);
 }
@@ -0,0 +1,131 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#include "../lib/rge_kernels.h"
+
+// rge_particle.h pulls in the HIPO headers, so it is included here rather than
+//     in rge_kernels.h, and the internal functions that use it are kept in
+//     this file.
+#include "../lib/rge_particle.h"
+
+// --+ internal +---------------------------------------------------------------
+/**
+ * Build a particle with momentum (px, py, pz) and mass mass, marked either as
+ *     the trigger electron or as a hadron.
+ */
+static rge_particle kernel_particle(
+        double px, double py, double pz, double mass, bool trigger
+);
+
+rge_particle kernel_particle(
+        double px, double py, double pz, double mass, bool trigger
+) {
+    rge_particle p;
+    p.is_valid   = true;
+    p.is_trigger = trigger;
+    p.is_hadron  = !trigger;
+    p.pid        = trigger ? 11 : 0;
+    p.charge     = trigger ? -1 : 0;
+    p.sector     = 0;
+    p.beta       = 1.;
+    p.vx         = 0.;
+    p.vy         = 0.;
+    p.vz         = 0.;
+    p.px         = px;
+    p.py         = py;
+    p.pz         = pz;
+    p.mass       = mass;
+
+    return p;
+}
+
+// --+ library +----------------------------------------------------------------
+int rge_kernel_pid(
+        int charge, int recon_pid, int status, double beta, double px,
+        double py, double pz, double total_energy, double pcal_energy,
+        int htcc_nphe, int ltcc_nphe,
+        const double sf_params[RGE_NSFPARAMS][2]
+) {
+    rge_particle p = kernel_particle(px, py, pz, 0., false);
+    p.is_hadron = false;
+    p.pid       = 0;
+    p.charge    = charge;
+    p.beta      = beta;
+
+    // rge_set_pid() doesn't modify the parameters, but takes them as mutable.
+    double pars[RGE_NSFPARAMS][2];
+    for (int pi = 0; pi < RGE_NSFPARAMS; ++pi) {
+        pars[pi][0] = sf_params[pi][0];
+        pars[pi][1] = sf_params[pi][1];
+    }
+
+    if (rge_set_pid(
+            &p, recon_pid, status, total_energy, pcal_energy, htcc_nphe,
+            ltcc_nphe, pars
+    )) return 0;
+
+    return p.pid;
+}
+
+rge_dis rge_kernel_dis(double beam_E, double px, double py, double pz) {
+    rge_particle e = kernel_particle(px, py, pz, 0., true);
+    Float_t arr[RGE_VARS_SIZE] = {};
+    rge_calc_kinematics_arr(arr, e, e, beam_E);
+
+    rge_dis dis;
+    dis.Q2 = arr[RGE_Q2.addr];
+    dis.nu = arr[RGE_NU.addr];
+    dis.Xb = arr[RGE_XB.addr];
+    dis.Yb = arr[RGE_YB.addr];
+    dis.W2 = arr[RGE_W2.addr];
+
+    return dis;
+}
+
+rge_sidis rge_kernel_sidis(
+        double beam_E, double e_px, double e_py, double e_pz, double mass,
+        double px, double py, double pz
+) {
+    rge_particle e = kernel_particle(e_px, e_py, e_pz, 0., true);
+    rge_particle p = kernel_particle(px, py, pz, mass, false);
+    Float_t arr[RGE_VARS_SIZE] = {};
+    rge_calc_kinematics_arr(arr, p, e, beam_E);
+
+    rge_sidis sidis;
+    sidis.zh      = arr[RGE_ZH.addr];
+    sidis.Pt2     = arr[RGE_PT2.addr];
+    sidis.Pl2     = arr[RGE_PL2.addr];
+    sidis.phiPQ   = arr[RGE_PHIPQ.addr];
+    sidis.thetaPQ = arr[RGE_THETAPQ.addr];
+
+    return sidis;
+}
+
+bool rge_kernel_dis_cut(double Q2, double W2, double Yb) {
+    return Q2 >= RGE_Q2CUT && W2 >= RGE_W2CUT && Yb <= RGE_YBCUT;
+}
+
+bool rge_kernel_geometry_cut(double vx, double vy, double vz) {
+    return rge_calc_magnitude(vx, vy) <= RGE_VXVYCUT &&
+            RGE_VZLOWCUT <= vz && vz <= RGE_VZHIGHCUT;
+}
+
+bool rge_kernel_general_cut(double pid, double chi2, double ndf) {
+    // Non-identified particles.
+    if (-0.5 <= pid && pid <  0.5) return false;
+    if (44.5 <= pid && pid < 45.5) return false;
+    // Tracks with high chi2.
+    return chi2/ndf < RGE_CHI2NDFCUT;
+}
@@ -0,0 +1,224 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#include "../lib/rge_latency.h"
+
+// --+ internal +---------------------------------------------------------------
+bool slower(const rge_slowevent &a, const rge_slowevent &b) {
+    return a.time > b.time;
+}
+
+uint find_bin(double t) {
+    if (t < LATENCY_MINTIME) return 0;
+    double b = 1 + floor(log10(t/LATENCY_MINTIME) * RGE_LATENCYBINSPERDECADE);
+    if (b > RGE_LATENCYNBINS - 1) return RGE_LATENCYNBINS - 1;
+    return static_cast<uint>(b);
+}
+
+double bin_low_edge(uint b) {
+    if (b == 0) return 0.;
+    return LATENCY_MINTIME * pow(
+            10., static_cast<double>(b - 1) / RGE_LATENCYBINSPERDECADE
+    );
+}
+
+int push_event(rge_latency *lat, rge_slowevent ev) {
+    if (lat->k == 0) return 0;
+
+    // Heap is not full yet.
+    if (lat->slowest.size() < lat->k) {
+        lat->slowest.push_back(ev);
+        std::push_heap(lat->slowest.begin(), lat->slowest.end(), slower);
+        return 0;
+    }
+
+    // Replace the fastest of the slowest events if ev is slower.
+    if (ev.time <= lat->slowest.front().time) return 0;
+    std::pop_heap(lat->slowest.begin(), lat->slowest.end(), slower);
+    lat->slowest.back() = ev;
+    std::push_heap(lat->slowest.begin(), lat->slowest.end(), slower);
+
+    return 0;
+}
+
+// --+ library +----------------------------------------------------------------
+rge_latency rge_latency_init(luint k) {
+    rge_latency lat;
+    lat.k          = k;
+    lat.nevents    = 0;
+    lat.total_time = 0.;
+    for (uint b = 0; b < RGE_LATENCYNBINS; ++b) lat.counts[b] = 0;
+    lat.slowest.reserve(k);
+
+    return lat;
+}
+
+int rge_latency_record(
+        rge_latency *lat, double time, lint evn,
+        luint nrows[RGE_LATENCYNBANKS]
+) {
+    ++(lat->nevents);
+    lat->total_time += time;
+    ++(lat->counts[find_bin(time)]);
+
+    // Only build the event if it would enter the heap.
+    if (lat->k == 0) return 0;
+    if (lat->slowest.size() == lat->k && time <= lat->slowest.front().time) {
+        return 0;
+    }
+
+    rge_slowevent ev;
+    ev.time = time;
+    ev.evn  = evn;
+    for (uint bi = 0; bi < RGE_LATENCYNBANKS; ++bi) ev.nrows[bi] = nrows[bi];
+
+    return push_event(lat, ev);
+}
+
+int rge_latency_merge(rge_latency *dst, rge_latency *src) {
+    dst->nevents    += src->nevents;
+    dst->total_time += src->total_time;
+    for (uint b = 0; b < RGE_LATENCYNBINS; ++b) {
+        dst->counts[b] += src->counts[b];
+    }
+    for (luint ei = 0; ei < src->slowest.size(); ++ei) {
+        push_event(dst, src->slowest[ei]);
+    }
+
+    return 0;
+}
+
+int rge_latency_reduce(rge_latency *lat) {
+    luint nranks = static_cast<luint>(rge_dist_size());
+    if (nranks == 1) return 0;
+
+    // Add histograms at rank 0.
+    lint sums[RGE_LATENCYNBINS + 1];
+    for (uint b = 0; b < RGE_LATENCYNBINS; ++b) sums[b] = lat->counts[b];
+    sums[RGE_LATENCYNBINS] = lat->nevents;
+    rge_dist_reduce_sum(sums, RGE_LATENCYNBINS + 1);
+    double total_time = lat->total_time;
+    rge_dist_reduce_sum(&total_time, 1);
+    for (uint b = 0; b < RGE_LATENCYNBINS; ++b) lat->counts[b] = sums[b];
+    lat->nevents    = sums[RGE_LATENCYNBINS];
+    lat->total_time = total_time;
+
+    // Gather the slowest events of all ranks. Empty slots have a negative time.
+    if (lat->k == 0) return 0;
+    std::vector<double> send(lat->k * LATENCY_PACKSIZE, -1.);
+    for (luint ei = 0; ei < lat->slowest.size(); ++ei) {
+        double *pack = &(send[ei * LATENCY_PACKSIZE]);
+        pack[0] = lat->slowest[ei].time;
+        pack[1] = static_cast<double>(lat->slowest[ei].evn);
+        for (uint bi = 0; bi < RGE_LATENCYNBANKS; ++bi) {
+            pack[2 + bi] = static_cast<double>(lat->slowest[ei].nrows[bi]);
+        }
+    }
+    std::vector<double> recv(send.size() * nranks);
+    rge_dist_allgather(send.data(), send.size(), recv.data());
+
+    lat->slowest.clear();
+    for (luint ei = 0; ei < lat->k * nranks; ++ei) {
+        double *pack = &(recv[ei * LATENCY_PACKSIZE]);
+        if (pack[0] < 0) continue;
+
+        rge_slowevent ev;
+        ev.time = pack[0];
+        ev.evn  = static_cast<lint>(pack[1]);
+        for (uint bi = 0; bi < RGE_LATENCYNBANKS; ++bi) {
+            ev.nrows[bi] = static_cast<luint>(pack[2 + bi]);
+        }
+        push_event(lat, ev);
+    }
+
+    return 0;
+}
+
+int rge_latency_print(
+        rge_latency *lat, const char *bank_names[RGE_LATENCYNBANKS]
+) {
+    if (lat->nevents == 0) return 0;
+
+    printf(
+            "Per-event processing time, %ld events (mean %.1f us):\n",
+            lat->nevents, 1e6 * lat->total_time / lat->nevents
+    );
+
+    // Percentiles, given as the upper edge of the bin where they fall.
+    const double quantiles[4] = {.5, .9, .99, .999};
+    uint qi = 0;
+    lint cumulative = 0;
+    printf("   ");
+    for (uint b = 0; b < RGE_LATENCYNBINS && qi < 4; ++b) {
+        cumulative += lat->counts[b];
+        for (; qi < 4 && cumulative >= quantiles[qi] * lat->nevents; ++qi) {
+            if (b == RGE_LATENCYNBINS - 1) {
+                printf(
+                        " p%g > %.0f us", 100*quantiles[qi],
+                        1e6*bin_low_edge(b)
+                );
+            }
+            else {
+                printf(
+                        " p%g < %.1f us", 100*quantiles[qi],
+                        1e6*bin_low_edge(b+1)
+                );
+            }
+            if (qi < 3) printf(",");
+        }
+    }
+    printf("\n");
+
+    // Histogram.
+    printf("    %-26s %12s\n", "time (us)", "events");
+    for (uint b = 0; b < RGE_LATENCYNBINS; ++b) {
+        if (lat->counts[b] == 0) continue;
+        if (b == RGE_LATENCYNBINS - 1) {
+            printf(
+                    "    [%11.1f,         inf) %12ld\n", 1e6*bin_low_edge(b),
+                    lat->counts[b]
+            );
+        }
+        else {
+            printf(
+                    "    [%11.1f, %11.1f) %12ld\n", 1e6*bin_low_edge(b),
+                    1e6*bin_low_edge(b+1), lat->counts[b]
+            );
+        }
+    }
+    printf("\n");
+
+    // Slowest events, from slowest to fastest.
+    if (lat->slowest.size() == 0) return 0;
+    std::vector<rge_slowevent> sorted(lat->slowest);
+    std::sort(sorted.begin(), sorted.end(), slower);
+
+    printf("Slowest %lu events:\n", sorted.size());
+    printf("    %12s %12s", "event", "time (ms)");
+    for (uint bi = 0; bi < RGE_LATENCYNBANKS; ++bi) {
+        printf(" %18s", bank_names[bi]);
+    }
+    printf("\n");
+    for (luint ei = 0; ei < sorted.size(); ++ei) {
+        printf("    %12ld %12.3f", sorted[ei].evn, 1e3*sorted[ei].time);
+        for (uint bi = 0; bi < RGE_LATENCYNBANKS; ++bi) {
+            printf(" %18lu", sorted[ei].nrows[bi]);
+        }
+        printf("\n");
+    }
+    printf("\n");
+
+    return 0;
+}
@@ -57,3 +57,100 @@ void rge_rotate_z(double *x, double *y, double th) {
     *x = x_prev*cos(th) - y_prev*sin(th);
     *y = x_prev*sin(th) + y_prev*cos(th);
 }
+
+int rge_find_pos(double v, double *b, int size) {
+    for (int i = 0; i < size; ++i) if (b[i] < v && v < b[i+1]) return i;
+    return -1;
+}
+
+lint rge_find_idx(
+        luint dim_bins, luint depth, float var[], luint nbins[],
+        double range[][2], double binsize[]
+) {
+    if (depth == dim_bins) return 0;
+    for (luint bi = 0; bi < nbins[depth]; ++bi) {
+        // Define bin limits.
+        double low  = range[depth][0] + binsize[depth]* bi;
+        double high = range[depth][0] + binsize[depth]*(bi+1);
+
+        // Find bin for var.
+        if (low < var[depth] && var[depth] < high) {
+            luint dim_factor = 1;
+            for (luint depth_i = depth + 1; depth_i < dim_bins; ++depth_i) {
+                dim_factor *= nbins[depth_i];
+            }
+            lint idx =
+                    rge_find_idx(dim_bins, depth+1, var, nbins, range, binsize);
+            if (idx < 0) return idx;
+            else return static_cast<lint>(
+                    bi*dim_factor + static_cast<luint>(idx)
+            );
+        }
+    }
+
+    return -1; // Variable is not within binning range.
+}
+
+int rge_fit_cos_modulation(
+        luint nbins, const double edges[], const double y[],
+        const double err[], double par[3], double cov[3][3], double *chi2,
+        luint *ndf
+) {
+    // Accumulate normal equations. f[k] is the average of cos(k phi) over the
+    //     bin, which tends to its value at the bin center for narrow bins.
+    double m[3][3] = {{0., 0., 0.}, {0., 0., 0.}, {0., 0., 0.}};
+    double v[3]    = {0., 0., 0.};
+    luint npoints  = 0;
+    for (luint bin_i = 0; bin_i < nbins; ++bin_i) {
+        if (err[bin_i] <= 0) continue;
+        double lo = edges[bin_i];
+        double hi = edges[bin_i+1];
+        double f[3] = {
+                1.,
+                (sin(hi) - sin(lo)) / (hi - lo),
+                (sin(2*hi) - sin(2*lo)) / (2*(hi - lo))
+        };
+        double w = 1. / (err[bin_i]*err[bin_i]);
+        for (int i = 0; i < 3; ++i) {
+            v[i] += w * f[i] * y[bin_i];
+            for (int j = 0; j < 3; ++j) m[i][j] += w * f[i] * f[j];
+        }
+        ++npoints;
+    }
+    if (npoints < 3) return 1;
+
+    // Invert the normal matrix through its cofactors. The inverse is the
+    //     covariance matrix of the parameters.
+    double det =
+            m[0][0] * (m[1][1]*m[2][2] - m[1][2]*m[2][1]) -
+            m[0][1] * (m[1][0]*m[2][2] - m[1][2]*m[2][0]) +
+            m[0][2] * (m[1][0]*m[2][1] - m[1][1]*m[2][0]);
+    if (fabs(det) <= 1e-12 * fabs(m[0][0]*m[1][1]*m[2][2])) return 1;
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            int i1 = (j+1)%3, i2 = (j+2)%3;
+            int j1 = (i+1)%3, j2 = (i+2)%3;
+            cov[i][j] = (m[i1][j1]*m[i2][j2] - m[i1][j2]*m[i2][j1]) / det;
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        par[i] = cov[i][0]*v[0] + cov[i][1]*v[1] + cov[i][2]*v[2];
+    }
+
+    // Compute chi2.
+    *chi2 = 0;
+    for (luint bin_i = 0; bin_i < nbins; ++bin_i) {
+        if (err[bin_i] <= 0) continue;
+        double lo = edges[bin_i];
+        double hi = edges[bin_i+1];
+        double model = par[0] +
+                par[1] * (sin(hi) - sin(lo)) / (hi - lo) +
+                par[2] * (sin(2*hi) - sin(2*lo)) / (2*(hi - lo));
+        double pull = (y[bin_i] - model) / err[bin_i];
+        *chi2 += pull*pull;
+    }
+    *ndf = npoints - 3;
+
+    return 0;
+}
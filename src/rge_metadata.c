@@ -0,0 +1,241 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#include "../lib/rge_metadata.h"
+
+// --+ internal +---------------------------------------------------------------
+TDirectory *get_metadir(TFile *f, bool create) {
+    TDirectory *dir = f->GetDirectory(RGE_METADIR);
+    if (dir == NULL && create) dir = f->mkdir(RGE_METADIR);
+    return dir;
+}
+
+// --+ library +----------------------------------------------------------------
+int rge_write_runlist(TFile *f, std::set<int> *runs) {
+    TVectorD runs_vec(static_cast<int>(runs->size()));
+    int run_i = 0;
+    for (int run_no : *runs) runs_vec[run_i++] = run_no;
+
+    get_metadir(f, true)->WriteTObject(&runs_vec, RGE_METARUNS, "WriteDelete");
+    return 0;
+}
+
+int rge_read_runlist(TFile *f, std::set<int> *runs) {
+    TDirectory *dir = get_metadir(f, false);
+    if (dir == NULL) return 0;
+
+    TVectorD *runs_vec = dir->Get<TVectorD>(RGE_METARUNS);
+    if (runs_vec == NULL) return 0;
+
+    for (int run_i = 0; run_i < runs_vec->GetNrows(); ++run_i) {
+        runs->insert(static_cast<int>((*runs_vec)[run_i] + .5));
+    }
+    delete runs_vec;
+
+    return 0;
+}
+
+int rge_write_sf_params(
+        TFile *f, int run_no, double sf[RGE_NSECTORS][RGE_NSFPARAMS][2]
+) {
+    TVectorD sf_vec(RGE_NSECTORS * RGE_NSFPARAMS * 2);
+    int sf_i = 0;
+    for (int sector_i = 0; sector_i < RGE_NSECTORS; ++sector_i) {
+        for (int param_i = 0; param_i < RGE_NSFPARAMS; ++param_i) {
+            for (int edge_i = 0; edge_i < 2; ++edge_i) {
+                sf_vec[sf_i++] = sf[sector_i][param_i][edge_i];
+            }
+        }
+    }
+
+    get_metadir(f, true)->WriteTObject(
+            &sf_vec, Form("%s_%06d", RGE_METASF, run_no), "WriteDelete"
+    );
+    return 0;
+}
+
+int rge_write_cutflow(
+        TFile *f, uint size, const char *labels[], luint counts[]
+) {
+    TH1D cutflow(RGE_METACUTFLOW, RGE_METACUTFLOW, static_cast<int>(size), 0,
+            size);
+    cutflow.SetDirectory(NULL);
+    for (uint cnt_i = 0; cnt_i < size; ++cnt_i) {
+        int bin = static_cast<int>(cnt_i) + 1;
+        cutflow.GetXaxis()->SetBinLabel(bin, labels[cnt_i]);
+        cutflow.SetBinContent(bin, static_cast<double>(counts[cnt_i]));
+    }
+
+    get_metadir(f, true)->WriteTObject(
+            &cutflow, RGE_METACUTFLOW, "WriteDelete"
+    );
+    return 0;
+}
+
+int rge_write_dis_skim(TFile *f) {
+    TVectorD cuts(3);
+    cuts[0] = RGE_Q2CUT;
+    cuts[1] = RGE_W2CUT;
+    cuts[2] = RGE_YBCUT;
+
+    get_metadir(f, true)->WriteTObject(&cuts, RGE_METADIS, "WriteDelete");
+    return 0;
+}
+
+bool rge_read_dis_skim(TFile *f) {
+    TDirectory *dir = get_metadir(f, false);
+    if (dir == NULL) return false;
+
+    TVectorD *cuts = dir->Get<TVectorD>(RGE_METADIS);
+    if (cuts == NULL) return false;
+
+    bool skimmed = cuts->GetNrows() == 3 &&
+            (*cuts)[0] == RGE_Q2CUT && (*cuts)[1] == RGE_W2CUT &&
+            (*cuts)[2] == RGE_YBCUT;
+    delete cuts;
+
+    return skimmed;
+}
+
+int rge_remove_dis_skim(TFile *f) {
+    TDirectory *dir = get_metadir(f, false);
+    if (dir != NULL) dir->Delete(RGE_METADIS ";*");
+
+    return 0;
+}
+
+int rge_attach_kinematics(TFile *f, TTree *t) {
+    if (t->GetFriend(RGE_TREENAMEKIN) != NULL) return 0;
+
+    // Files written before the split keep the kinematics in the data tree.
+    TTree *kin = f->Get<TTree>(RGE_TREENAMEKIN);
+    if (kin == NULL && t->GetBranch(RGE_VARS[RGE_Q2.addr]) != NULL) return 0;
+    if (kin == NULL || kin->GetEntries() != t->GetEntries()) {
+        rge_errno = RGEERR_BADKINTREE;
+        return 1;
+    }
+    t->AddFriend(kin);
+
+    return 0;
+}
+
+int rge_merge_metadata(TFile *f_out, int nfiles, char **filenames) {
+    std::set<int> runs;
+    std::map<std::string, TObject *> objs;
+    int nskimmed = 0;
+
+    for (int file_i = 0; file_i < nfiles; ++file_i) {
+        TFile *f_in = TFile::Open(filenames[file_i], "READ");
+        if (!f_in || f_in->IsZombie()) {
+            rge_errno = RGEERR_BADINPUTFILE;
+            return 1;
+        }
+
+        TDirectory *dir = get_metadir(f_in, false);
+        if (dir == NULL) {
+            f_in->Close();
+            continue;
+        }
+
+        // Go through all metadata objects.
+        TIter next(dir->GetListOfKeys());
+        TKey *key;
+        while ((key = static_cast<TKey *>(next()))) {
+            const char *name = key->GetName();
+
+            // Runs lists are joined.
+            if (!strcmp(name, RGE_METARUNS)) continue;
+
+            // DIS skim records are checked and counted below.
+            if (!strcmp(name, RGE_METADIS)) continue;
+
+            TObject *obj = key->ReadObj();
+            if (objs.count(name) == 0) {
+                // First instance of this object.
+                if (obj->InheritsFrom(TH1::Class())) {
+                    static_cast<TH1 *>(obj)->SetDirectory(NULL);
+                }
+                objs[name] = obj;
+            }
+            else if (obj->InheritsFrom(TH1::Class())) {
+                // Histograms are added.
+                static_cast<TH1 *>(objs[name])->Add(static_cast<TH1 *>(obj));
+                delete obj;
+            }
+            else {
+                // For anything else, the first instance is kept.
+                delete obj;
+            }
+        }
+        rge_read_runlist(f_in, &runs);
+        if (rge_read_dis_skim(f_in)) ++nskimmed;
+
+        f_in->Close();
+    }
+
+    // Write merged metadata.
+    if (!runs.empty()) rge_write_runlist(f_out, &runs);
+    if (nfiles > 0 && nskimmed == nfiles) rge_write_dis_skim(f_out);
+    if (!objs.empty()) {
+        TDirectory *dir = get_metadir(f_out, true);
+        for (auto const &obj : objs) {
+            dir->WriteTObject(obj.second, obj.first.c_str(), "WriteDelete");
+            delete obj.second;
+        }
+    }
+
+    return 0;
+}
+
+int rge_merge_files(
+        char **filenames, int nfiles, const char *out_filename, bool merge_meta
+) {
+    {
+        TFileMerger merger(false);
+        merger.SetPrintLevel(0);
+        if (!merger.OutputFile(out_filename, "RECREATE")) {
+            rge_errno = RGEERR_MERGEFAILED;
+            return 1;
+        }
+        merger.AddObjectNames(RGE_METADIR);
+
+        for (int file_i = 0; file_i < nfiles; ++file_i) {
+            if (!merger.AddFile(filenames[file_i], false)) {
+                rge_errno = RGEERR_MERGEFAILED;
+                return 1;
+            }
+        }
+
+        if (!merger.PartialMerge(
+                TFileMerger::kAll | TFileMerger::kRegular |
+                TFileMerger::kKeepCompression | TFileMerger::kSkipListed
+        )) {
+            rge_errno = RGEERR_MERGEFAILED;
+            return 1;
+        }
+    }
+    if (!merge_meta) return 0;
+
+    // Merge metadata.
+    TFile *f_out = TFile::Open(out_filename, "UPDATE");
+    if (!f_out || f_out->IsZombie()) {
+        rge_errno = RGEERR_OUTPUTROOTFAILED;
+        return 1;
+    }
+    if (rge_merge_metadata(f_out, nfiles, filenames)) return 1;
+    f_out->Close();
+
+    return 0;
+}
@@ -0,0 +1,61 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#include "../lib/rge_moments.h"
+
+// --+ library +----------------------------------------------------------------
+rge_moments rge_moments_init() {
+    rge_moments m;
+    m.n    = 0;
+    m.mean = 0.;
+    m.m2   = 0.;
+    return m;
+}
+
+int rge_moments_add(rge_moments *m, double x) {
+    ++(m->n);
+    double delta = x - m->mean;
+    m->mean += delta / static_cast<double>(m->n);
+    m->m2   += delta * (x - m->mean);
+    return 0;
+}
+
+int rge_moments_merge(rge_moments *dst, const rge_moments *src) {
+    if (src->n == 0) return 0;
+    if (dst->n == 0) {
+        *dst = *src;
+        return 0;
+    }
+
+    double n_a   = static_cast<double>(dst->n);
+    double n_b   = static_cast<double>(src->n);
+    double n     = n_a + n_b;
+    double delta = src->mean - dst->mean;
+
+    dst->n    += src->n;
+    dst->mean += delta * n_b / n;
+    dst->m2   += src->m2 + delta*delta * n_a * n_b / n;
+    return 0;
+}
+
+double rge_moments_variance(const rge_moments *m) {
+    if (m->n < 2) return 0.;
+    return m->m2 / static_cast<double>(m->n - 1);
+}
+
+double rge_moments_mean_err(const rge_moments *m) {
+    if (m->n < 2) return 0.;
+    return sqrt(rge_moments_variance(m) / static_cast<double>(m->n));
+}
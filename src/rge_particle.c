@@ -111,6 +111,21 @@ int match_pid(
     return 0;
 }
 
+rge_particle pair_init(rge_particle g1, rge_particle g2) {
+    rge_particle p = particle_init(
+            0, 1., g1.sector, g1.vx, g1.vy, g1.vz,
+            g1.px + g2.px, g1.py + g2.py, g1.pz + g2.pz
+    );
+
+    // Photons are massless, so the pair's energy is the sum of momenta.
+    double energy = momentum(g1) + momentum(g2);
+    p.pid       = 111;
+    p.is_hadron = true;
+    p.mass      = sqrt(fabs(energy*energy - pow(momentum(p), 2)));
+
+    return p;
+}
+
 double theta_lab(rge_particle p) {
     if (abs(p.px) + abs(p.py) + abs(p.pz) < 1e-9) return 0;
     return atan2(sqrt(p.px*p.px + p.py*p.py), p.pz);
@@ -250,6 +265,29 @@ rge_particle rge_particle_init(
     );
 }
 
+rge_particle rge_photon_init(
+        rge_hipobank *particle, uint pindex, double total_energy
+) {
+    if (rge_get_int(particle, "charge", pindex) != 0) return particle_init();
+
+    double beta = rge_get_double(particle, "beta", pindex);
+    if (assign_neutral_pid(total_energy, beta) != 22) return particle_init();
+
+    rge_particle p = particle_init(
+            0, beta, 0,
+            rge_get_double(particle, "vx", pindex),
+            rge_get_double(particle, "vy", pindex),
+            rge_get_double(particle, "vz", pindex),
+            rge_get_double(particle, "px", pindex),
+            rge_get_double(particle, "py", pindex),
+            rge_get_double(particle, "pz", pindex)
+    );
+    p.pid  = 22;
+    p.mass = 0.;
+
+    return p;
+}
+
 int rge_set_pid(
         rge_particle *particle, int recon_pid, int status, double total_energy,
         double pcal_energy, int htcc_nphe, int ltcc_nphe,
@@ -297,7 +335,7 @@ int rge_set_pid(
 }
 
 int rge_fill_ntuples_arr(
-        Float_t *arr, rge_particle p, rge_particle e, int run_no, int evn,
+        Float_t *arr, rge_particle p, rge_particle e, int run_no, lint evn,
         int status, double beam_E, float chi2, float ndf, double pcal_energy,
         double ecin_E, double ecou_E, double tof, double tre_tof, int nphe_ltcc,
         int nphe_htcc
@@ -305,7 +343,6 @@ int rge_fill_ntuples_arr(
     // Metadata.
     arr[RGE_RUNNO.addr]   = static_cast<Float_t>(run_no);
     arr[RGE_EVENTNO.addr] = static_cast<Float_t>(evn);
-    arr[RGE_BEAME.addr]   = beam_E;
 
     // Particle.
     arr[RGE_PID.addr]    = static_cast<Float_t>(p.pid);
@@ -340,13 +377,29 @@ int rge_fill_ntuples_arr(
     arr[RGE_NPHELTCC.addr] = nphe_ltcc;
     arr[RGE_NPHEHTCC.addr] = nphe_htcc;
 
+    return rge_fill_kinematics_arr(arr, p, e, beam_E);
+}
+
+int rge_fill_kinematics_arr(
+        Float_t *arr, rge_particle p, rge_particle e, double beam_E
+) {
+    rge_calc_kinematics_arr(arr, p, e, beam_E);
+    if (rge_errno == RGEERR_PIDNOTFOUND) return 1;
+
+    return 0;
+}
+
+int rge_calc_kinematics_arr(
+        Float_t *arr, rge_particle p, rge_particle e, double beam_E
+) {
+    arr[RGE_BEAME.addr] = beam_E;
+
     // DIS -- For hadrons, just use e- data.
     arr[RGE_Q2.addr] = Q2(e, beam_E);
     arr[RGE_NU.addr] = nu(e, beam_E);
     arr[RGE_XB.addr] = Xb(e, beam_E);
     arr[RGE_YB.addr] = Yb(e, beam_E);
     arr[RGE_W2.addr] = W2(e, beam_E);
-    if (rge_errno == RGEERR_PIDNOTFOUND) return 1;
 
     // SIDIS -- if p is trigger electron, all will be 0 by default.
     arr[RGE_ZH.addr]      = zh(p, e, beam_E);
@@ -357,3 +410,60 @@ int rge_fill_ntuples_arr(
 
     return 0;
 }
+
+rge_particle rge_ntuples_particle_init(Float_t *arr, bool is_trigger) {
+    rge_particle p = particle_init(
+            static_cast<int>(arr[RGE_CHARGE.addr]), arr[RGE_BETA.addr], 0,
+            arr[RGE_VX.addr], arr[RGE_VY.addr], arr[RGE_VZ.addr],
+            arr[RGE_PX.addr], arr[RGE_PY.addr], arr[RGE_PZ.addr]
+    );
+    p.pid        = static_cast<int>(arr[RGE_PID.addr]);
+    p.mass       = arr[RGE_MASS.addr];
+    p.is_trigger = is_trigger;
+    p.is_hadron  = p.pid >= 100 || p.pid <= -100;
+
+    return p;
+}
+
+int rge_fill_pi0_arr(
+        Float_t *arr, rge_particle g1, rge_particle g2, rge_particle e,
+        int run_no, lint evn, double beam_E
+) {
+    rge_particle p = pair_init(g1, g2);
+
+    // Metadata.
+    arr[RGE_PI0_RUNNO.addr]   = static_cast<Float_t>(run_no);
+    arr[RGE_PI0_EVENTNO.addr] = static_cast<Float_t>(evn);
+    arr[RGE_PI0_BEAME.addr]   = beam_E;
+
+    // Diphoton.
+    arr[RGE_PI0_E1.addr]    = momentum(g1);
+    arr[RGE_PI0_E2.addr]    = momentum(g2);
+    arr[RGE_PI0_OPENA.addr] = rge_calc_angle(
+            g1.px, g1.py, g1.pz, g2.px, g2.py, g2.pz
+    );
+    arr[RGE_PI0_MGG.addr]   = p.mass;
+    arr[RGE_PI0_PX.addr]    = p.px;
+    arr[RGE_PI0_PY.addr]    = p.py;
+    arr[RGE_PI0_PZ.addr]    = p.pz;
+    arr[RGE_PI0_P.addr]     = momentum(p);
+    arr[RGE_PI0_THETA.addr] = theta_lab(p);
+    arr[RGE_PI0_PHI.addr]   = phi_lab(p);
+
+    // DIS.
+    arr[RGE_PI0_Q2.addr] = Q2(e, beam_E);
+    arr[RGE_PI0_NU.addr] = nu(e, beam_E);
+    arr[RGE_PI0_XB.addr] = Xb(e, beam_E);
+    arr[RGE_PI0_YB.addr] = Yb(e, beam_E);
+    arr[RGE_PI0_W2.addr] = W2(e, beam_E);
+    if (rge_errno == RGEERR_PIDNOTFOUND) return 1;
+
+    // SIDIS.
+    arr[RGE_PI0_ZH.addr]      = zh(p, e, beam_E);
+    arr[RGE_PI0_PT2.addr]     = Pt2(p, e, beam_E);
+    arr[RGE_PI0_PL2.addr]     = Pl2(p, e, beam_E);
+    arr[RGE_PI0_PHIPQ.addr]   = phi_pq(p, e, beam_E);
+    arr[RGE_PI0_THETAPQ.addr] = theta_pq(p, e, beam_E);
+
+    return 0;
+}
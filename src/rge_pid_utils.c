@@ -81,7 +81,10 @@ int rge_get_pidlist_size_by_charge(int charge, uint *size) {
 
 int rge_get_pidlist_by_charge(int charge, int pidlist[]) {
     uint counter = 0;
-    for (pid_it = PID_MAP.begin(); pid_it != PID_MAP.end(); ++pid_it) {
+    for (
+            pid_iterator pid_it = PID_MAP.begin(); pid_it != PID_MAP.end();
+            ++pid_it
+    ) {
         if (
                 (charge == 0 && pid_it->second.charge == 0) || // both neutral.
                 (charge * pid_it->second.charge > 0)           // equal signs.
@@ -95,7 +98,10 @@ int rge_get_pidlist_by_charge(int charge, int pidlist[]) {
 }
 
 int rge_print_pid_names() {
-    for (pid_it = PID_MAP.begin(); pid_it != PID_MAP.end(); ++pid_it) {
+    for (
+            pid_iterator pid_it = PID_MAP.begin(); pid_it != PID_MAP.end();
+            ++pid_it
+    ) {
         printf("  * %5d (%s).\n", pid_it->first, pid_it->second.name);
     }
 
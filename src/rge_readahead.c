@@ -0,0 +1,159 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#include "../lib/rge_readahead.h"
+
+// --+ internal +---------------------------------------------------------------
+lint wait_limit(rge_readahead *ra, lint next) {
+    std::unique_lock<std::mutex> lk(ra->lock);
+    while (!ra->stop && next >= ra->pos + ra->window) {
+        ra->cv.wait_for(lk, READAHEAD_WAIT);
+    }
+    lint limit = ra->pos + ra->window;
+    return limit < ra->size ? limit : ra->size;
+}
+
+int run_pread(rge_readahead *ra) {
+    lint next = 0;
+    while (!ra->stop && next < ra->size) {
+        lint limit = wait_limit(ra, next);
+        while (!ra->stop && next < limit) {
+            lint len = limit - next < RGE_READAHEADCHUNK ?
+                    limit - next : RGE_READAHEADCHUNK;
+            ssize_t nread = pread(
+                    ra->fd, ra->buf.data(), static_cast<size_t>(len), next
+            );
+            if (nread <= 0) return 0; // Leave errors to the reader.
+            next        += nread;
+            ra->nbytes  += nread;
+        }
+    }
+    return 0;
+}
+
+#ifdef RGE_URING
+int run_uring(rge_readahead *ra) {
+    struct io_uring ring;
+    if (io_uring_queue_init(RGE_READAHEADDEPTH, &ring, 0) < 0) return 1;
+    ra->uring = true;
+
+    // Buffer slots not used by a read in flight.
+    std::vector<uint> free_slots;
+    for (uint slot = 0; slot < RGE_READAHEADDEPTH; ++slot) {
+        free_slots.push_back(slot);
+    }
+
+    lint next    = 0;
+    uint nflight = 0;
+    bool failed  = false;
+    while (!ra->stop && !failed && (next < ra->size || nflight > 0)) {
+        // Fill the queue up to the window.
+        lint limit = nflight == 0 ? wait_limit(ra, next) : ra->pos + ra->window;
+        if (limit > ra->size) limit = ra->size;
+        uint nqueued = 0;
+        while (!ra->stop && next < limit && !free_slots.empty()) {
+            struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+            if (sqe == NULL) break;
+
+            uint slot = free_slots.back();
+            free_slots.pop_back();
+            lint len = limit - next < RGE_READAHEADCHUNK ?
+                    limit - next : RGE_READAHEADCHUNK;
+            io_uring_prep_read(
+                    sqe, ra->fd, &(ra->buf[slot * RGE_READAHEADCHUNK]),
+                    static_cast<uint>(len), static_cast<__u64>(next)
+            );
+            io_uring_sqe_set_data64(sqe, slot);
+            next += len;
+            ++nqueued;
+        }
+        if (nqueued > 0) io_uring_submit(&ring);
+        nflight += nqueued;
+        if (nflight == 0) continue;
+
+        // Reap one completion. Short reads are not retried, since the reader
+        //     reads the file anyway.
+        struct io_uring_cqe *cqe;
+        if (io_uring_wait_cqe(&ring, &cqe) < 0) break;
+        if (cqe->res < 0) failed = true;
+        else ra->nbytes += cqe->res;
+        free_slots.push_back(static_cast<uint>(io_uring_cqe_get_data64(cqe)));
+        io_uring_cqe_seen(&ring, cqe);
+        --nflight;
+    }
+
+    // Drain reads in flight before their buffers are freed.
+    while (nflight > 0) {
+        struct io_uring_cqe *cqe;
+        if (io_uring_wait_cqe(&ring, &cqe) < 0) break;
+        io_uring_cqe_seen(&ring, cqe);
+        --nflight;
+    }
+    io_uring_queue_exit(&ring);
+
+    return 0;
+}
+#endif
+
+int run_readahead(rge_readahead *ra) {
+#ifdef RGE_URING
+    if (run_uring(ra) == 0) return 0;
+#endif
+    return run_pread(ra);
+}
+
+// --+ library +----------------------------------------------------------------
+int rge_readahead_open(rge_readahead *ra, const char *filename, lint window) {
+    ra->fd     = open(filename, O_RDONLY);
+    ra->size   = 0;
+    ra->window = window;
+    ra->pos    = 0;
+    ra->nbytes = 0;
+    ra->uring  = false;
+    ra->stop   = false;
+    if (ra->fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(ra->fd, &st) == 0) ra->size = st.st_size;
+    posix_fadvise(ra->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    ra->buf.resize(static_cast<luint>(RGE_READAHEADDEPTH) * RGE_READAHEADCHUNK);
+    ra->worker = std::thread(run_readahead, ra);
+
+    return 0;
+}
+
+int rge_readahead_update(rge_readahead *ra, double fraction) {
+    lint pos = static_cast<lint>(fraction * static_cast<double>(ra->size));
+    if (pos > ra->pos) ra->pos = pos;
+    return 0;
+}
+
+int rge_readahead_close(rge_readahead *ra) {
+    if (ra->fd < 0) return 0;
+
+    {
+        std::lock_guard<std::mutex> lk(ra->lock);
+        ra->stop = true;
+        ra->cv.notify_all();
+    }
+    ra->worker.join();
+    close(ra->fd);
+    ra->fd = -1;
+    ra->buf.clear();
+    ra->buf.shrink_to_fit();
+
+    return 0;
+}
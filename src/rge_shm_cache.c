@@ -0,0 +1,195 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#include "../lib/rge_shm_cache.h"
+
+// --+ internal +---------------------------------------------------------------
+/** Segments attached by this process, as (start, size) pairs. */
+static std::vector<std::pair<const char *, luint>> attached;
+
+int get_segment_name(
+        const char *kind, const char *filename, char *name,
+        uint64_t *src_size, int64_t *src_mtime
+) {
+    char path[PATH_MAX];
+    struct stat st;
+    if (realpath(filename, path) == NULL || stat(path, &st) != 0) return 1;
+    *src_size  = static_cast<uint64_t>(st.st_size);
+    *src_mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+            st.st_mtim.tv_nsec;
+
+    // FNV-1a hash of the path, file stats, and layout version.
+    uint64_t hash = 0xcbf29ce484222325;
+    char key[PATH_MAX + 64];
+    int key_size = snprintf(
+            key, sizeof(key), "%s|%lu|%ld|%u", path, *src_size, *src_mtime,
+            SHM_VERSION
+    );
+    for (int i = 0; i < key_size; ++i) {
+        hash ^= static_cast<unsigned char>(key[i]);
+        hash *= 0x100000001b3;
+    }
+
+    sprintf(name, "/rge_%s_%016lx", kind, hash);
+    return 0;
+}
+
+// --+ library +----------------------------------------------------------------
+bool rge_shm_enabled() {
+    return getenv("RGE_SHMCACHE") != NULL;
+}
+
+const void *rge_shm_attach(
+        const char *kind, const char *filename, luint *size
+) {
+    if (!rge_shm_enabled()) return NULL;
+
+    char name[NAME_MAX];
+    uint64_t src_size;
+    int64_t src_mtime;
+    if (get_segment_name(kind, filename, name, &src_size, &src_mtime)) {
+        return NULL;
+    }
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return NULL;
+
+    // Wait for the creator to size the segment.
+    struct stat st;
+    struct timespec start, now;
+    struct timespec nap = {0, 1000000};
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double waited = 0.;
+    while (
+            (fstat(fd, &st) != 0 ||
+            static_cast<luint>(st.st_size) < SHM_HEADERSIZE) &&
+            waited < SHM_TIMEOUT
+    ) {
+        nanosleep(&nap, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        waited = static_cast<double>(now.tv_sec - start.tv_sec) +
+                1e-9 * static_cast<double>(now.tv_nsec - start.tv_nsec);
+    }
+    // A creator that crashed before sizing the segment leaves it empty, and
+    //     it is removed so that the next process can publish it again.
+    if (waited >= SHM_TIMEOUT) {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    luint seg_size = static_cast<luint>(st.st_size);
+    void *seg = mmap(NULL, seg_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED) return NULL;
+
+    // Wait for the creator to finish writing the payload.
+    const shm_header *header = static_cast<const shm_header *>(seg);
+    while (
+            __atomic_load_n(&(header->ready), __ATOMIC_ACQUIRE) == 0 &&
+            waited < SHM_TIMEOUT
+    ) {
+        nanosleep(&nap, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        waited = static_cast<double>(now.tv_sec - start.tv_sec) +
+                1e-9 * static_cast<double>(now.tv_nsec - start.tv_nsec);
+    }
+
+    // Validate segment. A segment left unfinished by a crashed creator is
+    //     removed so that the next process can publish it again.
+    if (header->ready == 0) {
+        munmap(seg, seg_size);
+        shm_unlink(name);
+        return NULL;
+    }
+    if (
+            header->magic    != SHM_MAGIC   ||
+            header->version  != SHM_VERSION ||
+            header->src_size  != src_size   ||
+            header->src_mtime != src_mtime  ||
+            SHM_HEADERSIZE + header->size > seg_size
+    ) {
+        munmap(seg, seg_size);
+        return NULL;
+    }
+
+    const char *payload = static_cast<const char *>(seg) + SHM_HEADERSIZE;
+    attached.push_back(std::make_pair(payload, header->size));
+    *size = header->size;
+    return payload;
+}
+
+int rge_shm_publish(
+        const char *kind, const char *filename, const void *data, luint size
+) {
+    if (!rge_shm_enabled()) return 0;
+
+    char name[NAME_MAX];
+    uint64_t src_size;
+    int64_t src_mtime;
+    if (get_segment_name(kind, filename, name, &src_size, &src_mtime)) {
+        return 1;
+    }
+
+    // Only one process creates the segment.
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0444);
+    if (fd < 0) return 0;
+
+    luint seg_size = SHM_HEADERSIZE + size;
+    if (ftruncate(fd, static_cast<off_t>(seg_size)) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return 1;
+    }
+    void *seg = mmap(NULL, seg_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED) {
+        shm_unlink(name);
+        return 1;
+    }
+
+    shm_header *header = static_cast<shm_header *>(seg);
+    header->magic     = SHM_MAGIC;
+    header->version   = SHM_VERSION;
+    header->src_size  = src_size;
+    header->src_mtime = src_mtime;
+    header->size      = size;
+    memcpy(static_cast<char *>(seg) + SHM_HEADERSIZE, data, size);
+    __atomic_store_n(&(header->ready), 1, __ATOMIC_RELEASE);
+
+    munmap(seg, seg_size);
+    return 0;
+}
+
+bool rge_shm_owns(const void *ptr) {
+    const char *p = static_cast<const char *>(ptr);
+    for (luint i = 0; i < attached.size(); ++i) {
+        const char *start = attached[i].first;
+        if (start <= p && p < start + attached[i].second) return true;
+    }
+    return false;
+}
+
+int rge_shm_remove(const char *kind, const char *filename) {
+    char name[NAME_MAX];
+    uint64_t src_size;
+    int64_t src_mtime;
+    if (get_segment_name(kind, filename, name, &src_size, &src_mtime)) {
+        return 0;
+    }
+
+    shm_unlink(name);
+    return 0;
+}
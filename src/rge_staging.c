@@ -0,0 +1,259 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#include "../lib/rge_staging.h"
+
+// --+ internal +---------------------------------------------------------------
+int copy_file(const char *src, const char *dst) {
+    int in = open(src, O_RDONLY);
+    if (in < 0) return 1;
+
+    char tmp[PATH_MAX];
+    snprintf(tmp, PATH_MAX, "%s.tmp", dst);
+    int out = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        close(in);
+        return 1;
+    }
+    posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::vector<char> buf(STAGE_BUFSIZE);
+    int err = 0;
+    while (!err) {
+        ssize_t nread = read(in, buf.data(), STAGE_BUFSIZE);
+        if (nread == 0) break;
+        if (nread < 0) {
+            if (errno != EINTR) err = 1;
+            continue;
+        }
+        for (ssize_t off = 0; off < nread && !err;) {
+            ssize_t nwritten = write(
+                    out, buf.data() + off, static_cast<size_t>(nread - off)
+            );
+            if (nwritten < 0) {
+                if (errno != EINTR) err = 1;
+                continue;
+            }
+            off += nwritten;
+        }
+    }
+
+    close(in);
+    if (close(out)) err = 1;
+    if (!err && rename(tmp, dst)) err = 1;
+    if (err) unlink(tmp);
+    return err;
+}
+
+int move_file(const char *src, const char *dst) {
+    if (rename(src, dst) == 0) return 0;
+    if (errno != EXDEV) return 1;
+
+    // Different filesystems.
+    if (copy_file(src, dst)) return 1;
+    unlink(src);
+    return 0;
+}
+
+int run_copier(rge_stager *st) {
+    for (luint file_i = 0; file_i < st->src.size(); ++file_i) {
+        std::unique_lock<std::mutex> lk(st->lock);
+
+        // Inputs that are never used are never released, so skip them.
+        if (st->nuses[file_i] <= 0) {
+            st->state[file_i] = RGE_STAGERELEASED;
+            st->cv.notify_all();
+            continue;
+        }
+
+        st->cv.wait(lk, [st] { return st->stop || st->nlive < st->depth; });
+        if (st->stop) return 0;
+        ++(st->nlive);
+        lk.unlock();
+
+        int err = copy_file(
+                st->src[file_i].c_str(), st->local[file_i].c_str()
+        );
+
+        lk.lock();
+        if (err) {
+            printf(
+                    "Couldn't stage %s, reading it in place.\n",
+                    st->src[file_i].c_str()
+            );
+            --(st->nlive);
+        }
+        st->state[file_i] = err ? RGE_STAGEFAILED : RGE_STAGEREADY;
+        st->cv.notify_all();
+    }
+    return 0;
+}
+
+int run_mover(rge_stager *st) {
+    std::unique_lock<std::mutex> lk(st->lock);
+    while (true) {
+        st->cv.wait(lk, [st] { return st->stop || !st->moves.empty(); });
+        if (st->moves.empty()) return 0;
+
+        std::pair<std::string, std::string> move = st->moves.front();
+        st->moves.pop_front();
+        lk.unlock();
+
+        int err = move_file(move.first.c_str(), move.second.c_str());
+
+        lk.lock();
+        if (err) {
+            printf(
+                    "Couldn't move %s to %s.\n", move.first.c_str(),
+                    move.second.c_str()
+            );
+            st->move_failed = true;
+        }
+    }
+}
+
+// --+ library +----------------------------------------------------------------
+int rge_stager_init(
+        rge_stager *st, char **filenames, int nfiles, const lint *nuses,
+        luint depth
+) {
+    const char *scratch_dir = getenv("RGE_SCRATCH");
+    st->enabled     = scratch_dir != NULL;
+    st->depth       = depth > 0 ? depth : 1;
+    st->nlive       = 0;
+    st->noutputs    = 0;
+    st->stop        = false;
+    st->move_failed = false;
+    st->scratch_dir[0] = '\0';
+    if (st->enabled && access(scratch_dir, W_OK | X_OK)) {
+        printf(
+                "RGE_SCRATCH is not a writable directory. Staging is "
+                "disabled.\n"
+        );
+        st->enabled = false;
+    }
+    if (st->enabled) snprintf(st->scratch_dir, PATH_MAX, "%s", scratch_dir);
+
+    // Local names include the process ID and the position of the input, so
+    //     that processes and inputs sharing a basename don't collide.
+    for (int file_i = 0; file_i < nfiles; ++file_i) {
+        char base[PATH_MAX];
+        char local[PATH_MAX];
+        snprintf(base, PATH_MAX, "%s", filenames[file_i]);
+        snprintf(
+                local, PATH_MAX, "%s/rge_%d_in_%04d_%s", st->scratch_dir,
+                getpid(), file_i, basename(base)
+        );
+        st->src.push_back(filenames[file_i]);
+        st->local.push_back(local);
+        st->state.push_back(RGE_STAGEPENDING);
+        st->nuses.push_back(nuses == NULL ? 1 : nuses[file_i]);
+    }
+
+    if (st->enabled) {
+        printf("Staging files through %s.\n", st->scratch_dir);
+        st->copier = std::thread(run_copier, st);
+        st->mover  = std::thread(run_mover, st);
+    }
+
+    return 0;
+}
+
+const char *rge_stager_acquire(rge_stager *st, int file_i) {
+    luint idx = static_cast<luint>(file_i);
+    if (!st->enabled) return st->src[idx].c_str();
+
+    std::unique_lock<std::mutex> lk(st->lock);
+    st->cv.wait(lk, [st, idx] {
+        return st->state[idx] != RGE_STAGEPENDING;
+    });
+    if (st->state[idx] == RGE_STAGEREADY) return st->local[idx].c_str();
+    return st->src[idx].c_str();
+}
+
+int rge_stager_release(rge_stager *st, int file_i) {
+    luint idx = static_cast<luint>(file_i);
+    if (!st->enabled) return 0;
+
+    std::lock_guard<std::mutex> lk(st->lock);
+    if (--(st->nuses[idx]) > 0) return 0;
+    if (st->state[idx] == RGE_STAGEREADY) {
+        unlink(st->local[idx].c_str());
+        --(st->nlive);
+    }
+    st->state[idx] = RGE_STAGERELEASED;
+    st->cv.notify_all();
+
+    return 0;
+}
+
+int rge_stager_output(
+        rge_stager *st, const char *final_path, char *local_path
+) {
+    if (!st->enabled) {
+        snprintf(local_path, PATH_MAX, "%s", final_path);
+        return 0;
+    }
+
+    char base[PATH_MAX];
+    snprintf(base, PATH_MAX, "%s", final_path);
+    std::lock_guard<std::mutex> lk(st->lock);
+    snprintf(
+            local_path, PATH_MAX, "%s/rge_%d_out_%04lu_%s", st->scratch_dir,
+            getpid(), st->noutputs++, basename(base)
+    );
+
+    return 0;
+}
+
+int rge_stager_commit(
+        rge_stager *st, const char *local_path, const char *final_path
+) {
+    if (!st->enabled) return 0;
+
+    std::lock_guard<std::mutex> lk(st->lock);
+    st->moves.push_back(std::make_pair(
+            std::string(local_path), std::string(final_path)
+    ));
+    st->cv.notify_all();
+
+    return 0;
+}
+
+int rge_stager_close(rge_stager *st) {
+    if (!st->enabled) return 0;
+
+    {
+        std::lock_guard<std::mutex> lk(st->lock);
+        st->stop = true;
+        st->cv.notify_all();
+    }
+    st->copier.join();
+    st->mover.join();
+
+    // Remove inputs that were staged but never released.
+    for (luint file_i = 0; file_i < st->src.size(); ++file_i) {
+        if (st->state[file_i] == RGE_STAGEREADY) {
+            unlink(st->local[file_i].c_str());
+        }
+    }
+    st->enabled = false;
+
+    if (st->move_failed) {
+        rge_errno = RGEERR_STAGINGFAILED;
+        return 1;
+    }
+    return 0;
+}
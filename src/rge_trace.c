@@ -0,0 +1,177 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+#include "../lib/rge_trace.h"
+
+// --+ internal +---------------------------------------------------------------
+int write_buffer(rge_tracer *t) {
+    if (t->log == NULL || t->buffer.size() == 0) return 0;
+
+    std::lock_guard<std::mutex> guard(*(t->log->lock));
+    if (fwrite(
+            t->buffer.data(), sizeof(rge_tracerecord), t->buffer.size(),
+            t->log->file
+    ) != t->buffer.size()) {
+        t->log->failed = true;
+    }
+    t->buffer.clear();
+
+    return 0;
+}
+
+int push_record(rge_tracer *t, rge_tracerecord r) {
+    t->buffer.push_back(r);
+    if (t->buffer.size() >= TRACE_BUFSIZE) write_buffer(t);
+    return 0;
+}
+
+// --+ library +----------------------------------------------------------------
+int rge_tracelog_open(
+        rge_tracelog *log, const char *filename, lint every,
+        std::set<lint> *events
+) {
+    log->file = fopen(filename, "wb");
+    if (log->file == NULL) {
+        rge_errno = RGEERR_OUTPUTTRACEFAILED;
+        return 1;
+    }
+    log->lock   = new std::mutex();
+    log->every  = every;
+    log->events = *events;
+    log->failed = false;
+
+    rge_traceheader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version     = TRACE_VERSION;
+    header.record_size = sizeof(rge_tracerecord);
+    if (fwrite(&header, sizeof(header), 1, log->file) != 1) {
+        rge_errno = RGEERR_OUTPUTTRACEFAILED;
+        return 1;
+    }
+
+    return 0;
+}
+
+int rge_tracelog_close(rge_tracelog *log) {
+    if (log->file == NULL) return 0;
+    fclose(log->file);
+    delete log->lock;
+    log->file = NULL;
+    log->lock = NULL;
+
+    return 0;
+}
+
+rge_tracer rge_tracer_init(rge_tracelog *log) {
+    rge_tracer t;
+    t.log    = log;
+    t.active = false;
+    t.evn    = -1;
+    if (log != NULL) t.buffer.reserve(TRACE_BUFSIZE);
+
+    return t;
+}
+
+int rge_trace_event(rge_tracer *t, lint evn) {
+    t->evn    = evn;
+    t->active = t->log != NULL && (
+            (t->log->every > 0 && evn % t->log->every == 0) ||
+            t->log->events.count(evn) > 0
+    );
+
+    return 0;
+}
+
+int rge_trace_cut(
+        rge_tracer *t, int kind, int stage, int pindex, int sector, double p
+) {
+    if (!t->active) return 0;
+
+    rge_tracerecord r;
+    r.evn         = t->evn;
+    r.kind        = kind;
+    r.stage       = stage;
+    r.pindex      = pindex;
+    r.sector      = sector;
+    r.recon_pid   = -1;
+    r.pid         = -1;
+    r.status      = -1;
+    r.nphe_htcc   = -1;
+    r.nphe_ltcc   = -1;
+    r.p           = static_cast<float>(p);
+    r.energy_pcal = -1.f;
+    r.energy_ecin = -1.f;
+    r.energy_ecou = -1.f;
+
+    return push_record(t, r);
+}
+
+int rge_trace_pid(
+        rge_tracer *t, int stage, int pindex, int sector, double p,
+        int recon_pid, int pid, int status, double energy_pcal,
+        double energy_ecin, double energy_ecou, int nphe_htcc, int nphe_ltcc
+) {
+    if (!t->active) return 0;
+
+    rge_tracerecord r;
+    r.evn         = t->evn;
+    r.kind        = RGE_TRACEMATCH;
+    r.stage       = stage;
+    r.pindex      = pindex;
+    r.sector      = sector;
+    r.recon_pid   = recon_pid;
+    r.pid         = pid;
+    r.status      = status;
+    r.nphe_htcc   = nphe_htcc;
+    r.nphe_ltcc   = nphe_ltcc;
+    r.p           = static_cast<float>(p);
+    r.energy_pcal = static_cast<float>(energy_pcal);
+    r.energy_ecin = static_cast<float>(energy_ecin);
+    r.energy_ecou = static_cast<float>(energy_ecou);
+
+    return push_record(t, r);
+}
+
+int rge_trace_flush(rge_tracer *t) {
+    if (t->log == NULL) return 0;
+
+    write_buffer(t);
+    if (t->log->failed) {
+        rge_errno = RGEERR_OUTPUTTRACEFAILED;
+        return 1;
+    }
+
+    return 0;
+}
+
+int rge_trace_read_header(FILE *f) {
+    rge_traceheader header;
+    if (
+            fread(&header, sizeof(header), 1, f) != 1 ||
+            memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != TRACE_VERSION ||
+            header.record_size != sizeof(rge_tracerecord)
+    ) {
+        rge_errno = RGEERR_BADTRACEFILE;
+        return 1;
+    }
+
+    return 0;
+}
+
+const char *rge_trace_kind_name(int kind) {
+    if (kind < 0 || kind >= RGE_TRACENKINDS) return "unknown";
+    return TRACE_KINDNAMES[kind];
+}
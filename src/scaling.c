@@ -0,0 +1,554 @@
+// CLAS12 RG-E Analyser.
+// Copyright (C) 2022-2023 Bruno Benkel
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+// details.
+//
+// You can see a copy of the GNU Lesser Public License under the LICENSE file.
+
+// C.
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <math.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// C++.
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ROOT.
+#include <TFile.h>
+#include <TTree.h>
+
+// rge-analysis.
+#include "../lib/rge_constants.h"
+#include "../lib/rge_err_handler.h"
+#include "../lib/rge_hipo_bank.h"
+#include "../lib/rge_io_handler.h"
+#include "../lib/rge_metadata.h"
+
+static const char *USAGE_MESSAGE =
+"Usage: scaling [-hWj:n:r:w:] -- command [args ...]\n"
+" * -h         : show this message and exit.\n"
+" * -W         : run weak scaling, where the input grows proportionally to\n"
+"                the number of threads. Default is strong scaling, where the\n"
+"                total input is fixed.\n"
+" * -j maxthr  : maximum number of threads. The command is run with 1, 2, 4,\n"
+"                ... threads up to maxthr. Default is the number of cores.\n"
+" * -n nevents : number of synthetic events. In strong scaling, this is the\n"
+"                total number of events. In weak scaling, it is the number of\n"
+"                events per thread. Default is 100000.\n"
+" * -r nreps   : number of times each configuration is run. The fastest run\n"
+"                is reported. Default is 1.\n"
+" * -w workdir : location where synthetic inputs, outputs, and logs are\n"
+"                stored. Default is root_io/scaling.\n"
+" * command    : command to benchmark, followed by its arguments. In the\n"
+"                arguments, {j} is replaced by the number of threads, {w} by\n"
+"                workdir, and an argument equal to {in} by the list of input\n"
+"                files.\n\n"
+"    Run a tool with an increasing number of threads over synthetic banks\n"
+"    files, in the format produced by hipo2root, and print a table with its\n"
+"    throughput, efficiency, and resource usage. Inputs are split into one\n"
+"    file per thread in weak scaling and into maxthr files in strong scaling.\n"
+"    As a rule of thumb, a cpu/wall ratio well below the number of threads\n"
+"    together with a high number of voluntary context switches points to\n"
+"    threads waiting on I/O or locks, while a falling efficiency with a high\n"
+"    cpu/wall ratio points to serial work, like merging outputs.\n";
+
+/** Run number of synthetic files. 999xxx runs are treated as simulation. */
+static const int SYNTH_RUNNO = 999106;
+
+/** Number of banks in BANKLIST. */
+static const uint NBANKS = 6;
+
+/** List of banks written to synthetic files, in the order of hipo2root. */
+static const char *BANKLIST[NBANKS] = {
+    RGE_RECPARTICLE, RGE_RECTRACK, RGE_RECCALORIMETER, RGE_RECCHERENKOV,
+    RGE_RECSCINTILLATOR, RGE_FMTTRACKS
+};
+
+/** Positions of each bank in BANKLIST. */
+enum {PART, TRK, CAL, CHKV, SCI, FMT};
+
+/**
+ * Measurements from one run of the command.
+ *
+ * @param nthreads : number of threads used.
+ * @param nfiles   : number of input files.
+ * @param nevents  : total number of input events.
+ * @param wall     : wall time in seconds.
+ * @param cpu      : user + system CPU time in seconds.
+ * @param max_rss  : peak resident set size in MB.
+ * @param nvcsw    : number of voluntary context switches.
+ * @param blk_io   : data read from and written to block devices in MB.
+ */
+typedef struct {
+    lint nthreads, nfiles, nevents;
+    double wall, cpu, max_rss, nvcsw, blk_io;
+} scaling_run;
+
+/** Append value val to entry key of bank b. */
+static int push(rge_hipobank *b, const char *key, double val) {
+    b->entries.at(key).data->push_back(val);
+    return 0;
+}
+
+/**
+ * Generate one synthetic event. Each event has a trigger electron and up to six
+ *     other particles, with their tracks, calorimeter, Cherenkov, scintillator,
+ *     and FMT hits. Values are rough approximations to CLAS12 data, intended
+ *     only to exercise the same code paths as real events.
+ *
+ * @param banks : array of NBANKS rge_hipobanks, ordered as BANKLIST.
+ * @param rng   : random number generator.
+ * @return      : error code. Always 0.
+ */
+static int fill_synthetic_event(rge_hipobank banks[], std::mt19937 *rng) {
+    static const int HADRON_PIDS[]    = {211, -211, 2212, 22, 2112, 321};
+    static const int HADRON_CHARGES[] = {  1,   -1,    1,  0,    0,   1};
+    std::uniform_real_distribution<double> u(0., 1.);
+    std::uniform_int_distribution<int> npart_dist(1, 7);
+    std::uniform_int_distribution<int> hadron_dist(0, 5);
+    std::uniform_int_distribution<int> sector_dist(1, 6);
+
+    // Clear banks.
+    std::map<const char *, rge_hipoentry, cmp_str>::iterator entry_it;
+    for (uint bi = 0; bi < NBANKS; ++bi) {
+        for (
+                entry_it = banks[bi].entries.begin();
+                entry_it != banks[bi].entries.end(); ++entry_it
+        ) {
+            entry_it->second.data->clear();
+        }
+    }
+
+    int npart = npart_dist(*rng);
+    int ntrk  = 0;
+    double vz = -7. + 2.*u(*rng);
+    for (int pindex = 0; pindex < npart; ++pindex) {
+        // Particle. The first one is always the trigger electron.
+        int hi     = hadron_dist(*rng);
+        int pid    = pindex == 0 ? 11   : HADRON_PIDS[hi];
+        int charge = pindex == 0 ? -1   : HADRON_CHARGES[hi];
+        int status = pindex == 0 ? -2110 : 2110;
+        double p   = pindex == 0 ? 2. + 7.*u(*rng) : .5 + 4.*u(*rng);
+        double th  = (5. + 30.*u(*rng)) * M_PI / 180.;
+        double ph  = (-180. + 360.*u(*rng)) * M_PI / 180.;
+        double px  = p * sin(th) * cos(ph);
+        double py  = p * sin(th) * sin(ph);
+        double pz  = p * cos(th);
+
+        rge_hipobank *b = &(banks[PART]);
+        push(b, "pid",     pid);
+        push(b, "vx",      .1*u(*rng) - .05);
+        push(b, "vy",      .1*u(*rng) - .05);
+        push(b, "vz",      vz + .2*u(*rng) - .1);
+        push(b, "px",      px);
+        push(b, "py",      py);
+        push(b, "pz",      pz);
+        push(b, "vt",      20.*u(*rng));
+        push(b, "charge",  charge);
+        push(b, "beta",    pid == 2112 ? .5 + .3*u(*rng) : .9 + .1*u(*rng));
+        push(b, "chi2pid", 4.*u(*rng) - 2.);
+        push(b, "status",  status);
+
+        if (charge == 0) continue;
+
+        // Track and FMT track.
+        int sector = sector_dist(*rng);
+        b = &(banks[TRK]);
+        push(b, "index",  ntrk);
+        push(b, "pindex", pindex);
+        push(b, "sector", sector);
+        push(b, "NDF",    10 + static_cast<int>(20*u(*rng)));
+        push(b, "chi2",   50.*u(*rng));
+
+        b = &(banks[FMT]);
+        push(b, "index",  ntrk);
+        push(b, "NDF",    2 + static_cast<int>(2*u(*rng)));
+        push(b, "Vtx0_x", .1*u(*rng) - .05);
+        push(b, "Vtx0_y", .1*u(*rng) - .05);
+        push(b, "Vtx0_z", vz);
+        push(b, "p0_x",   px);
+        push(b, "p0_y",   py);
+        push(b, "p0_z",   pz);
+        ++ntrk;
+
+        // Calorimeter. Electrons shower through all layers.
+        int layers[3] = {PCAL_LYR, ECIN_LYR, ECOU_LYR};
+        double fractions[3] = {.15, .08, .02};
+        int nlayers = pindex == 0 ? 3 : 1;
+        for (int li = 0; li < nlayers; ++li) {
+            b = &(banks[CAL]);
+            push(b, "pindex", pindex);
+            push(b, "layer",  layers[li]);
+            push(b, "sector", sector);
+            push(b, "energy", p * fractions[li] * (.8 + .4*u(*rng)));
+            push(b, "time",   25. + 5.*u(*rng));
+            push(b, "lu",     400.*u(*rng));
+            push(b, "lv",     400.*u(*rng));
+            push(b, "lw",     400.*u(*rng));
+        }
+
+        // Cherenkov.
+        b = &(banks[CHKV]);
+        push(b, "pindex",   pindex);
+        push(b, "detector", pindex == 0 ? 15 : 16);
+        push(b, "nphe",     pindex == 0 ? 5. + 20.*u(*rng) : 3.*u(*rng));
+
+        // Scintillator, FTOF 1B.
+        b = &(banks[SCI]);
+        push(b, "pindex",   pindex);
+        push(b, "time",     20. + 5.*u(*rng));
+        push(b, "detector", 12);
+        push(b, "layer",    2);
+    }
+
+    // Set number of rows.
+    for (uint bi = 0; bi < NBANKS; ++bi) {
+        banks[bi].nrows = banks[bi].entries.begin()->second.data->size();
+    }
+
+    return 0;
+}
+
+/**
+ * Write a synthetic banks file with the same structure as hipo2root's output.
+ *
+ * @param filename : name of the output file.
+ * @param nevents  : number of events to write.
+ * @param seed     : seed of the random number generator.
+ * @return         : error code. 0 if successful, 1 otherwise.
+ */
+static int write_synthetic_file(const char *filename, lint nevents, uint seed) {
+    TFile *file = TFile::Open(filename, "RECREATE");
+    if (!file || file->IsZombie()) {
+        rge_errno = RGEERR_OUTPUTROOTFAILED;
+        return 1;
+    }
+    TTree *tree = new TTree(RGE_TREENAMEDATA, RGE_TREENAMEDATA);
+
+    rge_hipobank banks[NBANKS];
+    for (uint bi = 0; bi < NBANKS; ++bi) {
+        banks[bi] = rge_hipobank_init(BANKLIST[bi]);
+        if (rge_errno != RGEERR_UNDEFINED) return 1;
+
+        std::map<const char *, rge_hipoentry, cmp_str>::iterator entry_it;
+        for (
+                entry_it = banks[bi].entries.begin();
+                entry_it != banks[bi].entries.end(); ++entry_it
+        ) {
+            entry_it->second.data = new std::vector<double>();
+        }
+        rge_link_branches(&(banks[bi]), tree);
+    }
+
+    std::mt19937 rng(seed);
+    for (lint evn = 0; evn < nevents; ++evn) {
+        fill_synthetic_event(banks, &rng);
+        tree->Fill();
+    }
+
+    tree->Write();
+    std::set<int> runs = {SYNTH_RUNNO};
+    rge_write_runlist(file, &runs);
+    file->Close();
+
+    // Clean up.
+    for (uint bi = 0; bi < NBANKS; ++bi) {
+        std::map<const char *, rge_hipoentry, cmp_str>::iterator entry_it;
+        for (
+                entry_it = banks[bi].entries.begin();
+                entry_it != banks[bi].entries.end(); ++entry_it
+        ) {
+            delete entry_it->second.data;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Get the list of synthetic input files for a run, generating the ones that
+ *     don't exist yet. Files are named after the number of events they hold and
+ *     their position in the list, so they are reused across runs.
+ *
+ * @param work_dir  : directory where files are stored.
+ * @param nfiles    : number of files.
+ * @param nevents   : number of events in each file.
+ * @param filenames : vector where the filenames are written.
+ * @return          : error code. 0 if successful, 1 otherwise.
+ */
+static int get_inputs(
+        char *work_dir, lint nfiles, lint nevents,
+        std::vector<std::string> *filenames
+) {
+    filenames->clear();
+    for (lint file_i = 0; file_i < nfiles; ++file_i) {
+        char filename[PATH_MAX];
+        sprintf(
+                filename, "%s/synth%ld_%03ld_%06d.root", work_dir, nevents,
+                file_i, SYNTH_RUNNO
+        );
+        if (access(filename, F_OK) != 0) {
+            printf("Generating %s.\n", filename);
+            if (write_synthetic_file(
+                    filename, nevents, static_cast<uint>(file_i)
+            )) return 1;
+        }
+        filenames->push_back(filename);
+    }
+
+    return 0;
+}
+
+/**
+ * Run the command once, substituting the placeholders in its arguments, and
+ *     measure its resource usage. The command's stdout and stderr are written
+ *     to a log file in work_dir.
+ *
+ * @param cmd       : command and its arguments.
+ * @param work_dir  : directory where the log is written.
+ * @param filenames : list of input files, substituted for {in}.
+ * @param run       : pointer to the scaling_run to be filled.
+ * @return          : error code. 0 if successful, 1 otherwise.
+ */
+static int run_command(
+        std::vector<std::string> *cmd, char *work_dir,
+        std::vector<std::string> *filenames, scaling_run *run
+) {
+    // Substitute placeholders.
+    std::vector<std::string> args;
+    for (luint ai = 0; ai < cmd->size(); ++ai) {
+        std::string arg = cmd->at(ai);
+        if (arg == "{in}") {
+            args.insert(args.end(), filenames->begin(), filenames->end());
+            continue;
+        }
+        size_t pos;
+        while ((pos = arg.find("{j}")) != std::string::npos) {
+            arg.replace(pos, 3, std::to_string(run->nthreads));
+        }
+        while ((pos = arg.find("{w}")) != std::string::npos) {
+            arg.replace(pos, 3, work_dir);
+        }
+        args.push_back(arg);
+    }
+    std::vector<char *> argv_child;
+    for (luint ai = 0; ai < args.size(); ++ai) {
+        argv_child.push_back(const_cast<char *>(args[ai].c_str()));
+    }
+    argv_child.push_back(NULL);
+
+    char log_filename[PATH_MAX];
+    sprintf(log_filename, "%s/scaling_j%03ld.log", work_dir, run->nthreads);
+
+    // Run.
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int fd = open(log_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        execvp(argv_child[0], argv_child.data());
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    if (pid < 0 || wait4(pid, &status, 0, &usage) < 0) {
+        rge_errno = RGEERR_COMMANDFAILED;
+        return 1;
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "Command failed. Check %s.\n", log_filename);
+        rge_errno = RGEERR_COMMANDFAILED;
+        return 1;
+    }
+
+    // Get measurements.
+    run->wall = std::chrono::duration<double>(end - start).count();
+    run->cpu  =
+            static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+            static_cast<double>(usage.ru_utime.tv_usec+usage.ru_stime.tv_usec) *
+            1e-6;
+    run->max_rss = static_cast<double>(usage.ru_maxrss) / 1024.;
+    run->nvcsw   = static_cast<double>(usage.ru_nvcsw);
+    run->blk_io  =
+            static_cast<double>(usage.ru_inblock + usage.ru_oublock) * 512. /
+            (1024.*1024.);
+
+    return 0;
+}
+
+/** run() function of the program. Check USAGE_MESSAGE for details. */
+static int run(
+        std::vector<std::string> *cmd, char *work_dir, bool weak,
+        lint max_threads, lint nevents, lint nreps
+) {
+    if (mkdir(work_dir, 0755) != 0 && errno != EEXIST) {
+        rge_errno = RGEERR_OUTPUTROOTFAILED;
+        return 1;
+    }
+
+    // Get list of thread counts.
+    std::vector<lint> thread_counts;
+    for (lint nthreads = 1; nthreads < max_threads; nthreads *= 2) {
+        thread_counts.push_back(nthreads);
+    }
+    thread_counts.push_back(max_threads);
+
+    // Run command for each thread count.
+    std::vector<scaling_run> runs;
+    for (luint ti = 0; ti < thread_counts.size(); ++ti) {
+        scaling_run best;
+        best.nthreads = thread_counts[ti];
+        best.nfiles   = weak ? best.nthreads : max_threads;
+        lint nevents_file = weak ? nevents : nevents / max_threads;
+        best.nevents  = best.nfiles * nevents_file;
+
+        std::vector<std::string> filenames;
+        if (get_inputs(work_dir, best.nfiles, nevents_file, &filenames)) {
+            return 1;
+        }
+
+        printf("Running with %ld threads.\n", best.nthreads);
+        best.wall = INFINITY;
+        for (lint rep = 0; rep < nreps; ++rep) {
+            scaling_run current = best;
+            if (run_command(cmd, work_dir, &filenames, &current)) return 1;
+            if (current.wall < best.wall) best = current;
+        }
+        runs.push_back(best);
+    }
+
+    // Print table.
+    printf(
+            "\n%s scaling of %s.\n", weak ? "Weak" : "Strong",
+            cmd->at(0).c_str()
+    );
+    printf(
+            "%7s %5s %9s %9s %8s %10s %7s %6s %9s %9s %9s\n",
+            "threads", "files", "events", "wall[s]", "cpu/wall", "events/s",
+            "speedup", "eff", "rss[MB]", "vcsw/s", "blkio[MB]"
+    );
+    double base_throughput = runs[0].nevents / runs[0].wall;
+    for (luint ri = 0; ri < runs.size(); ++ri) {
+        scaling_run *r = &(runs[ri]);
+        double throughput = r->nevents / r->wall;
+        double speedup    = throughput / base_throughput;
+        printf(
+                "%7ld %5ld %9ld %9.3f %8.2f %10.1f %7.2f %6.2f %9.1f %9.1f "
+                "%9.1f\n",
+                r->nthreads, r->nfiles, r->nevents, r->wall, r->cpu / r->wall,
+                throughput, speedup, speedup / r->nthreads, r->max_rss,
+                r->nvcsw / r->wall, r->blk_io
+        );
+    }
+
+    rge_errno = RGEERR_NOERR;
+    return 0;
+}
+
+/** Handle arguments for scaling using optarg. */
+static int handle_args(
+        int argc, char **argv, std::vector<std::string> *cmd, char **work_dir,
+        bool *weak, lint *max_threads, lint *nevents, lint *nreps
+) {
+    // Handle arguments.
+    int opt;
+    while ((opt = getopt(argc, argv, "+hWj:n:r:w:")) != -1) {
+        switch (opt) {
+            case 'h':
+                rge_errno = RGEERR_USAGE;
+                return 1;
+            case 'W':
+                *weak = true;
+                break;
+            case 'j':
+                if (rge_process_nthreads(max_threads, optarg)) return 1;
+                break;
+            case 'n':
+                if (rge_process_nentries(nevents, optarg)) return 1;
+                break;
+            case 'r':
+                if (rge_process_nreps(nreps, optarg)) return 1;
+                break;
+            case 'w':
+                rge_grab_string(optarg, work_dir);
+                break;
+            default:
+                rge_errno = RGEERR_BADOPTARGS;
+                return 1;
+        }
+    }
+
+    // Everything after the options is the command.
+    for (int ai = optind; ai < argc; ++ai) cmd->push_back(argv[ai]);
+    if (cmd->empty()) {
+        rge_errno = RGEERR_NOCOMMAND;
+        return 1;
+    }
+
+    // Define workdir if undefined.
+    if (*work_dir == NULL) {
+        *work_dir = static_cast<char *>(malloc(PATH_MAX));
+        sprintf(*work_dir, "%s/../root_io/scaling", dirname(argv[0]));
+    }
+
+    // Define number of threads if undefined.
+    if (*max_threads == -1) {
+        *max_threads = static_cast<lint>(std::thread::hardware_concurrency());
+        if (*max_threads < 1) *max_threads = 1;
+    }
+
+    // Each thread needs at least one event in strong scaling.
+    if (*nevents < *max_threads) *nevents = *max_threads;
+
+    return 0;
+}
+
+/** Entry point of the program. */
+int main(int argc, char **argv) {
+    // Handle arguments.
+    std::vector<std::string> cmd;
+    char *work_dir   = NULL;
+    bool weak        = false;
+    lint max_threads = -1;
+    lint nevents     = 100000;
+    lint nreps       = 1;
+
+    int err = handle_args(
+            argc, argv, &cmd, &work_dir, &weak, &max_threads, &nevents, &nreps
+    );
+
+    // Run.
+    if (rge_errno == RGEERR_UNDEFINED && err == 0) {
+        run(&cmd, work_dir, weak, max_threads, nevents, nreps);
+    }
+
+    // Free up memory.
+    if (work_dir != NULL) free(work_dir);
+
+    // Return errcode.
+    return rge_print_usage(USAGE_MESSAGE);
+}